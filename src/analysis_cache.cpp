@@ -0,0 +1,256 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "analysis_cache.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "trace.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+const char SIDECAR_MAGIC[8] = {'S', 'S', 'A', 'N', 'L', 'Y', 'S', '1'};
+const size_t SIDECAR_DATA_OFFSET = 64;      // the bins start on a cache line
+
+// first bytes of a sidecar file, in host order: a sidecar is not meant to move between machines
+struct SidecarHeader {
+    char magic[8];
+    uint32_t complete;
+    uint32_t reserved;
+    int64_t frames;
+    int64_t channels;
+    double sample_rate;
+    int32_t fft_size;
+    int32_t hop;
+    uint64_t checksum;
+};
+
+static_assert(sizeof(SidecarHeader) <= SIDECAR_DATA_OFFSET, "sidecar header larger than its room");
+
+SidecarHeader makeHeader(const AnalysisKey& key){
+    SidecarHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, SIDECAR_MAGIC, sizeof(SIDECAR_MAGIC));
+    header.frames = key.frames;
+    header.channels = key.channels;
+    header.sample_rate = key.sample_rate;
+    header.fft_size = key.layout.fft_size;
+    header.hop = key.layout.hop;
+    header.checksum = key.checksum;
+    return header;
+}
+
+}
+
+// ----- AnalysisKey
+
+uint64_t AnalysisKey::contentsChecksum(const PlanarSnapshot& source){
+    uint64_t hash = 14695981039346656037ULL;
+    for(long c = 0; c < source.channels(); ++c){
+        const REAL* channel = source.channel(c);
+        for(long i = 0; i < source.frames(); ++i){
+            uint32_t bits;
+            std::memcpy(&bits, channel + i, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+std::string AnalysisKey::sidecarName(const std::string& name) const {
+    std::string safe = name.empty() ? std::string("buffer") : name;
+    for(char& c : safe){
+        if(!((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '-' || c == '_'))
+            c = '_';
+    }
+    char suffix[64];
+    std::snprintf(suffix, sizeof(suffix), "-%016llx-%d-%d.ssa", (unsigned long long)checksum, layout.fft_size, layout.hop);
+    return safe + suffix;
+}
+
+// ----- SpectralAnalysis
+
+std::unique_ptr<SpectralAnalysis> SpectralAnalysis::create(const AnalysisKey& key, const std::string& sidecar, std::string& error){
+    if(key.layout.fft_size <= 0 || key.layout.hop <= 0 || key.channels <= 0 || key.frames <= 0){
+        error = "nothing to analyse";
+        return nullptr;
+    }
+    std::unique_ptr<SpectralAnalysis> analysis(new SpectralAnalysis());
+    analysis->analysis_key = key;
+    analysis->num_frames = key.frames / key.layout.hop + 1;
+    const size_t bins = analysis->frame_bytes() / sizeof(SpectralBin) * (size_t)analysis->num_frames;
+    if(sidecar.empty()){
+        analysis->memory.assign(bins, SpectralBin{0.0f, 0.0f});
+        analysis->bins = analysis->memory.data();
+        return analysis;
+    }
+    
+    const size_t size = SIDECAR_DATA_OFFSET + analysis->bytes();
+    bool reuse = false;
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(sidecar.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(handle == INVALID_HANDLE_VALUE){
+        error = "cannot open the sidecar file";
+        return nullptr;
+    }
+    analysis->file_handle = handle;
+    LARGE_INTEGER existing;
+    reuse = GetFileSizeEx(handle, &existing) && (size_t)existing.QuadPart == size;
+    // the mapping grows (or keeps) the file to its size
+    analysis->mapping_handle = CreateFileMappingA(handle, nullptr, PAGE_READWRITE, (DWORD)((uint64_t)size >> 32), (DWORD)(size & 0xFFFFFFFF), nullptr);
+    if(!analysis->mapping_handle){
+        error = "cannot map the sidecar file";
+        return nullptr;
+    }
+    analysis->mapped = (unsigned char*)MapViewOfFile(analysis->mapping_handle, FILE_MAP_ALL_ACCESS, 0, 0, size);
+#else
+    analysis->fd = ::open(sidecar.c_str(), O_RDWR | O_CREAT, 0644);
+    if(analysis->fd < 0){
+        error = "cannot open the sidecar file";
+        return nullptr;
+    }
+    struct stat info;
+    reuse = fstat(analysis->fd, &info) == 0 && (size_t)info.st_size == size;
+    if(!reuse && ftruncate(analysis->fd, (off_t)size) != 0){
+        error = "cannot resize the sidecar file";
+        return nullptr;
+    }
+    void* address = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, analysis->fd, 0);
+    analysis->mapped = address == MAP_FAILED ? nullptr : (unsigned char*)address;
+#endif
+    if(!analysis->mapped){
+        error = "cannot map the sidecar file";
+        return nullptr;
+    }
+    analysis->mapped_bytes = size;
+    analysis->bins = (SpectralBin*)(analysis->mapped + SIDECAR_DATA_OFFSET);
+    
+    // a complete analysis of the same source and layout: nothing to compute
+    const SidecarHeader expected = makeHeader(key);
+    SidecarHeader found;
+    std::memcpy(&found, analysis->mapped, sizeof(found));
+    if(reuse && found.complete == 1){
+        found.complete = 0;
+        analysis->is_complete = std::memcmp(&found, &expected, sizeof(found)) == 0;
+    }
+    if(!analysis->is_complete)
+        std::memcpy(analysis->mapped, &expected, sizeof(expected));
+    return analysis;
+}
+
+SpectralAnalysis::~SpectralAnalysis(){
+#if defined(_WIN32)
+    if(mapped)
+        UnmapViewOfFile(mapped);
+    if(mapping_handle)
+        CloseHandle(mapping_handle);
+    if(file_handle)
+        CloseHandle(file_handle);
+#else
+    if(mapped)
+        munmap(mapped, mapped_bytes);
+    if(fd >= 0)
+        close(fd);
+#endif
+}
+
+void SpectralAnalysis::analyse(SpectralAnalyser& analyser, const PlanarSnapshot& source, long first, long last, std::vector<std::vector<REAL>>& scratch){
+    const SpectralLayout& layout = analysis_key.layout;
+    const long channels = std::min(analysis_key.channels, source.channels());
+    REAL* input[MAX_BUFFER_CHANNEL];
+    for(long c = 0; c < channels; ++c)
+        input[c] = scratch[c].data();
+    for(long index = std::max(first, 0L); index < std::min(last, num_frames); ++index){
+        source.copy(input, index * layout.hop - layout.fft_size / 2, layout.fft_size);
+        for(long c = 0; c < channels; ++c)
+            analyser.analyse(input[c], (SpectralBin*)frame(index, c));
+    }
+}
+
+void SpectralAnalysis::finish(){
+    if(mapped){
+        // the bins reach the disk before the header says they are complete
+#if defined(_WIN32)
+        FlushViewOfFile(mapped, mapped_bytes);
+#else
+        msync(mapped, mapped_bytes, MS_SYNC);
+#endif
+        SidecarHeader header = makeHeader(analysis_key);
+        header.complete = 1;
+        std::memcpy(mapped, &header, sizeof(header));
+#if defined(_WIN32)
+        FlushViewOfFile(mapped, sizeof(header));
+#else
+        msync(mapped, sizeof(header), MS_ASYNC);
+#endif
+    }
+    is_complete = true;
+}
+
+// ----- AnalysisBuild
+
+AnalysisBuild::AnalysisBuild(std::shared_ptr<const PlanarSnapshot> source, std::shared_ptr<SpectralAnalysis> analysis, unsigned long generation)
+: source(std::move(source)), target(std::move(analysis)), build_generation(generation) {
+    num_slices = (target->frames() + ANALYSIS_SLICE_FRAMES - 1) / ANALYSIS_SLICE_FRAMES;
+}
+
+AnalysisBuild::Slice AnalysisBuild::runSlice(){
+    if(stopped)
+        return None;
+    const long slice = next_slice.fetch_add(1);
+    if(slice >= num_slices)
+        return None;
+    TRACE_SCOPE("analysis", this);
+    
+    // per thread: the pool threads analyse slices of any build
+    thread_local SpectralAnalyser analyser;
+    thread_local std::vector<std::vector<REAL>> scratch;
+    const AnalysisKey& key = target->key();
+    analyser.setLayout(key.layout);
+    if(scratch.size() < (size_t)key.channels)
+        scratch.resize((size_t)key.channels);
+    for(long c = 0; c < key.channels; ++c)
+        scratch[c].resize((size_t)key.layout.fft_size);
+    
+    const long first = slice * ANALYSIS_SLICE_FRAMES;
+    target->analyse(analyser, *source, first, first + ANALYSIS_SLICE_FRAMES, scratch);
+    if(done_slices.fetch_add(1) + 1 == num_slices && !stopped){
+        target->finish();
+        return Completed;
+    }
+    return Analysed;
+}
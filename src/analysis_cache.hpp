@@ -0,0 +1,199 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef analysis_cache_hpp
+#define analysis_cache_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "common.h"
+#include "planar_mirror.hpp"
+#include "spectral.hpp"
+
+/**
+ What an analysis was computed from: the source contents and the layout of the mode.
+ */
+struct AnalysisKey {
+    long frames = 0;
+    long channels = 0;
+    double sample_rate = 0;
+    SpectralLayout layout;
+    uint64_t checksum = 0;      // of the samples, see contentsChecksum
+
+    bool operator==(const AnalysisKey& other) const {
+        return frames == other.frames && channels == other.channels && sample_rate == other.sample_rate
+            && layout == other.layout && checksum == other.checksum;
+    }
+
+    // FNV-1a of the sample bits of every channel
+    static uint64_t contentsChecksum(const PlanarSnapshot& source);
+
+    // sidecar file of a source named `name`: <name>-<checksum>-<fft size>-<hop>.ssa
+    std::string sidecarName(const std::string& name) const;
+};
+
+/**
+ STFT frames of a whole source (see SpectralLayout), frame k centered on sample k * hop.
+
+ Held in memory, or in a sidecar file mapped in memory: a complete sidecar with the same key is reused as is,
+ anything else is recomputed in place. Filled by analyse() on any number of threads (disjoint frames),
+ then read-only once finish() has been called.
+ */
+class SpectralAnalysis {
+public:
+    /**
+     - Parameters:
+     - key: source and layout analysed
+     - sidecar: native path of the sidecar file, empty: in memory
+     - error: reason of the failure
+     - Returns: nullptr if the sidecar cannot be created
+     */
+    static std::unique_ptr<SpectralAnalysis> create(const AnalysisKey& key, const std::string& sidecar, std::string& error);
+
+    ~SpectralAnalysis();
+    SpectralAnalysis(const SpectralAnalysis&) = delete;
+    SpectralAnalysis& operator=(const SpectralAnalysis&) = delete;
+
+    const AnalysisKey& key() const { return analysis_key; }
+    long frames() const { return num_frames; }
+    bool complete() const { return is_complete; }
+    bool persistent() const { return mapped_bytes > 0; }   // backed by a sidecar file
+    size_t bytes() const { return frame_bytes() * (size_t)num_frames; }
+
+    // bins of a frame, nullptr outside of the source
+    const SpectralBin* frame(long index, long channel) const {
+        if(index < 0 || index >= num_frames || channel < 0 || channel >= analysis_key.channels)
+            return nullptr;
+        return bins + ((size_t)index * (size_t)analysis_key.channels + (size_t)channel) * (size_t)analysis_key.layout.bins();
+    }
+
+    /**
+     Analyse the frames [first, last[ of `source`.
+     - Parameters:
+     - analyser: set to the layout of the key
+     - scratch: fft_size samples per channel
+     */
+    void analyse(SpectralAnalyser& analyser, const PlanarSnapshot& source, long first, long last, std::vector<std::vector<REAL>>& scratch);
+
+    // every frame has been analysed: mark the sidecar complete and write it back
+    void finish();
+
+private:
+    SpectralAnalysis() = default;
+    size_t frame_bytes() const { return sizeof(SpectralBin) * (size_t)analysis_key.layout.bins() * (size_t)analysis_key.channels; }
+
+    AnalysisKey analysis_key;
+    long num_frames = 0;
+    bool is_complete = false;
+    SpectralBin* bins = nullptr;
+    std::vector<SpectralBin> memory;    // without sidecar
+
+    unsigned char* mapped = nullptr;
+    size_t mapped_bytes = 0;
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+};
+
+/**
+ Analysis of a snapshot split in slices of ANALYSIS_SLICE_FRAMES frames, claimed by any number of threads:
+ each pool job analyses one slice per run, so the renders queued meanwhile are not held back.
+ */
+class AnalysisBuild {
+public:
+    enum Slice { None, Analysed, Completed };
+
+    AnalysisBuild(std::shared_ptr<const PlanarSnapshot> source, std::shared_ptr<SpectralAnalysis> analysis, unsigned long generation);
+
+    /**
+     Analyse the next slice nobody has claimed yet.
+     - Returns: None if every slice has been claimed (or the build cancelled),
+       Completed for the slice completing the analysis (which is then finished)
+     */
+    Slice runSlice();
+
+    void cancel(){ stopped = true; }
+    bool cancelled() const { return stopped; }
+    double progress() const { return num_slices > 0 ? (double)done_slices.load() / (double)num_slices : 1.0; }
+    unsigned long generation() const { return build_generation; }
+    const std::shared_ptr<SpectralAnalysis>& analysis() const { return target; }
+
+private:
+    std::shared_ptr<const PlanarSnapshot> source;
+    std::shared_ptr<SpectralAnalysis> target;
+    const unsigned long build_generation;
+    long num_slices = 0;
+    std::atomic<long> next_slice{0};
+    std::atomic<long> done_slices{0};
+    std::atomic_bool stopped{false};
+};
+
+/**
+ Latest complete analysis of the source, published like the planar mirror (see PlanarMirror):
+ the worker keeps the analysis it acquired for its render, an invalidation only drops the published one.
+ */
+class AnalysisCache {
+public:
+    std::shared_ptr<const SpectralAnalysis> acquire() const {
+        return std::atomic_load(&analysis);
+    }
+
+    // - Returns: the generation a new analysis must be built for
+    unsigned long invalidate(){
+        std::lock_guard<std::mutex> lock(mutex);
+        std::atomic_store(&analysis, std::shared_ptr<const SpectralAnalysis>());
+        return ++current_generation;
+    }
+
+    unsigned long generation() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current_generation;
+    }
+
+    // - Returns: false (analysis dropped) if invalidated since `generation`
+    bool publish(unsigned long generation, std::shared_ptr<const SpectralAnalysis> built){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(generation != current_generation)
+            return false;
+        std::atomic_store(&analysis, std::move(built));
+        return true;
+    }
+
+private:
+    mutable std::mutex mutex;
+    unsigned long current_generation = 0;
+    std::shared_ptr<const SpectralAnalysis> analysis;
+};
+
+#endif /* analysis_cache_hpp */
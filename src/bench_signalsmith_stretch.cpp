@@ -0,0 +1,661 @@
+#include <benchmark/benchmark.h>
+#include "analysis_cache.hpp"
+#include "deinterleave.hpp"
+#include "resampler.hpp"
+#include "render_stats.hpp"
+#include "ringbuffer.hpp"
+#include "semaphore.hpp"
+#include "simd.hpp"
+#include "stretch_modes.hpp"
+#include "trace.hpp"
+#include "worker_pool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+// ----- wakeup
+
+// signal with nobody waiting: the audio thread fast path
+static void BM_SemaphoreSignalNoWaiter(benchmark::State& state){
+    Semaphore semaphore;
+    for(auto _ : state){
+        semaphore.signal();
+        benchmark::DoNotOptimize(semaphore.tryWait());
+    }
+    state.counters["syscalls_per_signal"] = benchmark::Counter((double)semaphore.syscalls() / (double)state.iterations());
+}
+BENCHMARK(BM_SemaphoreSignalNoWaiter);
+
+// round trip between two threads sleeping on each other
+template<class Sem>
+static void pingPong(benchmark::State& state, Sem& ping, Sem& pong){
+    std::atomic_bool stop{false};
+    std::thread other([&](){
+        while(true){
+            ping.wait();
+            if(stop)
+                break;
+            pong.signal();
+        }
+    });
+    for(auto _ : state){
+        ping.signal();
+        pong.wait();
+    }
+    stop = true;
+    ping.signal();
+    other.join();
+}
+
+static void BM_SemaphoreWakeupLatency(benchmark::State& state){
+    Semaphore ping, pong;
+    pingPong(state, ping, pong);
+    state.counters["syscalls_per_signal"] = benchmark::Counter((double)(ping.syscalls() + pong.syscalls()) / (2.0 * (double)state.iterations()));
+}
+BENCHMARK(BM_SemaphoreWakeupLatency)->UseRealTime();
+
+static void BM_OsSemaphoreWakeupLatency(benchmark::State& state){
+    OsSemaphore ping, pong;
+    pingPong(state, ping, pong);
+}
+BENCHMARK(BM_OsSemaphoreWakeupLatency)->UseRealTime();
+
+// time from WorkerPool::submit to the job running on an idle pool
+static void BM_WorkerPoolSubmitLatency(benchmark::State& state){
+    WorkerPool pool((size_t)state.range(0));
+    std::atomic_bool ran{false};
+    PoolJob job([&](){ ran.store(true, std::memory_order_release); });
+    pool.add(&job);
+    unsigned long long syscalls = pool.wakeupSyscalls();
+    for(auto _ : state){
+        ran = false;
+        pool.submit(&job);
+        while(!ran.load(std::memory_order_acquire))
+            ;
+    }
+    pool.remove(&job);
+    state.counters["syscalls_per_submit"] = benchmark::Counter((double)(pool.wakeupSyscalls() - syscalls) / (double)state.iterations());
+}
+BENCHMARK(BM_WorkerPoolSubmitLatency)->Arg(1)->Arg(4)->UseRealTime();
+
+// ----- perform64 output kernels
+
+// range(0): vector size, range(1): index in getAvailableSimdKernels()
+
+static const SimdKernels* benchKernels(benchmark::State& state){
+    std::vector<const SimdKernels*> kernels = getAvailableSimdKernels();
+    if((size_t)state.range(1) >= kernels.size()){
+        state.SkipWithError("not supported by this CPU");
+        return nullptr;
+    }
+    state.SetLabel(kernels[state.range(1)]->name);
+    return kernels[state.range(1)];
+}
+
+// reference: the former per-sample loop
+static void BM_ConvertLoop(benchmark::State& state){
+    std::vector<float> input(state.range(0), 0.5f);
+    std::vector<double> output(state.range(0));
+    for(auto _ : state){
+        for(size_t i = 0; i < input.size(); ++i)
+            output[i] = input[i];
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_ConvertLoop)->Arg(64)->Arg(512);
+
+static void BM_Convert(benchmark::State& state){
+    const SimdKernels* kernels = benchKernels(state);
+    if(!kernels)
+        return;
+    std::vector<float> input(state.range(0), 0.5f);
+    std::vector<double> output(state.range(0));
+    for(auto _ : state){
+        kernels->convert(input.data(), output.data(), input.size());
+        benchmark::DoNotOptimize(output.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Convert)->ArgsProduct({{64, 512}, benchmark::CreateDenseRange(0, 4, 1)});
+
+// reference: std::fill, as used for the silence
+static void BM_FillStd(benchmark::State& state){
+    std::vector<double> output(state.range(0));
+    double value = 0.0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(value);
+        std::fill(output.begin(), output.end(), value);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FillStd)->Arg(64)->Arg(512);
+
+static void BM_Fill(benchmark::State& state){
+    const SimdKernels* kernels = benchKernels(state);
+    if(!kernels)
+        return;
+    std::vector<double> output(state.range(0));
+    double value = 0.0;
+    for(auto _ : state){
+        benchmark::DoNotOptimize(value);
+        kernels->fill(output.data(), value, output.size());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Fill)->ArgsProduct({{64, 512}, benchmark::CreateDenseRange(0, 4, 1)});
+
+// ----- deinterleave
+
+// range(0): channels, range(1): index in getAvailableSimdKernels(), 1024 frames
+static void BM_DeinterleaveChannels(benchmark::State& state){
+    const SimdKernels* kernels = benchKernels(state);
+    if(!kernels)
+        return;
+    const size_t num_channels = (size_t)state.range(0);
+    const size_t num_samples = 1024;
+    std::vector<float> input(num_channels * num_samples, 0.5f);
+    std::vector<std::vector<REAL>> output(num_channels, std::vector<REAL>(num_samples));
+    std::vector<REAL*> channels;
+    for(auto& channel : output)
+        channels.push_back(channel.data());
+    for(auto _ : state){
+        kernels->deinterleave(input.data(), channels.data(), num_samples, num_channels);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)(input.size() * sizeof(float)));
+}
+BENCHMARK(BM_DeinterleaveChannels)->ArgsProduct({{1, 2, 3, 4, 6, 8, 16, 64}, benchmark::CreateDenseRange(0, 4, 1)});
+
+// public entry point with the kernels of this CPU, range(0): channels, range(1): frames
+static void BM_Deinterleave(benchmark::State& state){
+    const size_t num_channels = (size_t)state.range(0);
+    const size_t num_samples = (size_t)state.range(1);
+    std::vector<float> input(num_channels * num_samples, 0.5f);
+    std::vector<std::vector<REAL>> output(num_channels, std::vector<REAL>(num_samples));
+    std::vector<REAL*> channels;
+    for(auto& channel : output)
+        channels.push_back(channel.data());
+    for(auto _ : state){
+        deinterleave(input.data(), channels.data(), num_samples, num_channels);
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(state.iterations() * (int64_t)(input.size() * sizeof(float)));
+    state.SetLabel(getCurrentSIMD());
+}
+BENCHMARK(BM_Deinterleave)->ArgsProduct({{1, 2, 4, 8, 64}, {64, 512, 4096}});
+
+// ----- output queue
+
+// worker side push of one render, audio side reads of range(1) frames, 2 channels
+// range(0): render size
+static void BM_RingPushPop(benchmark::State& state){
+    const size_t render_size = (size_t)state.range(0);
+    const size_t vector_size = (size_t)state.range(1);
+    const size_t num_channels = 2;
+    PlanarRingBuffer<REAL> ring;
+    ring.allocate(num_channels, 2 * MAX_RENDER_SIZE);
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size, 0.25f));
+    std::vector<const REAL*> rendered_channels {rendered[0].data(), rendered[1].data()};
+    std::vector<std::vector<double>> outs(num_channels, std::vector<double>(vector_size));
+    std::vector<double*> out_channels {outs[0].data(), outs[1].data()};
+    const SimdKernels& simd = getSimdKernels();
+    ChunkInfo info;
+    for(auto _ : state){
+        ring.push(rendered_channels.data(), num_channels, render_size, info);
+        PlanarRingBuffer<REAL>::Chunk chunk;
+        size_t offset;
+        while(ring.current(chunk, offset)){
+            ring.read(out_channels.data(), num_channels, vector_size, simd.convert);
+            benchmark::DoNotOptimize(chunk.info.position + offset);
+        }
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)render_size);
+}
+BENCHMARK(BM_RingPushPop)->ArgsProduct({{1024, 8192}, {64, 512}});
+
+// perform64 copy of one vector, range(0): vector size, range(1): 0 std::copy, 1 convert kernel
+static void BM_RingReadConvert(benchmark::State& state){
+    const size_t vector_size = (size_t)state.range(0);
+    const size_t num_channels = 2;
+    PlanarRingBuffer<REAL> ring;
+    ring.allocate(num_channels, 2 * MAX_RENDER_SIZE);
+    std::vector<std::vector<double>> outs(num_channels, std::vector<double>(vector_size));
+    std::vector<double*> out_channels {outs[0].data(), outs[1].data()};
+    const SimdKernels& simd = getSimdKernels();
+    ChunkInfo info;
+    for(auto _ : state){
+        // refill out of the measure
+        if(ring.readAvailable() < vector_size){
+            state.PauseTiming();
+            ring.push(nullptr, 0, MAX_RENDER_SIZE, info);
+            state.ResumeTiming();
+        }
+        if(state.range(1))
+            ring.read(out_channels.data(), num_channels, vector_size, simd.convert);
+        else
+            ring.read(out_channels.data(), num_channels, vector_size);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * (int64_t)vector_size);
+    state.SetLabel(state.range(1) ? getCurrentSIMD() : "std::copy");
+}
+BENCHMARK(BM_RingReadConvert)->ArgsProduct({{64, 512}, {0, 1}});
+
+// ----- render
+
+/**
+ One worker iteration: extract (deinterleave from an interleaved buffer~ like array),
+ SignalsmithStretch::process, push to the output queue, for each `mode`.
+ range(0): mode, range(1): render size. x_realtime: seconds of audio rendered per second.
+ */
+static void BM_RenderIteration(benchmark::State& state){
+    const long mode = (long)state.range(0);
+    const long render_size = (long)state.range(1);
+    const size_t num_channels = 2;
+    const float sr = 48000;
+    const double stretch_factor = 1.5;
+
+    signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+    configureStretch(stretch, (int)num_channels, mode, sr);
+    const long input_latency = stretch.inputLatency();
+    const long block_samples = (long)(stretch_factor * render_size);
+
+    // 10 seconds of interleaved source
+    const size_t frames = (size_t)(10 * sr);
+    std::vector<float> source(frames * num_channels);
+    for(size_t i = 0; i < frames; ++i){
+        for(size_t c = 0; c < num_channels; ++c)
+            source[i * num_channels + c] = 0.5f * std::sin(0.01f * (float)i * (float)(c + 1));
+    }
+
+    std::vector<std::vector<REAL>> extracted(num_channels, std::vector<REAL>(block_samples + input_latency));
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size));
+    std::vector<REAL*> extracted_channels, rendered_channels;
+    for(size_t c = 0; c < num_channels; ++c){
+        extracted_channels.push_back(extracted[c].data());
+        rendered_channels.push_back(rendered[c].data());
+    }
+    PlanarRingBuffer<REAL> ring;
+    ring.allocate(num_channels, 2 * MAX_RENDER_SIZE);
+
+    long position = 0;
+    for(auto _ : state){
+        if((size_t)(position + block_samples + input_latency) >= frames)
+            position = 0;
+        {
+            TRACE_SCOPE("extract", mode);
+            deinterleave(source.data() + position * num_channels, extracted_channels.data(), block_samples + input_latency, num_channels);
+        }
+        {
+            TRACE_SCOPE("process", mode);
+            stretch.process(extracted, (int)block_samples, rendered, (int)render_size);
+        }
+
+        ChunkInfo info;
+        info.position = position;
+        info.length = block_samples;
+        info.blocksize = block_samples + input_latency;
+        TRACE_SCOPE("enqueue", mode);
+        ring.push(rendered_channels.data(), num_channels, render_size, info);
+        ring.flush();
+        position += block_samples;
+    }
+    state.SetItemsProcessed(state.iterations() * render_size);
+    state.counters["x_realtime"] = benchmark::Counter((double)state.iterations() * (double)render_size / sr, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_RenderIteration)->ArgsProduct({{0, 1, 2, 3}, {1024, OUTPUT_STRETCH_BUFFER_SIZE}})->Unit(benchmark::kMicrosecond);
+
+// ----- buffer~ / DSP sample rate mismatch
+
+// resampling one planar channel from 44.1 kHz to 48 kHz. range(0): samples, range(1): kernel index
+static void BM_Resample(benchmark::State& state){
+    const SimdKernels* kernels = benchKernels(state);
+    if(!kernels)
+        return;
+    const size_t num_samples = (size_t)state.range(0);
+    const double step = 44100.0 / 48000.0;
+    PolyphaseResampler resampler;
+    resampler.setStep(step);
+    std::vector<float> input((size_t)(num_samples * step) + PolyphaseResampler::TAPS + 1);
+    for(size_t i = 0; i < input.size(); ++i)
+        input[i] = std::sin(0.01f * (float)i);
+    std::vector<REAL> output(num_samples);
+    for(auto _ : state){
+        kernels->resample(input.data(), output.data(), num_samples, (double)PolyphaseResampler::before() + 0.3, step,
+                          resampler.filterBank().data(), PolyphaseResampler::TAPS, PolyphaseResampler::PHASES);
+        benchmark::DoNotOptimize(output.data());
+    }
+    state.SetItemsProcessed(state.iterations() * num_samples);
+}
+BENCHMARK(BM_Resample)->ArgsProduct({{1024, OUTPUT_STRETCH_BUFFER_SIZE}, benchmark::CreateDenseRange(0, 4, 1)});
+
+/**
+ One render iteration of a 44.1 kHz stereo source at 48 kHz, mode 0.
+ range(0): 0 folds the ratio in the stretch factor and the pitch (raw frames, transposed stretcher),
+ 1 resamples the block before the stretcher.
+ */
+static void BM_SourceRateMismatch(benchmark::State& state){
+    const bool resample = state.range(0) != 0;
+    const long render_size = OUTPUT_STRETCH_BUFFER_SIZE;
+    const size_t num_channels = 2;
+    const float sr = 48000;
+    const double step = 44100.0 / 48000.0;
+    const double stretch_factor = 1.5;
+
+    signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+    configureStretch(stretch, (int)num_channels, 0, sr);
+    stretch.setTransposeSemitones(resample ? 0.0f : (float)(12.0 * std::log2(step)));
+    const long input_latency = stretch.inputLatency();
+    const long block_samples = (long)(stretch_factor * (resample ? 1.0 : step) * render_size);
+    const long total = block_samples + input_latency;
+    const long span = (long)((double)total * (resample ? step : 1.0)) + PolyphaseResampler::TAPS + 1;
+
+    const size_t frames = (size_t)(10 * 44100);
+    std::vector<float> source(frames * num_channels);
+    for(size_t i = 0; i < frames; ++i){
+        for(size_t c = 0; c < num_channels; ++c)
+            source[i * num_channels + c] = 0.5f * std::sin(0.01f * (float)i * (float)(c + 1));
+    }
+
+    PolyphaseResampler resampler;
+    resampler.setStep(step);
+    std::vector<std::vector<REAL>> planar(num_channels, std::vector<REAL>(span));
+    std::vector<std::vector<REAL>> extracted(num_channels, std::vector<REAL>(total));
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size));
+    std::vector<REAL*> planar_channels, extracted_channels;
+    for(size_t c = 0; c < num_channels; ++c){
+        planar_channels.push_back(planar[c].data());
+        extracted_channels.push_back(extracted[c].data());
+    }
+
+    double position = 0;
+    for(auto _ : state){
+        if((size_t)(position + span) >= frames)
+            position = 0;
+        const size_t first = (size_t)position;
+        if(resample){
+            deinterleave(source.data() + first * num_channels, planar_channels.data(), span, num_channels);
+            for(size_t c = 0; c < num_channels; ++c)
+                resampler.process(planar[c].data(), extracted[c].data(), total, position - (double)first + PolyphaseResampler::before(), step);
+        }
+        else{
+            deinterleave(source.data() + first * num_channels, extracted_channels.data(), total, num_channels);
+        }
+        stretch.process(extracted, (int)block_samples, rendered, (int)render_size);
+        position += block_samples * (resample ? step : 1.0);
+    }
+    state.SetItemsProcessed(state.iterations() * render_size);
+    state.counters["x_realtime"] = benchmark::Counter((double)state.iterations() * (double)render_size / sr, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_SourceRateMismatch)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/**
+ One render iteration of a 48 kHz stereo source stretched 100x, mode 0.
+ range(0): 0 stretches the block with the stretcher, 1 synthesises it from the analysis cache (analysis 1).
+ */
+static void BM_HyperStretch(benchmark::State& state){
+    const bool cached = state.range(0) != 0;
+    const long render_size = OUTPUT_STRETCH_BUFFER_SIZE;
+    const long num_channels = 2;
+    const float sr = 48000;
+    const double stretch_factor = 0.01;
+    
+    const long frames = (long)(10 * sr);
+    std::vector<float> interleaved(frames * num_channels);
+    for(long i = 0; i < frames; ++i){
+        for(long c = 0; c < num_channels; ++c)
+            interleaved[i * num_channels + c] = 0.5f * std::sin(0.01f * (float)i * (float)(c + 1));
+    }
+    PlanarSnapshot source(interleaved.data(), frames, num_channels);
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size));
+    std::vector<REAL*> rendered_channels;
+    for(auto& channel : rendered)
+        rendered_channels.push_back(channel.data());
+    
+    double position = sr;
+    if(cached){
+        AnalysisKey key;
+        key.frames = frames;
+        key.channels = num_channels;
+        key.sample_rate = sr;
+        key.layout = spectralLayout(0, sr);
+        std::string reason;
+        std::unique_ptr<SpectralAnalysis> analysis = SpectralAnalysis::create(key, std::string(), reason);
+        SpectralAnalyser analyser;
+        analyser.setLayout(key.layout);
+        std::vector<std::vector<REAL>> scratch(num_channels, std::vector<REAL>(key.layout.fft_size));
+        analysis->analyse(analyser, source, 0, analysis->frames(), scratch);
+        
+        SpectralSynth synth;
+        synth.configure(key.layout, (int)num_channels);
+        const SpectralAnalysis* frames_at = analysis.get();
+        for(auto _ : state){
+            synth.render([frames_at](long index, int channel){ return frames_at->frame(index, channel); },
+                         position, stretch_factor, 1.0f, rendered_channels.data(), render_size);
+            if(position > frames - sr)
+                position = sr;
+        }
+    }
+    else{
+        signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+        configureStretch(stretch, (int)num_channels, 0, sr);
+        const long input_latency = stretch.inputLatency();
+        const long block_samples = std::max((long)(stretch_factor * render_size), 4L);
+        std::vector<std::vector<REAL>> extracted(num_channels, std::vector<REAL>(block_samples + input_latency));
+        std::vector<REAL*> extracted_channels;
+        for(auto& channel : extracted)
+            extracted_channels.push_back(channel.data());
+        for(auto _ : state){
+            source.copy(extracted_channels.data(), (long)position - input_latency, block_samples + input_latency);
+            stretch.process(extracted, (int)block_samples, rendered, (int)render_size);
+            position += block_samples;
+            if(position > frames - sr)
+                position = sr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * render_size);
+    state.counters["x_realtime"] = benchmark::Counter((double)state.iterations() * (double)render_size / sr, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_HyperStretch)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/**
+ One render iteration of a stereo source at stretch_factor 0, mode 0.
+ range(0): 0 stretches a 4 sample block (before the freeze path), 1 synthesises the two frames captured at the freeze point.
+ */
+static void BM_Freeze(benchmark::State& state){
+    const bool spectral = state.range(0) != 0;
+    const long render_size = OUTPUT_STRETCH_BUFFER_SIZE;
+    const long num_channels = 2;
+    const float sr = 48000;
+    
+    const long frames = (long)sr;
+    std::vector<float> interleaved(frames * num_channels);
+    for(long i = 0; i < frames; ++i){
+        for(long c = 0; c < num_channels; ++c)
+            interleaved[i * num_channels + c] = 0.5f * std::sin(0.01f * (float)i * (float)(c + 1));
+    }
+    PlanarSnapshot source(interleaved.data(), frames, num_channels);
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size));
+    std::vector<REAL*> rendered_channels;
+    for(auto& channel : rendered)
+        rendered_channels.push_back(channel.data());
+    const long position = frames / 2;
+    
+    if(spectral){
+        const SpectralLayout layout = spectralLayout(0, sr);
+        std::vector<std::vector<REAL>> input(num_channels, std::vector<REAL>(layout.fft_size + layout.hop));
+        std::vector<REAL*> input_channels;
+        for(auto& channel : input)
+            input_channels.push_back(channel.data());
+        source.copy(input_channels.data(), position - layout.fft_size / 2, layout.fft_size + layout.hop);
+        SpectralAnalyser analyser;
+        analyser.setLayout(layout);
+        const size_t bins = (size_t)layout.bins();
+        std::vector<SpectralBin> captured(2 * num_channels * bins);
+        for(long c = 0; c < num_channels; ++c){
+            analyser.analyse(input[c].data(), captured.data() + c * bins);
+            analyser.analyse(input[c].data() + layout.hop, captured.data() + (num_channels + c) * bins);
+        }
+        
+        SpectralSynth synth;
+        synth.configure(layout, (int)num_channels);
+        const SpectralBin* data = captured.data();
+        for(auto _ : state){
+            double frozen = 0;
+            synth.render([data, bins](long index, int channel) -> const SpectralBin* {
+                             return index == 0 || index == 1 ? data + ((size_t)index * num_channels + channel) * bins : nullptr;
+                         }, frozen, 0.0, 1.0f, rendered_channels.data(), render_size);
+        }
+    }
+    else{
+        signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+        configureStretch(stretch, (int)num_channels, 0, sr);
+        const long input_latency = stretch.inputLatency();
+        const long block_samples = 4;
+        std::vector<std::vector<REAL>> extracted(num_channels, std::vector<REAL>(block_samples + input_latency));
+        std::vector<REAL*> extracted_channels;
+        for(auto& channel : extracted)
+            extracted_channels.push_back(channel.data());
+        for(auto _ : state){
+            source.copy(extracted_channels.data(), position - input_latency, block_samples + input_latency);
+            stretch.process(extracted, (int)block_samples, rendered, (int)render_size);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * render_size);
+    state.counters["x_realtime"] = benchmark::Counter((double)state.iterations() * (double)render_size / sr, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_Freeze)->Arg(0)->Arg(1)->Unit(benchmark::kMicrosecond);
+
+/**
+ What a render chunk of a stereo source costs the worker around a freeze, mode 0.
+ range(0): 0 a stretcher chunk at stretch_factor 1 (playing), 1 a frozen chunk (synthesis of the captured frames),
+ 2 the chunk handing over from one to the other (both, crossfaded).
+ */
+static void BM_FreezeChunk(benchmark::State& state){
+    const bool stretched = state.range(0) != 1;
+    const bool frozen = state.range(0) != 0;
+    const long render_size = OUTPUT_STRETCH_BUFFER_SIZE;
+    const long num_channels = 2;
+    const float sr = 48000;
+    
+    const long frames = (long)(10 * sr);
+    std::vector<float> interleaved(frames * num_channels);
+    for(long i = 0; i < frames; ++i){
+        for(long c = 0; c < num_channels; ++c)
+            interleaved[i * num_channels + c] = 0.5f * std::sin(0.01f * (float)i * (float)(c + 1));
+    }
+    PlanarSnapshot source(interleaved.data(), frames, num_channels);
+    std::vector<std::vector<REAL>> rendered(num_channels, std::vector<REAL>(render_size));
+    std::vector<std::vector<REAL>> spectral(num_channels, std::vector<REAL>(render_size));
+    std::vector<REAL*> rendered_channels, spectral_channels;
+    for(long c = 0; c < num_channels; ++c){
+        rendered_channels.push_back(rendered[c].data());
+        spectral_channels.push_back(spectral[c].data());
+    }
+    
+    signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+    configureStretch(stretch, (int)num_channels, 0, sr);
+    const long input_latency = stretch.inputLatency();
+    std::vector<std::vector<REAL>> extracted(num_channels, std::vector<REAL>(render_size + input_latency));
+    std::vector<REAL*> extracted_channels;
+    for(auto& channel : extracted)
+        extracted_channels.push_back(channel.data());
+    
+    // the two frames captured at the freeze point, as signalsmith_freeze_capture
+    const SpectralLayout layout = spectralLayout(0, sr);
+    const size_t bins = (size_t)layout.bins();
+    std::vector<SpectralBin> captured(2 * num_channels * bins);
+    {
+        std::vector<std::vector<REAL>> input(num_channels, std::vector<REAL>(layout.fft_size + layout.hop));
+        std::vector<REAL*> input_channels;
+        for(auto& channel : input)
+            input_channels.push_back(channel.data());
+        source.copy(input_channels.data(), (long)sr - layout.fft_size / 2, layout.fft_size + layout.hop);
+        SpectralAnalyser analyser;
+        analyser.setLayout(layout);
+        for(long c = 0; c < num_channels; ++c){
+            analyser.analyse(input[c].data(), captured.data() + c * bins);
+            analyser.analyse(input[c].data() + layout.hop, captured.data() + (num_channels + c) * bins);
+        }
+    }
+    const SpectralBin* data = captured.data();
+    auto frameAt = [data, bins](long index, int channel) -> const SpectralBin* {
+        return index == 0 || index == 1 ? data + ((size_t)index * num_channels + channel) * bins : nullptr;
+    };
+    SpectralSynth synth;
+    synth.configure(layout, (int)num_channels);
+    
+    long position = (long)sr;
+    for(auto _ : state){
+        if(stretched){
+            if(position + render_size + input_latency >= frames)
+                position = (long)sr;
+            source.copy(extracted_channels.data(), position - input_latency, render_size + input_latency);
+            stretch.process(extracted, (int)render_size, rendered, (int)render_size);
+            position += render_size;
+        }
+        if(frozen){
+            double held = 0;
+            synth.render(frameAt, held, 0.0, 1.0f, stretched ? spectral_channels.data() : rendered_channels.data(), render_size);
+        }
+        if(stretched && frozen)
+            spectralCrossfade(rendered_channels.data(), spectral_channels.data(), (size_t)num_channels, render_size, true);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * render_size);
+    state.counters["x_realtime"] = benchmark::Counter((double)state.iterations() * (double)render_size / sr, benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_FreezeChunk)->DenseRange(0, 2)->Unit(benchmark::kMicrosecond);
+
+// ----- stats
+
+// what a render chunk pays for its statistics: two clock reads and one histogram update
+static void BM_StatsRecord(benchmark::State& state){
+    RenderStats stats;
+    for(auto _ : state){
+        auto start = std::chrono::steady_clock::now();
+        benchmark::ClobberMemory();
+        stats.process.add(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    }
+    benchmark::DoNotOptimize(stats.take(48000).process.count);
+}
+BENCHMARK(BM_StatsRecord);
+
+// perform64 side, once per vector
+static void BM_StatsQueueDepth(benchmark::State& state){
+    RenderStats stats;
+    size_t frames = 0;
+    for(auto _ : state){
+        stats.addQueueDepth(frames);
+        frames = (frames + 64) & 8191;
+    }
+    benchmark::DoNotOptimize(stats.take(48000).queue_avg);
+}
+BENCHMARK(BM_StatsQueueDepth);
+
+// BENCHMARK_MAIN, then with SIGNALSMITH_TRACE the timeline is written to $SIGNALSMITH_TRACE_FILE (default bench_trace.json)
+int main(int argc, char** argv){
+    benchmark::Initialize(&argc, argv);
+    if(benchmark::ReportUnrecognizedArguments(argc, argv))
+        return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+#if SIGNALSMITH_TRACE
+    const char* path = std::getenv("SIGNALSMITH_TRACE_FILE");
+    if(!Trace::dump(path ? path : "bench_trace.json"))
+        fprintf(stderr, "cannot write the trace\n");
+#endif
+    return 0;
+}
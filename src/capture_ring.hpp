@@ -0,0 +1,218 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef capture_ring_hpp
+#define capture_ring_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+
+/**
+ Wait-free single producer / single consumer planar ring of the live input.
+
+ The producer (audio thread) never waits: it overwrites the oldest frames. Frames are addressed by their
+ absolute index since allocate(), the ring holds [written() - capacity(), written()[.
+ The consumer (worker) reads any range, the frames overwritten while it reads are detected (as with a seqlock)
+ and zeroed. Writes only touch the oldest frames: reads staying more than a write away from them are never overwritten.
+ All the memory is allocated by allocate(), which must not be called while any side is running.
+ */
+template<typename T>
+class CaptureRing {
+public:
+    /**
+     - Parameters:
+     - numChannels: number of planar channels
+     - minFrames: capacity in frames (rounded up to a power of 2)
+     */
+    void allocate(size_t numChannels, size_t minFrames){
+        num_channels = numChannels;
+        frame_capacity = 1;
+        while(frame_capacity < minFrames)
+            frame_capacity <<= 1;
+        data.assign(num_channels * frame_capacity, T(0));
+        write_frame = claim_frame = 0;
+    }
+
+    void deallocate(){
+        num_channels = frame_capacity = 0;
+        std::vector<T>().swap(data);
+        write_frame = claim_frame = 0;
+    }
+
+    size_t channels() const { return num_channels; }
+    size_t capacity() const { return frame_capacity; }
+
+    // ----- producer
+
+    /**
+     Append `frames` frames, overwriting the oldest ones. Channels of the ring not provided by the input are filled with zeros.
+     */
+    template<typename U>
+    void write(const U* const* input, size_t numInputChannels, size_t frames){
+        if(frame_capacity == 0 || frames == 0)
+            return;
+        // more than the whole ring: only the last frames remain
+        size_t skip = 0;
+        if(frames > frame_capacity){
+            skip = frames - frame_capacity;
+            frames = frame_capacity;
+        }
+        const size_t wf = write_frame.load(std::memory_order_relaxed) + skip;
+        // the frames about to be overwritten are announced before being touched
+        claim_frame.store(wf + frames, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        const size_t offset = wf & (frame_capacity - 1);
+        const size_t first = std::min(frames, frame_capacity - offset);
+        for(size_t c = 0; c < num_channels; ++c){
+            T* channel = data.data() + c * frame_capacity;
+            if(c < numInputChannels && input){
+                const U* in = input[c] + skip;
+                std::copy(in, in + first, channel + offset);
+                std::copy(in + first, in + frames, channel);
+            }
+            else{
+                std::fill(channel + offset, channel + offset + first, T(0));
+                std::fill(channel, channel + (frames - first), T(0));
+            }
+        }
+        write_frame.store(wf + frames, std::memory_order_release);
+    }
+
+    // ----- consumer
+
+    // absolute index of the next frame written
+    size_t written() const {
+        return write_frame.load(std::memory_order_acquire);
+    }
+
+    /**
+     Frames [first, first + frames[ into `output`, zeros for the frames not (or no longer) in the ring.
+     Output channels >= channels() are left untouched.
+     - Returns: false if some frames have been overwritten during the read (they are zeroed)
+     */
+    bool read(T* const* output, size_t numOutputChannels, long first, size_t frames) const {
+        const size_t nc = std::min(num_channels, numOutputChannels);
+        const long last = first + (long)frames;
+        const long written_before = (long)written();
+        const long begin = std::min(std::max(first, std::max(written_before - (long)frame_capacity, 0L)), last);
+        const long end = std::max(std::min(last, written_before), begin);
+        for(size_t c = 0; c < nc; ++c){
+            const T* channel = data.data() + c * frame_capacity;
+            T* out = output[c];
+            std::fill(out, out + (begin - first), T(0));
+            for(long f = begin; f < end;){
+                const size_t offset = (size_t)f & (frame_capacity - 1);
+                const long run = std::min(end - f, (long)(frame_capacity - offset));
+                std::copy(channel + offset, channel + offset + run, out + (f - first));
+                f += run;
+            }
+            std::fill(out + (end - first), out + frames, T(0));
+        }
+        
+        // overwritten meanwhile (or being overwritten): the oldest frames read are no longer the right ones
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const long torn = std::min((long)claim_frame.load(std::memory_order_relaxed) - (long)frame_capacity, end);
+        if(torn <= begin)
+            return true;
+        for(size_t c = 0; c < nc; ++c)
+            std::fill(output[c] + (begin - first), output[c] + (torn - first), T(0));
+        return false;
+    }
+
+private:
+    size_t num_channels = 0;
+    size_t frame_capacity = 0;
+    std::vector<T> data;
+
+    alignas(64) std::atomic<size_t> write_frame{0};
+    std::atomic<size_t> claim_frame{0};     // write_frame + the frames being written
+};
+
+/**
+ Read head policy of the live input, when the stretch factor does not follow the input (attribute live_policy).
+ */
+enum LivePolicy {
+    LiveFollow,     // falling out of the ring: jump back to the newest input
+    LiveHold,       // falling out of the ring: stay on the oldest input, the delay holds at the ring size
+    LiveDrift       // pulled toward the newest input all along, the delay settles instead of growing
+};
+
+/**
+ Block of live input to stretch next.
+ */
+struct LiveBlock {
+    double position = 0;    // capture frame of the block start, input latency frames are read before it
+    long blocksize = 0;     // input frames, 0: not enough input yet
+    bool jumped = false;    // the position is not the continuation of the previous block
+};
+
+/**
+ Place the next block of the live input according to the policy.
+ The read head runs at the stretch factor, it can neither read the frames not captured yet
+ (the block is shortened at the newest input) nor the frames overwritten (see LivePolicy).
+ 
+ - Parameters:
+ - policy: see LivePolicy
+ - position: capture frame where the previous block ended
+ - blocksize: input frames wanted (stretch factor * output frames)
+ - outputFrames: output frames rendered from the block
+ - latency: input latency frames read before the position
+ - written: capture frames written
+ - readable: frames of the ring that can be read safely (capacity - the largest write)
+ - driftFrames: LiveDrift, output frames over which the delay is caught up
+ */
+inline LiveBlock placeLiveBlock(LivePolicy policy, double position, long blocksize, long outputFrames, long latency,
+                                long written, long readable, double driftFrames){
+    LiveBlock block;
+    block.position = position;
+    block.blocksize = std::max(blocksize, 0L);
+    
+    if(policy == LiveDrift && driftFrames > 0){
+        double delay = (double)written - (position + (double)block.blocksize);
+        if(delay > 0)
+            block.blocksize += (long)(delay * (double)outputFrames / driftFrames);
+    }
+    
+    const double oldest = (double)(written - readable + latency);
+    if(block.position < oldest){
+        if(policy == LiveFollow){
+            block.position = (double)std::max(written - block.blocksize, 0L);
+            block.jumped = true;
+        }
+        block.position = std::max(block.position, oldest);
+    }
+    
+    // at the newest input: the read head cannot go faster than the input
+    const double newest = (double)written;
+    block.position = std::min(block.position, newest);
+    block.blocksize = std::min(block.blocksize, (long)(newest - block.position));
+    return block;
+}
+
+#endif /* capture_ring_hpp */
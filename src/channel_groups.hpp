@@ -0,0 +1,109 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef channel_groups_hpp
+#define channel_groups_hpp
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "stretch_modes.hpp"
+#include "worker_pool.hpp"
+
+/**
+ Channels [first, first + count[ processed by one stretcher.
+ */
+struct ChannelGroup {
+    long first = 0;
+    long count = 0;
+};
+
+/**
+ Split channels into at most maxGroups groups of whole stereo pairs (0-1, 2-3...),
+ so a pair always shares a stretcher and stays phase coherent.
+ The pairs are spread as evenly as possible, a last odd channel counts as a pair.
+
+ - Parameters:
+ - numChannels: channels to split
+ - maxGroups: at most this many groups (<= 1: a single group)
+ */
+inline std::vector<ChannelGroup> channelGroups(long numChannels, long maxGroups){
+    std::vector<ChannelGroup> groups;
+    if(numChannels <= 0)
+        return groups;
+    const long pairs = (numChannels + 1) / 2;
+    const long num_groups = std::min(std::max(maxGroups, 1L), pairs);
+    long pair = 0;
+    for(long g = 0; g < num_groups; ++g){
+        const long group_pairs = pairs / num_groups + (g < pairs % num_groups ? 1 : 0);
+        ChannelGroup group;
+        group.first = pair * 2;
+        group.count = std::min(group_pairs * 2, numChannels - group.first);
+        groups.push_back(group);
+        pair += group_pairs;
+    }
+    return groups;
+}
+
+/**
+ Channels rendered by one stretcher. Every group is configured alike;
+ the groups after the first one render on other workers while the first one renders in place.
+ */
+struct StretchGroup {
+    ChannelGroup channels;
+    std::unique_ptr<signalsmith::stretch::SignalsmithStretch<REAL>> stretch;
+    std::unique_ptr<PoolJob> job;
+    const REAL** inputs = nullptr;      // channels of the whole stretcher, the group reads from channels.first
+    REAL** outputs = nullptr;
+};
+
+// process the channels of one group, from its inputs to its outputs
+inline void processGroup(StretchGroup& group, long inputSamples, long outputSamples){
+    group.stretch->process(group.inputs + group.channels.first, (int)inputSamples,
+                           group.outputs + group.channels.first, (int)outputSamples);
+}
+
+/**
+ Fork of a render: the jobs of the groups rendered elsewhere go to the pool,
+ the caller then renders the other groups in place and joins with joinGroups().
+ */
+inline void forkGroups(WorkerPool& pool, PoolJob* const* jobs, size_t numJobs){
+    for(size_t j = 0; j < numJobs; ++j)
+        pool.submit(jobs[j]);
+}
+
+/**
+ Join of a render: runs the jobs nobody has picked up yet, then waits for the others.
+ Each job signals `done` once when over, every signal is consumed here.
+ */
+inline void joinGroups(WorkerPool& pool, Semaphore& done, PoolJob* const* jobs, size_t numJobs){
+    for(size_t j = 0; j < numJobs; ++j)
+        pool.runIfQueued(jobs[j]);
+    for(size_t j = 0; j < numJobs; ++j)
+        done.wait();
+}
+
+#endif /* channel_groups_hpp */
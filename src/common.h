@@ -26,6 +26,20 @@
 #define common_h
 
 typedef float REAL;
-#define MAX_BUFFER_CHANNEL 4
-#define OUTPUT_STRETCH_BUFFER_SIZE (1<<13)
+#define MAX_BUFFER_CHANNEL 64
+#define OUTPUT_STRETCH_BUFFER_SIZE (1<<13)   // default render size
+#define MIN_RENDER_SIZE (1<<8)
+#define MAX_RENDER_SIZE (1<<14)
+#define UNDERRUN_FADE_SIZE 64
+#define PARAM_SUBBLOCK_SIZE (1<<8)          // render size while the signal parameters move
+#define PARAM_STREAM_SIZE (1<<12)           // vectors of signal parameters queued to the worker
+#define PARAM_EPSILON 1e-4f                 // smaller changes of the signal parameters are not a move
+#define MODE_CROSSFADE_SIZE (1<<11)         // crossfade between the stretchers of two modes
+#define FILE_PREFETCH_SECONDS 4.0           // output duration of the file source faulted in ahead of the position
+#define LIVE_CAPTURE_MS 10000               // live input kept by the capture ring (default live_size)
+#define LIVE_CAPTURE_MAX_MS 60000
+#define LIVE_CAPTURE_GUARD (1<<13)          // frames of the capture ring kept away from the reads: larger than any vector
+#define LIVE_DRIFT_SECONDS 2.0              // live_policy drift: output duration over which the delay is caught up
+#define HYPER_STRETCH_FACTOR 0.02f          // analysis 1: slower stretch factors (50x and more) are synthesised from the analysis cache
+#define ANALYSIS_SLICE_FRAMES 16            // analysis frames per run of an analysis job
 #endif /* common_h */
@@ -26,18 +26,27 @@
 #ifndef deinterleave_hpp
 #define deinterleave_hpp
 
+#include <cstddef>
 #include <vector>
 #include "common.h"
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-    #include <arm_neon.h>
-#elif defined(__AVX__) ||  defined(__AVX2__)
-    #include <immintrin.h>
-#endif
-
+// name of the kernels selected at runtime for this CPU
 const char* getCurrentSIMD();
 
 
+/**
+ Deinterleave into caller owned planar buffers, never allocates.
+
+ - Parameters:
+ - interleaved: numSamples * numChannels samples
+ - output: numChannels pointers, each channel must hold outputOffset + numSamples samples
+ - outputOffset: first sample written in each output channel
+ */
+void deinterleave(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels, size_t outputOffset = 0);
+
+/**
+ Deinterleave into vectors, resized to numChannels x numSamples.
+ */
 void deinterleave(const float* interleaved, std::vector<std::vector<REAL>> &output, size_t numSamples, size_t numChannels);
 
 #endif /* deinterleave_hpp */
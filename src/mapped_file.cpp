@@ -0,0 +1,428 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "mapped_file.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#include "deinterleave.hpp"
+#include "trace.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace {
+
+const size_t PAGE_SIZE = 4096;
+
+uint32_t readLE32(const unsigned char* p){ return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24); }
+uint16_t readLE16(const unsigned char* p){ return (uint16_t)(p[0] | (p[1] << 8)); }
+uint32_t readBE32(const unsigned char* p){ return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | (uint32_t)p[3]; }
+uint16_t readBE16(const unsigned char* p){ return (uint16_t)((p[0] << 8) | p[1]); }
+
+// 80 bit IEEE extended float of the AIFF COMM chunk
+double readExtended(const unsigned char* p){
+    int exponent = ((p[0] & 0x7F) << 8) | p[1];
+    uint64_t mantissa = 0;
+    for(int i = 0; i < 8; ++i)
+        mantissa = (mantissa << 8) | p[2 + i];
+    if(exponent == 0 && mantissa == 0)
+        return 0.0;
+    double value = std::ldexp((double)mantissa, exponent - 16383 - 63);
+    return (p[0] & 0x80) ? -value : value;
+}
+
+bool isLittleEndianHost(){
+    const uint16_t one = 1;
+    return *(const unsigned char*)&one == 1;
+}
+
+// decode one sample, the bytes in file order
+template<MappedAudioFile::Encoding E, bool BigEndian>
+REAL decode(const unsigned char* p){
+    auto byte = [p](int i, int n){ return (uint32_t)p[BigEndian ? n - 1 - i : i]; };   // i-th least significant byte
+    if(E == MappedAudioFile::Int16){
+        return (REAL)(int16_t)(byte(0, 2) | (byte(1, 2) << 8)) * (REAL)(1.0 / 32768.0);
+    }
+    else if(E == MappedAudioFile::Int24){
+        int32_t v = (int32_t)((byte(0, 3) << 8) | (byte(1, 3) << 16) | (byte(2, 3) << 24)) >> 8;
+        return (REAL)v * (REAL)(1.0 / 8388608.0);
+    }
+    else if(E == MappedAudioFile::Int32){
+        return (REAL)((double)(int32_t)(byte(0, 4) | (byte(1, 4) << 8) | (byte(2, 4) << 16) | (byte(3, 4) << 24)) * (1.0 / 2147483648.0));
+    }
+    else if(E == MappedAudioFile::Float32){
+        uint32_t bits = byte(0, 4) | (byte(1, 4) << 8) | (byte(2, 4) << 16) | (byte(3, 4) << 24);
+        float v;
+        std::memcpy(&v, &bits, 4);
+        return (REAL)v;
+    }
+    else{
+        uint64_t bits = 0;
+        for(int i = 7; i >= 0; --i)
+            bits = (bits << 8) | byte(i, 8);
+        double v;
+        std::memcpy(&v, &bits, 8);
+        return (REAL)v;
+    }
+}
+
+template<MappedAudioFile::Encoding E, bool BigEndian>
+void convertFrames(const unsigned char* frames, size_t sampleBytes, long numChannels, REAL* const* output, long count){
+    const size_t frameBytes = sampleBytes * (size_t)numChannels;
+    for(long i = 0; i < count; ++i){
+        const unsigned char* frame = frames + (size_t)i * frameBytes;
+        for(long c = 0; c < numChannels; ++c)
+            output[c][i] = decode<E, BigEndian>(frame + (size_t)c * sampleBytes);
+    }
+}
+
+template<bool BigEndian>
+void convertFrames(MappedAudioFile::Encoding encoding, const unsigned char* frames, size_t sampleBytes, long numChannels, REAL* const* output, long count){
+    switch(encoding){
+        case MappedAudioFile::Int16: convertFrames<MappedAudioFile::Int16, BigEndian>(frames, sampleBytes, numChannels, output, count); break;
+        case MappedAudioFile::Int24: convertFrames<MappedAudioFile::Int24, BigEndian>(frames, sampleBytes, numChannels, output, count); break;
+        case MappedAudioFile::Int32: convertFrames<MappedAudioFile::Int32, BigEndian>(frames, sampleBytes, numChannels, output, count); break;
+        case MappedAudioFile::Float32: convertFrames<MappedAudioFile::Float32, BigEndian>(frames, sampleBytes, numChannels, output, count); break;
+        case MappedAudioFile::Float64: convertFrames<MappedAudioFile::Float64, BigEndian>(frames, sampleBytes, numChannels, output, count); break;
+    }
+}
+
+}
+
+// ----- MappedAudioFile
+
+std::unique_ptr<MappedAudioFile> MappedAudioFile::open(const std::string& path, std::string& error){
+    std::unique_ptr<MappedAudioFile> file(new MappedAudioFile());
+#if defined(_WIN32)
+    HANDLE handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if(handle == INVALID_HANDLE_VALUE){
+        error = "cannot open the file";
+        return nullptr;
+    }
+    file->file_handle = handle;
+    LARGE_INTEGER size;
+    if(!GetFileSizeEx(handle, &size) || size.QuadPart == 0){
+        error = "empty file";
+        return nullptr;
+    }
+    file->mapped_bytes = (size_t)size.QuadPart;
+    file->mapping_handle = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if(!file->mapping_handle){
+        error = "cannot map the file";
+        return nullptr;
+    }
+    file->mapped = (const unsigned char*)MapViewOfFile(file->mapping_handle, FILE_MAP_READ, 0, 0, 0);
+#else
+    file->fd = ::open(path.c_str(), O_RDONLY);
+    if(file->fd < 0){
+        error = "cannot open the file";
+        return nullptr;
+    }
+    struct stat info;
+    if(fstat(file->fd, &info) != 0 || info.st_size == 0){
+        error = "empty file";
+        return nullptr;
+    }
+    file->mapped_bytes = (size_t)info.st_size;
+    void* address = mmap(nullptr, file->mapped_bytes, PROT_READ, MAP_SHARED, file->fd, 0);
+    file->mapped = address == MAP_FAILED ? nullptr : (const unsigned char*)address;
+#endif
+    if(!file->mapped){
+        error = "cannot map the file";
+        return nullptr;
+    }
+    
+    if(file->mapped_bytes >= 12 && std::memcmp(file->mapped, "RIFF", 4) == 0 && std::memcmp(file->mapped + 8, "WAVE", 4) == 0){
+        if(!file->parseWav(error))
+            return nullptr;
+    }
+    else if(file->mapped_bytes >= 12 && std::memcmp(file->mapped, "FORM", 4) == 0
+            && (std::memcmp(file->mapped + 8, "AIFF", 4) == 0 || std::memcmp(file->mapped + 8, "AIFC", 4) == 0)){
+        if(!file->parseAiff(error))
+            return nullptr;
+    }
+    else{
+        error = "not a WAV or AIFF file";
+        return nullptr;
+    }
+    
+    if(file->num_channels <= 0 || file->num_channels > MAX_BUFFER_CHANNEL){
+        error = "unsupported number of channels";
+        return nullptr;
+    }
+    if(file->sample_rate <= 0){
+        error = "invalid sample rate";
+        return nullptr;
+    }
+    return file;
+}
+
+MappedAudioFile::~MappedAudioFile(){
+#if defined(_WIN32)
+    if(mapped)
+        UnmapViewOfFile(mapped);
+    if(mapping_handle)
+        CloseHandle(mapping_handle);
+    if(file_handle)
+        CloseHandle(file_handle);
+#else
+    if(mapped)
+        munmap((void*)mapped, mapped_bytes);
+    if(fd >= 0)
+        close(fd);
+#endif
+}
+
+bool MappedAudioFile::parseWav(std::string& error){
+    const unsigned char* fmt = nullptr;
+    size_t fmt_size = 0;
+    size_t offset = 12;
+    while(offset + 8 <= mapped_bytes){
+        const unsigned char* chunk = mapped + offset;
+        size_t size = readLE32(chunk + 4);
+        if(std::memcmp(chunk, "fmt ", 4) == 0){
+            fmt = chunk + 8;
+            fmt_size = std::min(size, mapped_bytes - offset - 8);
+        }
+        else if(std::memcmp(chunk, "data", 4) == 0){
+            if(!fmt || fmt_size < 16){
+                error = "no format before the data";
+                return false;
+            }
+            uint16_t format = readLE16(fmt);
+            num_channels = readLE16(fmt + 2);
+            sample_rate = readLE32(fmt + 4);
+            uint16_t bits = readLE16(fmt + 14);
+            if(format == 0xFFFE && fmt_size >= 26)
+                format = readLE16(fmt + 24);    // sub format of WAVE_FORMAT_EXTENSIBLE
+            if(format == 1 && bits == 16)
+                sample_encoding = Int16;
+            else if(format == 1 && bits == 24)
+                sample_encoding = Int24;
+            else if(format == 1 && bits == 32)
+                sample_encoding = Int32;
+            else if(format == 3 && bits == 32)
+                sample_encoding = Float32;
+            else if(format == 3 && bits == 64)
+                sample_encoding = Float64;
+            else{
+                error = "unsupported sample format";
+                return false;
+            }
+            sample_bytes = bits / 8;
+            big_endian = false;
+            data = chunk + 8;
+            // truncated files: the frames actually there
+            size = std::min(size, mapped_bytes - offset - 8);
+            num_frames = num_channels > 0 ? (long)(size / (sample_bytes * (size_t)num_channels)) : 0;
+            return true;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    error = "no data chunk";
+    return false;
+}
+
+bool MappedAudioFile::parseAiff(std::string& error){
+    const bool aifc = std::memcmp(mapped + 8, "AIFC", 4) == 0;
+    const unsigned char* comm = nullptr;
+    size_t comm_size = 0;
+    const unsigned char* ssnd = nullptr;
+    size_t ssnd_size = 0;
+    size_t offset = 12;
+    while(offset + 8 <= mapped_bytes && !(comm && ssnd)){
+        const unsigned char* chunk = mapped + offset;
+        size_t size = readBE32(chunk + 4);
+        size_t available = std::min(size, mapped_bytes - offset - 8);
+        if(std::memcmp(chunk, "COMM", 4) == 0){
+            comm = chunk + 8;
+            comm_size = available;
+        }
+        else if(std::memcmp(chunk, "SSND", 4) == 0){
+            ssnd = chunk + 8;
+            ssnd_size = available;
+        }
+        offset += 8 + size + (size & 1);
+    }
+    if(!comm || comm_size < 18 || !ssnd || ssnd_size < 8){
+        error = "no COMM or SSND chunk";
+        return false;
+    }
+    
+    num_channels = readBE16(comm);
+    long declared_frames = (long)readBE32(comm + 2);
+    uint16_t bits = readBE16(comm + 6);
+    sample_rate = readExtended(comm + 8);
+    big_endian = true;
+    bool is_float = false;
+    if(aifc && comm_size >= 22){
+        if(std::memcmp(comm + 18, "sowt", 4) == 0)
+            big_endian = false;
+        else if(std::memcmp(comm + 18, "fl32", 4) == 0 || std::memcmp(comm + 18, "FL32", 4) == 0){
+            is_float = true;
+            bits = 32;
+        }
+        else if(std::memcmp(comm + 18, "fl64", 4) == 0 || std::memcmp(comm + 18, "FL64", 4) == 0){
+            is_float = true;
+            bits = 64;
+        }
+        else if(std::memcmp(comm + 18, "NONE", 4) != 0){
+            error = "unsupported AIFC compression";
+            return false;
+        }
+    }
+    if(is_float)
+        sample_encoding = bits == 64 ? Float64 : Float32;
+    else if(bits == 16)
+        sample_encoding = Int16;
+    else if(bits == 24)
+        sample_encoding = Int24;
+    else if(bits == 32)
+        sample_encoding = Int32;
+    else{
+        error = "unsupported sample format";
+        return false;
+    }
+    sample_bytes = bits / 8;
+    
+    size_t data_offset = 8 + readBE32(ssnd);
+    if(data_offset > ssnd_size){
+        error = "invalid SSND chunk";
+        return false;
+    }
+    data = ssnd + data_offset;
+    long available_frames = num_channels > 0 ? (long)((ssnd_size - data_offset) / (sample_bytes * (size_t)num_channels)) : 0;
+    num_frames = std::min(declared_frames, available_frames);
+    return true;
+}
+
+void MappedAudioFile::read(REAL* const* output, long first, long count) const {
+    long begin = std::max(std::min(first, num_frames), 0L);
+    long end = std::max(std::min(first + count, num_frames), begin);
+    long head = std::min(std::max(begin - first, 0L), count);
+    long tail = std::min(std::max(end - first, head), count);
+    REAL* shifted[MAX_BUFFER_CHANNEL];
+    for(long c = 0; c < num_channels; ++c){
+        std::fill(output[c], output[c] + head, (REAL)0);
+        std::fill(output[c] + tail, output[c] + count, (REAL)0);
+        shifted[c] = output[c] + head;
+    }
+    if(tail <= head)
+        return;
+    
+    const unsigned char* frames = data + (size_t)begin * sample_bytes * (size_t)num_channels;
+    if(sample_encoding == Float32 && big_endian != isLittleEndianHost() && (uintptr_t)frames % alignof(float) == 0)
+        deinterleave((const float*)frames, shifted, (size_t)(tail - head), (size_t)num_channels);
+    else if(big_endian)
+        convertFrames<true>(sample_encoding, frames, sample_bytes, num_channels, shifted, tail - head);
+    else
+        convertFrames<false>(sample_encoding, frames, sample_bytes, num_channels, shifted, tail - head);
+}
+
+bool MappedAudioFile::prefetch(long first, long count, const std::atomic_bool* stop) const {
+    long begin = std::max(std::min(first, num_frames), 0L);
+    long end = std::max(std::min(first + count, num_frames), begin);
+    if(end <= begin)
+        return true;
+    const size_t frame_bytes = sample_bytes * (size_t)num_channels;
+    const size_t from = (size_t)(data - mapped) + (size_t)begin * frame_bytes;
+    const size_t to = std::min((size_t)(data - mapped) + (size_t)end * frame_bytes, mapped_bytes);
+#if !defined(_WIN32)
+    // let the kernel read ahead, then make sure every page is in
+    const size_t aligned = from & ~(PAGE_SIZE - 1);
+    madvise((void*)(mapped + aligned), to - aligned, MADV_WILLNEED);
+#endif
+    volatile unsigned char sink = 0;
+    for(size_t page = from & ~(PAGE_SIZE - 1); page < to; page += PAGE_SIZE){
+        if(stop && stop->load(std::memory_order_relaxed))
+            return false;
+        sink = sink + mapped[std::max(page, from)];
+    }
+    (void)sink;
+    return true;
+}
+
+// ----- FilePrefetcher
+
+FilePrefetcher::FilePrefetcher(const MappedAudioFile& file, double seconds)
+: file(file), seconds(seconds) {
+    thread = std::thread(&FilePrefetcher::loop, this);
+}
+
+FilePrefetcher::~FilePrefetcher(){
+    stopping = true;
+    wakeup.signal();
+    thread.join();
+}
+
+void FilePrefetcher::update(double position, double framesPerSecond){
+    read_head.store(position, std::memory_order_relaxed);
+    rate.store(framesPerSecond, std::memory_order_relaxed);
+    // the thread reads the latest values, and drops the wakeups accumulated meanwhile
+    wakeup.signal();
+}
+
+void FilePrefetcher::loop(){
+    TRACE_THREAD("prefetch");
+    const long step = 1 << 16;     // frames prefetched between two checks of the read head
+    while(!stopping){
+        wakeup.wait();
+        while(wakeup.tryWait()){}    // coalesce the updates
+        if(stopping)
+            break;
+        
+        long head = (long)read_head.load(std::memory_order_relaxed);
+        long target = std::min(head + (long)std::ceil(seconds * std::max(rate.load(std::memory_order_relaxed), 0.0)), file.frames());
+        // seek outside of the prefetched window: start again from the read head
+        if(head < prefetched_begin || head > prefetched_end){
+            prefetched_begin = head;
+            prefetched_end = head;
+        }
+        while(prefetched_end < target && !stopping){
+            long from = prefetched_end;
+            long count = std::min(step, target - from);
+            TRACE_SCOPE("prefetch", 0);
+            if(!file.prefetch(from, count, &stopping))
+                break;
+            prefetched_end = from + count;
+            // the worker moved on meanwhile: follow it
+            long latest = (long)read_head.load(std::memory_order_relaxed);
+            if(latest < prefetched_begin || latest > prefetched_end)
+                break;
+            target = std::min(std::max(target, latest + (long)std::ceil(seconds * std::max(rate.load(std::memory_order_relaxed), 0.0))), file.frames());
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef mapped_file_hpp
+#define mapped_file_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "common.h"
+#include "semaphore.hpp"
+
+/**
+ WAV or AIFF file mapped in memory, read as planar frames.
+
+ Opening only parses the chunk headers and maps the file: it does not depend on the length of the file,
+ the pages are read from the disk when touched (see FilePrefetcher).
+ Supported: 16, 24, 32 bit integer and 32, 64 bit float PCM, WAV (and WAVE_FORMAT_EXTENSIBLE), AIFF, AIFC (NONE, sowt, fl32, fl64).
+ */
+class MappedAudioFile {
+public:
+    enum Encoding { Int16, Int24, Int32, Float32, Float64 };
+
+    /**
+     - Parameters:
+     - path: native path of the file
+     - error: reason of the failure
+     - Returns: nullptr if the file cannot be mapped or its format is not supported
+     */
+    static std::unique_ptr<MappedAudioFile> open(const std::string& path, std::string& error);
+
+    ~MappedAudioFile();
+    MappedAudioFile(const MappedAudioFile&) = delete;
+    MappedAudioFile& operator=(const MappedAudioFile&) = delete;
+
+    long frames() const { return num_frames; }
+    long channels() const { return num_channels; }
+    double sampleRate() const { return sample_rate; }
+    Encoding encoding() const { return sample_encoding; }
+    size_t bytes() const { return mapped_bytes; }
+
+    /**
+     Planar frames [first, first + count[ of every channel, zeros outside of the file.
+     Little endian float files go through deinterleave(), the other encodings are converted frame by frame.
+     */
+    void read(REAL* const* output, long first, long count) const;
+
+    /**
+     Fault in the pages of the frames [first, first + count[ (clipped to the file).
+     - Returns: false if stopped before the end
+     */
+    bool prefetch(long first, long count, const std::atomic_bool* stop = nullptr) const;
+
+private:
+    MappedAudioFile() = default;
+    bool parseWav(std::string& error);
+    bool parseAiff(std::string& error);
+
+    const unsigned char* mapped = nullptr;
+    size_t mapped_bytes = 0;
+#if defined(_WIN32)
+    void* file_handle = nullptr;
+    void* mapping_handle = nullptr;
+#else
+    int fd = -1;
+#endif
+
+    const unsigned char* data = nullptr;    // first frame
+    long num_frames = 0;
+    long num_channels = 0;
+    double sample_rate = 0;
+    Encoding sample_encoding = Int16;
+    size_t sample_bytes = 2;
+    bool big_endian = false;
+};
+
+/**
+ Thread faulting in the pages of a MappedAudioFile ahead of the read head,
+ so that the render worker only touches pages already in memory.
+
+ The worker posts the read head and the speed it reads at after each chunk (lock-free, never blocks),
+ the thread touches the next `seconds` of frames the stretcher will read.
+ */
+class FilePrefetcher {
+public:
+    FilePrefetcher(const MappedAudioFile& file, double seconds);
+    ~FilePrefetcher();
+    FilePrefetcher(const FilePrefetcher&) = delete;
+    FilePrefetcher& operator=(const FilePrefetcher&) = delete;
+
+    /**
+     - Parameters:
+     - position: read head, in frames of the file
+     - framesPerSecond: frames of the file read per second of output
+     */
+    void update(double position, double framesPerSecond);
+
+    // frames from the read head known to be in memory, for the tests
+    long ahead() const { return prefetched_end.load() - (long)read_head.load(); }
+
+private:
+    void loop();
+
+    const MappedAudioFile& file;
+    const double seconds;
+    std::atomic<double> read_head{0};
+    std::atomic<double> rate{0};
+    std::atomic<long> prefetched_begin{0};
+    std::atomic<long> prefetched_end{0};
+    std::atomic_bool stopping{false};
+    Semaphore wakeup;
+    std::thread thread;
+};
+
+#endif /* mapped_file_hpp */
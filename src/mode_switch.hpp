@@ -0,0 +1,151 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef mode_switch_hpp
+#define mode_switch_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+#include "common.h"
+
+enum SwitchState { SwitchIdle, SwitchBuilding, SwitchReady, SwitchFading, SwitchRetiring };
+
+/**
+ Mode switch of a running stretcher, without a rebuild on any realtime path.
+
+ The switch job (pool) builds the stretcher of the last mode requested, the render worker crossfades it in
+ over MODE_CROSSFADE_SIZE frames then swaps it with the current one, and the next run of the switch job
+ destroys the retired stretcher. The stretchers themselves belong to the caller: this is the state they go
+ through, and the crossfade. A mode requested during a switch is built by the run following it.
+ */
+class ModeSwitch {
+public:
+    // the stretcher has been rebuilt directly with `mode`, no switch running
+    void rebuilt(long mode){
+        built = mode;
+        state = SwitchIdle;
+    }
+
+    // any thread
+    void request(long mode){
+        requested = mode;
+    }
+
+    // last mode requested
+    long mode() const {
+        return requested;
+    }
+
+    // ----- switch job
+
+    // the worker has swapped the stretchers: the old one has to be destroyed, then retired() called
+    bool retiring() const {
+        return state == SwitchRetiring;
+    }
+
+    void retired(){
+        state = SwitchIdle;
+    }
+
+    /**
+     Starts a switch, unless one is running or the stretcher already has the last mode requested.
+     - Parameters:
+     - mode: set to the mode of the stretcher to build, then ready() (or cancel() without one)
+     - Returns: true if the switch has started
+     */
+    bool begin(long& mode){
+        int expected = SwitchIdle;
+        if(!state.compare_exchange_strong(expected, SwitchBuilding))
+            return false;   // the worker submits the switch job again once it is done
+        mode = requested;
+        if(mode == built){
+            state = SwitchIdle;
+            return false;
+        }
+        next = mode;
+        return true;
+    }
+
+    void cancel(){
+        state = SwitchIdle;
+    }
+
+    // the next stretcher is built, for the worker to pick up
+    void ready(){
+        state = SwitchReady;
+    }
+
+    // ----- render worker
+
+    // picks up a ready stretcher: true if it has to be pre-rolled, the crossfade starts with the next chunk
+    bool start(){
+        if(state != SwitchReady)
+            return false;
+        done = 0;
+        state = SwitchFading;
+        return true;
+    }
+
+    bool fading() const {
+        return state == SwitchFading;
+    }
+
+    /**
+     Mixes a chunk of the next stretcher in the current one, the gain rising by 1 / MODE_CROSSFADE_SIZE per frame.
+     - Parameters:
+     - outputs: chunk of the current stretcher, replaced by the mix
+     - inputs: same chunk of the next stretcher
+     - Returns: true once the crossfade is over: the caller swaps the stretchers, then calls finish()
+     */
+    bool mix(REAL* const* outputs, const REAL* const* inputs, size_t channels, long frames){
+        for(size_t c = 0; c < channels; ++c){
+            REAL* out = outputs[c];
+            const REAL* in = inputs[c];
+            for(long i = 0; i < frames; ++i){
+                REAL gain = (REAL)std::min(done + i + 1, (long)MODE_CROSSFADE_SIZE) / (REAL)MODE_CROSSFADE_SIZE;
+                out[i] += gain * (in[i] - out[i]);
+            }
+        }
+        done += frames;
+        return done >= MODE_CROSSFADE_SIZE;
+    }
+
+    // the stretchers are swapped: the switch job destroys the old one
+    void finish(){
+        built = next;
+        state = SwitchRetiring;
+    }
+
+private:
+    std::atomic_int state{SwitchIdle};
+    std::atomic_long requested{0};
+    std::atomic_long built{0};      // mode of the current stretcher
+    long next = 0;                  // mode of the stretcher being built or crossfaded in
+    long done = 0;                  // worker side: frames of the crossfade mixed
+};
+
+#endif /* mode_switch_hpp */
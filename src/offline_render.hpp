@@ -0,0 +1,159 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef offline_render_hpp
+#define offline_render_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+#include "stretch_modes.hpp"
+#include "common.h"
+
+/**
+ Stretch a range of a source as fast as possible, outside of the realtime queue.
+
+ Latency is compensated: the stretcher is pre-rolled with seek() and flushed at the end,
+ so output frame 0 matches source frame `start`.
+ */
+class OfflineRender {
+public:
+    struct Settings {
+        int num_channels = 1;
+        long mode = 0;
+        float sample_rate = 44100;
+        double stretch_factor = 1.0;    // source samples per output sample
+        float pitch = 0;                // semitones
+        long start = 0;                 // source range, in samples
+        long end = 0;
+    };
+
+    // fill `frames` planar frames from source frame `start`, zeros outside of the source
+    using Reader = std::function<void(REAL* const* channels, long start, long frames)>;
+    // store `frames` planar frames at output frame `offset`
+    using Writer = std::function<void(const REAL* const* channels, long offset, long frames)>;
+    // fraction of the output written, [0, 1]
+    using Progress = std::function<void(double)>;
+
+    static long outputFrames(const Settings& settings){
+        if(settings.stretch_factor <= 0 || settings.end <= settings.start)
+            return 0;
+        return (long)std::floor((double)(settings.end - settings.start) / settings.stretch_factor);
+    }
+
+    /**
+     - Returns: false if cancelled or if there is nothing to render
+     */
+    bool run(const Settings& settings, const Reader& read, const Writer& write, const Progress& progress, const std::atomic_bool& cancel){
+        const long total = outputFrames(settings);
+        if(total <= 0 || settings.num_channels <= 0)
+            return false;
+        const int nc = settings.num_channels;
+
+        signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+        configureStretch(stretch, nc, settings.mode, settings.sample_rate);
+        stretch.setTransposeSemitones(settings.pitch);
+        const long input_latency = stretch.inputLatency();
+        const long output_latency = stretch.outputLatency();
+
+        const long chunk = OUTPUT_STRETCH_BUFFER_SIZE;
+        const long max_input = std::max((long)std::ceil(chunk * settings.stretch_factor) + 1, input_latency);
+        input.resize(nc);
+        output.resize(nc);
+        input_channels.resize(nc);
+        output_channels.resize(nc);
+        shifted.resize(nc);
+        for(int c = 0; c < nc; ++c){
+            input[c].resize(max_input);
+            output[c].resize(std::max(chunk, output_latency));
+            input_channels[c] = input[c].data();
+            output_channels[c] = output[c].data();
+        }
+
+        written = 0;
+        dropped = 0;
+
+        // pre-roll: the stretcher reads inputLatency samples ahead
+        readRange(settings, read, settings.start, input_latency);
+        stretch.seek(input, (int)input_latency, settings.stretch_factor);
+
+        for(long done = 0; done < total; done += chunk){
+            if(cancel)
+                return false;
+            const long frames = std::min(chunk, total - done);
+            const long in_begin = (long)std::llround(done * settings.stretch_factor);
+            const long in_end = (long)std::llround((done + frames) * settings.stretch_factor);
+            readRange(settings, read, settings.start + input_latency + in_begin, in_end - in_begin);
+            stretch.process(input, (int)(in_end - in_begin), output, (int)frames);
+            emit(write, frames, output_latency, total);
+            if(progress)
+                progress((double)written / (double)total);
+        }
+
+        // the last outputLatency samples, without more input
+        stretch.flush(output, (int)output_latency);
+        emit(write, output_latency, output_latency, total);
+        if(progress)
+            progress(1.0);
+        return true;
+    }
+
+private:
+    // source frames in [start, start + frames), zeros past the end of the range
+    void readRange(const Settings& settings, const Reader& read, long start, long frames){
+        if(frames <= 0)
+            return;
+        read(input_channels.data(), start, frames);
+        const long valid = std::min(std::max(settings.end - start, 0L), frames);
+        for(auto& channel : input_channels)
+            std::fill(channel + valid, channel + frames, REAL(0));
+    }
+
+    // drop the first `latency` frames of the stream, write the rest up to `total`
+    void emit(const Writer& write, long frames, long latency, long total){
+        const long skip = std::min(latency - dropped, frames);
+        dropped += skip;
+        const long count = std::min(frames - skip, total - written);
+        if(count <= 0)
+            return;
+        for(size_t c = 0; c < output_channels.size(); ++c)
+            shifted[c] = output_channels[c] + skip;
+        write(shifted.data(), written, count);
+        written += count;
+    }
+
+    std::vector<std::vector<REAL>> input;
+    std::vector<std::vector<REAL>> output;
+    std::vector<REAL*> input_channels;
+    std::vector<REAL*> output_channels;
+    std::vector<const REAL*> shifted;
+    long written = 0;
+    long dropped = 0;
+};
+
+#endif /* offline_render_hpp */
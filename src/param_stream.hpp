@@ -0,0 +1,99 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#ifndef param_stream_hpp
+#define param_stream_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ Stretch parameters of one audio vector, as received by the signal inlets.
+ */
+struct ParamPoint {
+    float stretch_factor = 1.0f;
+    float pitch = 0.0f;
+};
+
+/**
+ Wait-free single producer / single consumer queue of ParamPoint.
+
+ The audio thread pushes one point per vector, the worker peeks ahead to know whether the parameters move,
+ then pops the points of the frames it renders. A full queue drops the new points: the worker is late anyway.
+ All the memory is allocated by allocate(), which must not be called while any side is running.
+ */
+class ParamStream {
+public:
+    void allocate(size_t minPoints){
+        capacity = 1;
+        while(capacity < minPoints)
+            capacity <<= 1;
+        points.assign(capacity, ParamPoint());
+        write_index = read_index = 0;
+    }
+
+    void deallocate(){
+        capacity = 0;
+        std::vector<ParamPoint>().swap(points);
+        write_index = read_index = 0;
+    }
+
+    // ----- producer
+
+    bool push(const ParamPoint& point){
+        const size_t w = write_index.load(std::memory_order_relaxed);
+        if(capacity == 0 || w - read_index.load(std::memory_order_acquire) >= capacity)
+            return false;
+        points[w & (capacity - 1)] = point;
+        write_index.store(w + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ----- consumer
+
+    size_t size() const {
+        return write_index.load(std::memory_order_acquire) - read_index.load(std::memory_order_relaxed);
+    }
+
+    // i-th point from the read head, i < size()
+    const ParamPoint& peek(size_t i) const {
+        return points[(read_index.load(std::memory_order_relaxed) + i) & (capacity - 1)];
+    }
+
+    // drop up to n points
+    void pop(size_t n){
+        const size_t available = size();
+        read_index.store(read_index.load(std::memory_order_relaxed) + (n < available ? n : available), std::memory_order_release);
+    }
+
+private:
+    size_t capacity = 0;
+    std::vector<ParamPoint> points;
+
+    alignas(64) std::atomic<size_t> write_index{0};
+    alignas(64) std::atomic<size_t> read_index{0};
+};
+
+#endif /* param_stream_hpp */
@@ -0,0 +1,163 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#ifndef planar_mirror_hpp
+#define planar_mirror_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "common.h"
+#include "deinterleave.hpp"
+
+/**
+ Immutable planar copy of an interleaved buffer, every channel aligned on 64 bytes.
+ */
+class PlanarSnapshot {
+public:
+    PlanarSnapshot(const float* interleaved, long numFrames, long numChannels)
+    : num_frames(std::max(numFrames, 0L)), num_channels(std::max(numChannels, 0L)) {
+        // 16 floats = 64 bytes between the channels, and as much to align the first one
+        stride = ((size_t)num_frames + 15) & ~(size_t)15;
+        data.assign(stride * (size_t)num_channels + 16, REAL(0));
+        offset = (size_t)(((64 - ((uintptr_t)data.data() & 63)) & 63) / sizeof(REAL));
+
+        REAL* channels[MAX_BUFFER_CHANNEL];
+        if(interleaved && num_channels <= MAX_BUFFER_CHANNEL){
+            for(long c = 0; c < num_channels; ++c)
+                channels[c] = writable(c);
+            deinterleave(interleaved, channels, (size_t)num_frames, (size_t)num_channels);
+        }
+    }
+
+    long frames() const { return num_frames; }
+    long channels() const { return num_channels; }
+    size_t bytes() const { return data.capacity() * sizeof(REAL); }
+
+    const REAL* channel(long c) const { return data.data() + offset + (size_t)c * stride; }
+
+    /**
+     Copy [start, start + count[ of every channel, zeros outside of the buffer.
+     */
+    void copy(REAL* const* output, long start, long count) const {
+        long begin = std::min(std::max(start, 0L), num_frames);
+        long end = std::min(std::max(start + count, begin), num_frames);
+        long head = std::min(std::max(begin - start, 0L), count);
+        long tail = std::min(std::max(end - start, head), count);
+        for(long c = 0; c < num_channels; ++c){
+            std::fill(output[c], output[c] + head, REAL(0));
+            std::copy(channel(c) + begin, channel(c) + end, output[c] + head);
+            std::fill(output[c] + tail, output[c] + count, REAL(0));
+        }
+    }
+
+private:
+    REAL* writable(long c) { return data.data() + offset + (size_t)c * stride; }
+
+    long num_frames = 0;
+    long num_channels = 0;
+    size_t stride = 0;
+    size_t offset = 0;
+    std::vector<REAL> data;
+};
+
+/**
+ Latest planar snapshot of a buffer~, double buffered: a rebuild happens beside the published snapshot,
+ which is swapped atomically once complete. Readers never wait for a rebuild: until then they keep reading
+ the previous snapshot (the previous contents of the buffer~), and keep the snapshot they acquired alive
+ until they are done with it, the last one frees it.
+
+ invalidate(), clear() and publish() are called from the main thread and the rebuilding job, never from the audio thread.
+ */
+class PlanarMirror {
+public:
+    // last published snapshot, possibly older than the buffer~ while a rebuild is pending (see current())
+    std::shared_ptr<const PlanarSnapshot> acquire() const {
+        return std::atomic_load(&snapshot);
+    }
+
+    // last published snapshot if it was built for the current generation, empty while a rebuild is pending
+    std::shared_ptr<const PlanarSnapshot> current() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        if(published_generation != current_generation)
+            return nullptr;
+        return std::atomic_load(&snapshot);
+    }
+
+    /**
+     The buffer has changed: the published snapshot stays readable until a new one is published.
+     - Returns: the generation a new snapshot must be built for
+     */
+    unsigned long invalidate(){
+        std::lock_guard<std::mutex> lock(mutex);
+        return ++current_generation;
+    }
+
+    /**
+     Drop the published snapshot (and its memory) when no rebuild will replace it.
+     - Returns: the generation a new snapshot must be built for
+     */
+    unsigned long clear(){
+        std::lock_guard<std::mutex> lock(mutex);
+        std::atomic_store(&snapshot, std::shared_ptr<const PlanarSnapshot>());
+        return ++current_generation;
+    }
+
+    unsigned long generation() const {
+        std::lock_guard<std::mutex> lock(mutex);
+        return current_generation;
+    }
+
+    /**
+     Publish a snapshot built for `generation` (empty: there is nothing to mirror).
+     - Returns: false (snapshot dropped) if the buffer has been invalidated since
+     */
+    bool publish(unsigned long generation, std::shared_ptr<const PlanarSnapshot> built){
+        std::lock_guard<std::mutex> lock(mutex);
+        if(generation != current_generation)
+            return false;
+        std::atomic_store(&snapshot, std::move(built));
+        published_generation = generation;
+        return true;
+    }
+
+    // memory held by the current snapshot
+    size_t bytes() const {
+        auto current = acquire();
+        return current ? current->bytes() : 0;
+    }
+
+private:
+    mutable std::mutex mutex;
+    unsigned long current_generation = 0;
+    unsigned long published_generation = 0;
+    std::shared_ptr<const PlanarSnapshot> snapshot;
+};
+
+#endif /* planar_mirror_hpp */
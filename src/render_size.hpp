@@ -0,0 +1,91 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef render_size_hpp
+#define render_size_hpp
+
+#include <algorithm>
+
+#include "common.h"
+
+/**
+ Picks the smallest render size (samples rendered per worker job) which is safe
+ with the measured render times.
+
+ A render is requested when half a render and a vector remain in the output queue,
+ it must be done before they are played: wait + render time <= RENDER_SIZE_MARGIN * remaining time.
+ Measurements are tracked as slowly decaying peaks, an underrun doubles both estimates.
+ */
+class RenderSizeTuner {
+public:
+    /**
+     - Parameters:
+     - renderSize: samples rendered
+     - renderSeconds: time spent rendering them
+     - waitSeconds: time between the request and the start of the render
+     - sampleRate: output sample rate
+     */
+    void addRender(long renderSize, double renderSeconds, double waitSeconds, double sampleRate){
+        if(renderSize <= 0 || sampleRate <= 0)
+            return;
+        sr = sampleRate;
+        load = std::max(renderSeconds * sampleRate / (double)renderSize, load * RENDER_SIZE_DECAY);
+        wait = std::max(waitSeconds, wait * RENDER_SIZE_DECAY);
+        measures++;
+    }
+
+    void addUnderrun(){
+        load = std::max(load * 2.0, 0.01);
+        wait = std::max(wait * 2.0, 0.001);
+    }
+
+    /**
+     - Returns: render size to use, fallback until enough renders have been measured
+     */
+    long renderSize(long vectorSize, long fallback = OUTPUT_STRETCH_BUFFER_SIZE) const {
+        if(measures < RENDER_SIZE_MIN_MEASURES)
+            return fallback;
+        for(long size = MIN_RENDER_SIZE; size < MAX_RENDER_SIZE; size *= 2){
+            if(size < vectorSize)
+                continue;
+            double available = RENDER_SIZE_MARGIN * (double)(size / 2 + vectorSize) / sr;
+            if(wait + load * (double)size / sr <= available)
+                return size;
+        }
+        return MAX_RENDER_SIZE;
+    }
+
+private:
+    static constexpr double RENDER_SIZE_DECAY = 0.99;
+    static constexpr double RENDER_SIZE_MARGIN = 0.5;
+    static constexpr long RENDER_SIZE_MIN_MEASURES = 8;
+
+    double sr = 44100;
+    double load = 0;        // render time / rendered duration
+    double wait = 0;        // seconds
+    long measures = 0;
+};
+
+#endif /* render_size_hpp */
@@ -0,0 +1,169 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef render_stats_hpp
+#define render_stats_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+
+/**
+ Lock-free histogram of durations, in power of 2 buckets of microseconds:
+ bucket 0 counts durations under 1 us, bucket i in [2^(i-1), 2^i[ us, the last one everything above.
+
+ add() is a few relaxed atomic operations and can be called from any thread,
+ take() reads and clears the counts (main thread): each summary covers the time since the previous one.
+ */
+class DurationHistogram {
+public:
+    static constexpr int BUCKETS = 20;     // the last one from ~0.26 s
+
+    struct Summary {
+        unsigned long long count = 0;
+        double mean_us = 0;
+        double p50_us = 0;          // upper bound of the bucket of the median
+        double p99_us = 0;
+        double max_us = 0;
+        unsigned long long buckets[BUCKETS] = {};
+    };
+
+    void add(long long nanoseconds){
+        const unsigned long long ns = (unsigned long long)std::max(nanoseconds, 0LL);
+        buckets[bucket(ns)].fetch_add(1, std::memory_order_relaxed);
+        total_ns.fetch_add(ns, std::memory_order_relaxed);
+        unsigned long long previous = max_ns.load(std::memory_order_relaxed);
+        while(ns > previous && !max_ns.compare_exchange_weak(previous, ns, std::memory_order_relaxed)){}
+    }
+
+    Summary take(){
+        Summary summary;
+        for(int b = 0; b < BUCKETS; ++b){
+            summary.buckets[b] = buckets[b].exchange(0, std::memory_order_relaxed);
+            summary.count += summary.buckets[b];
+        }
+        const unsigned long long total = total_ns.exchange(0, std::memory_order_relaxed);
+        summary.max_us = (double)max_ns.exchange(0, std::memory_order_relaxed) * 1e-3;
+        if(summary.count == 0)
+            return summary;
+        summary.mean_us = (double)total * 1e-3 / (double)summary.count;
+        summary.p50_us = std::min(percentile(summary, 0.5), summary.max_us);
+        summary.p99_us = std::min(percentile(summary, 0.99), summary.max_us);
+        return summary;
+    }
+
+    // upper bound (us) of bucket b
+    static double upperBound(int b){
+        return (double)(1ULL << b);
+    }
+
+    static int bucket(unsigned long long nanoseconds){
+        unsigned long long us = nanoseconds / 1000;
+        int b = 0;
+        while(us > 0 && b < BUCKETS - 1){
+            us >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+private:
+    static double percentile(const Summary& summary, double p){
+        const double rank = p * (double)summary.count;
+        unsigned long long seen = 0;
+        for(int b = 0; b < BUCKETS; ++b){
+            seen += summary.buckets[b];
+            if((double)seen >= rank)
+                return upperBound(b);
+        }
+        return upperBound(BUCKETS - 1);
+    }
+
+    std::atomic<unsigned long long> buckets[BUCKETS] = {};
+    std::atomic<unsigned long long> total_ns{0};
+    std::atomic<unsigned long long> max_ns{0};
+};
+
+/**
+ Runtime statistics of one instance, reported by the stats message.
+
+ Every counter is a relaxed atomic updated once per render chunk, buffer~ lock or audio vector:
+ nothing is computed until take() is called.
+ */
+class RenderStats {
+public:
+    struct Summary {
+        DurationHistogram::Summary process, extract, lock;
+        size_t queue_min = 0;       // frames queued for perform64, at the start of each vector
+        double queue_avg = 0;
+        double realtime_ratio = 0;  // rendered duration / wall-clock duration of the renders
+    };
+
+    DurationHistogram process;      // one stretch->process call
+    DurationHistogram extract;      // extraction of a block: deinterleave, resampling
+    DurationHistogram lock;         // waits on the buffer~ lock
+
+    // audio thread, once per vector
+    void addQueueDepth(size_t frames){
+        queue_sum.fetch_add(frames, std::memory_order_relaxed);
+        queue_count.fetch_add(1, std::memory_order_relaxed);
+        // stored + 1: 0 until the first vector
+        size_t previous = queue_min.load(std::memory_order_relaxed);
+        while((previous == 0 || frames + 1 < previous)
+              && !queue_min.compare_exchange_weak(previous, frames + 1, std::memory_order_relaxed)){}
+    }
+
+    // worker, once per render job
+    void addRender(size_t frames, long long nanoseconds){
+        rendered.fetch_add(frames, std::memory_order_relaxed);
+        render_ns.fetch_add((unsigned long long)std::max(nanoseconds, 0LL), std::memory_order_relaxed);
+    }
+
+    Summary take(double sampleRate){
+        Summary summary;
+        summary.process = process.take();
+        summary.extract = extract.take();
+        summary.lock = lock.take();
+        const size_t min = queue_min.exchange(0, std::memory_order_relaxed);
+        const unsigned long long sum = queue_sum.exchange(0, std::memory_order_relaxed);
+        const unsigned long long count = queue_count.exchange(0, std::memory_order_relaxed);
+        summary.queue_min = min > 0 ? min - 1 : 0;
+        summary.queue_avg = count > 0 ? (double)sum / (double)count : 0.0;
+        const unsigned long long frames = rendered.exchange(0, std::memory_order_relaxed);
+        const unsigned long long ns = render_ns.exchange(0, std::memory_order_relaxed);
+        if(ns > 0 && sampleRate > 0)
+            summary.realtime_ratio = (double)frames / sampleRate / ((double)ns * 1e-9);
+        return summary;
+    }
+
+private:
+    std::atomic<size_t> queue_min{0};
+    std::atomic<unsigned long long> queue_sum{0};
+    std::atomic<unsigned long long> queue_count{0};
+    std::atomic<unsigned long long> rendered{0};
+    std::atomic<unsigned long long> render_ns{0};
+};
+
+#endif /* render_stats_hpp */
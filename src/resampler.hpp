@@ -0,0 +1,107 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#ifndef resampler_hpp
+#define resampler_hpp
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+#include "simd.hpp"
+
+/**
+ Windowed sinc polyphase resampler, reading a planar source at any fractional position and step.
+
+ The filter bank has PHASES rows of TAPS coefficients, one per fractional position (nearest phase),
+ with a cutoff following the step: below the output Nyquist when decimating.
+ The source being random access, a stream stays phase continuous by carrying its (fractional)
+ read position from one block to the next: no block is resampled from scratch.
+ */
+class PolyphaseResampler {
+public:
+    static constexpr size_t TAPS = 32;
+    static constexpr size_t PHASES = 256;
+
+    // input frames needed before the first position and after the last one
+    // (one more after: a fraction rounding up to the next phase 0 moves the taps one frame further)
+    static long before() { return (long)(TAPS / 2) - 1; }
+    static long after() { return (long)(TAPS / 2) + 1; }
+
+    /**
+     Input frames per output sample. Rebuilds the filter bank when the cutoff changes:
+     the bank is allocated once, a rebuild does not allocate.
+     */
+    void setStep(double step){
+        const double cutoff = CUTOFF * (step > 1.0 ? 1.0 / step : 1.0);
+        if(bank.size() == TAPS * PHASES && cutoff == bank_cutoff)
+            return;
+        bank_cutoff = cutoff;
+        bank.resize(TAPS * PHASES);
+
+        const double pi = 3.14159265358979323846;
+        const double half = (double)(TAPS / 2);
+        for(size_t phase = 0; phase < PHASES; ++phase){
+            float* row = bank.data() + phase * TAPS;
+            double sum = 0.0;
+            for(size_t k = 0; k < TAPS; ++k){
+                // distance between the input frame and the interpolated position
+                double t = (double)k - (half - 1.0) - (double)phase / (double)PHASES;
+                double x = pi * cutoff * t;
+                double sinc = x == 0.0 ? 1.0 : std::sin(x) / x;
+                double window = std::fabs(t) >= half ? 0.0 : 0.42 + 0.5 * std::cos(pi * t / half) + 0.08 * std::cos(2.0 * pi * t / half);
+                row[k] = (float)(sinc * window);
+                sum += row[k];
+            }
+            // unity gain at DC for every phase
+            for(size_t k = 0; k < TAPS; ++k)
+                row[k] = (float)(row[k] / sum);
+        }
+    }
+
+    /**
+     output[i] = input interpolated at position + i * step, filtered for the last setStep().
+
+     - Parameters:
+     - input: planar channel, readable from floor(position) - before() to floor(last position) + after()
+     - output: numSamples samples
+     - position: fractional position of the first output sample in input
+     - step: input frames per output sample
+     */
+    void process(const float* input, REAL* output, size_t numSamples, double position, double step) const {
+        getSimdKernels().resample(input, output, numSamples, position, step, bank.data(), TAPS, PHASES);
+    }
+
+    const std::vector<float>& filterBank() const { return bank; }
+
+private:
+    // transition band kept below Nyquist
+    static constexpr double CUTOFF = 0.92;
+
+    std::vector<float> bank;
+    double bank_cutoff = 0.0;
+};
+
+#endif /* resampler_hpp */
@@ -0,0 +1,75 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef reset_request_hpp
+#define reset_request_hpp
+
+#include <atomic>
+
+/**
+ Reset of the stretcher, requested from any thread and serviced by the render worker.
+
+ A request is a counter increment: lock-free, allocation free, callable from the audio thread.
+ The worker services every request made since its last check at once and tags the chunks it renders
+ afterwards with the generation returned, so the consumer can drop the chunks rendered before the request.
+ */
+class ResetRequest {
+public:
+    // any thread
+    void request(){
+        requested.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    // generation of the last request
+    unsigned long generation() const {
+        return requested.load(std::memory_order_acquire);
+    }
+
+    // consumer: the chunk has been rendered before the last request
+    bool stale(unsigned long chunkGeneration) const {
+        return chunkGeneration < generation();
+    }
+
+    /**
+     Worker side, before rendering a chunk.
+     - Parameters:
+     - chunkGeneration: set to the generation of the chunks rendered from now on
+     - Returns: true if the stretcher has to be reset first
+     */
+    bool service(unsigned long& chunkGeneration){
+        const unsigned long last = requested.load(std::memory_order_acquire);
+        chunkGeneration = last;
+        if(last == serviced)
+            return false;
+        serviced = last;
+        return true;
+    }
+
+private:
+    std::atomic<unsigned long> requested{0};
+    unsigned long serviced = 0;     // worker side
+};
+
+#endif /* reset_request_hpp */
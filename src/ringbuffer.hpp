@@ -0,0 +1,251 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+#ifndef ringbuffer_hpp
+#define ringbuffer_hpp
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+
+/**
+ Position metadata travelling with every chunk pushed in a PlanarRingBuffer.
+ */
+struct ChunkInfo {
+    long position = 0;      // buffer position (in samples) of the first frame of the chunk
+    long length = 0;        // input samples consumed to render the whole chunk
+    long blocksize = 0;     // stretch blocksize (input samples + input latency)
+    unsigned long generation = 0;   // seek generation the chunk was rendered for
+    unsigned long reset = 0;        // reset generation the chunk was rendered for
+};
+
+/**
+ Wait-free single producer / single consumer planar ring buffer.
+
+ The producer (worker thread) pushes whole chunks of planar audio with their ChunkInfo,
+ the consumer (audio thread) reads any number of frames and can query the position of its read head.
+ All the memory is allocated by allocate(), which must not be called while any side is running.
+ */
+template<typename T>
+class PlanarRingBuffer {
+public:
+    struct Chunk {
+        ChunkInfo info;
+        size_t start = 0;   // absolute frame index of the first frame
+        size_t frames = 0;
+    };
+
+    /**
+     - Parameters:
+     - numChannels: number of planar channels
+     - minFrames: capacity in frames (rounded up to a power of 2)
+     - minChunks: max number of chunks in flight (rounded up to a power of 2)
+     */
+    void allocate(size_t numChannels, size_t minFrames, size_t minChunks = 64){
+        num_channels = numChannels;
+        frame_capacity = roundPow2(minFrames);
+        chunk_capacity = roundPow2(minChunks);
+        data.assign(num_channels * frame_capacity, T(0));
+        chunks.assign(chunk_capacity, Chunk());
+        write_frame = read_frame = 0;
+        write_chunk = read_chunk = 0;
+    }
+
+    void deallocate(){
+        num_channels = frame_capacity = chunk_capacity = 0;
+        std::vector<T>().swap(data);
+        std::vector<Chunk>().swap(chunks);
+        write_frame = read_frame = 0;
+        write_chunk = read_chunk = 0;
+    }
+
+    size_t channels() const { return num_channels; }
+    size_t capacity() const { return frame_capacity; }
+
+    // ----- producer
+
+    size_t writeAvailable() const {
+        return frame_capacity - (write_frame.load(std::memory_order_relaxed) - read_frame.load(std::memory_order_acquire));
+    }
+
+    /**
+     Push a whole chunk, or nothing if there is not enough room.
+     Channels of the ring not provided by the input (c >= numInputChannels) are filled with zeros.
+     */
+    bool push(const T* const* input, size_t numInputChannels, size_t frames, const ChunkInfo& info){
+        const size_t wf = write_frame.load(std::memory_order_relaxed);
+        const size_t wc = write_chunk.load(std::memory_order_relaxed);
+        if(frames == 0 || frames > writeAvailable())
+            return false;
+        if(wc - read_chunk.load(std::memory_order_acquire) >= chunk_capacity)
+            return false;
+
+        const size_t offset = wf & (frame_capacity - 1);
+        const size_t first = std::min(frames, frame_capacity - offset);
+        for(size_t c = 0; c < num_channels; ++c){
+            T* channel = data.data() + c * frame_capacity;
+            if(c < numInputChannels && input){
+                std::copy(input[c], input[c] + first, channel + offset);
+                std::copy(input[c] + first, input[c] + frames, channel);
+            }
+            else{
+                std::fill(channel + offset, channel + offset + first, T(0));
+                std::fill(channel, channel + (frames - first), T(0));
+            }
+        }
+
+        Chunk& chunk = chunks[wc & (chunk_capacity - 1)];
+        chunk.info = info;
+        chunk.start = wf;
+        chunk.frames = frames;
+
+        // frames first: a chunk visible to current() always has its frames readable
+        write_frame.store(wf + frames, std::memory_order_release);
+        write_chunk.store(wc + 1, std::memory_order_release);
+        return true;
+    }
+
+    // ----- consumer
+
+    size_t readAvailable() const {
+        return write_frame.load(std::memory_order_acquire) - read_frame.load(std::memory_order_relaxed);
+    }
+
+    /**
+     Chunk containing the read head.
+
+     - Parameters:
+     - chunk: current chunk
+     - offset: frames already read in this chunk
+     - Returns: false if the ring is empty
+     */
+    bool current(Chunk& chunk, size_t& offset) const {
+        const size_t rc = read_chunk.load(std::memory_order_relaxed);
+        if(rc == write_chunk.load(std::memory_order_acquire))
+            return false;
+        chunk = chunks[rc & (chunk_capacity - 1)];
+        offset = read_frame.load(std::memory_order_relaxed) - chunk.start;
+        return true;
+    }
+
+    /**
+     Read up to `frames` frames into `output` (converting to U) and release them to the producer.
+     Output channels >= channels() are left untouched.
+     - Returns: number of frames read
+     */
+    template<typename U>
+    size_t read(U* const* output, size_t numOutputChannels, size_t frames){
+        return read(output, numOutputChannels, frames, [](const T* input, U* out, size_t n){
+            std::copy(input, input + n, out);
+        });
+    }
+
+    /**
+     Same as read(), each contiguous run of samples is copied with `copy(const T* input, U* output, size_t n)`.
+     */
+    template<typename U, typename Copy>
+    size_t read(U* const* output, size_t numOutputChannels, size_t frames, Copy copy){
+        const size_t rf = read_frame.load(std::memory_order_relaxed);
+        frames = std::min(frames, readable());
+        if(frames == 0)
+            return 0;
+
+        const size_t offset = rf & (frame_capacity - 1);
+        const size_t first = std::min(frames, frame_capacity - offset);
+        const size_t nc = std::min(num_channels, numOutputChannels);
+        for(size_t c = 0; c < nc; ++c){
+            const T* channel = data.data() + c * frame_capacity;
+            copy(channel + offset, output[c], first);
+            copy(channel, output[c] + first, frames - first);
+        }
+        release(rf + frames);
+        return frames;
+    }
+
+    /**
+     Drop up to `frames` frames without reading them (consumer side only).
+     - Returns: number of frames dropped
+     */
+    size_t drop(size_t frames){
+        frames = std::min(frames, readable());
+        release(read_frame.load(std::memory_order_relaxed) + frames);
+        return frames;
+    }
+
+    /**
+     Drop every readable frame (consumer side only).
+     */
+    void flush(){
+        release(write_frame.load(std::memory_order_acquire));
+    }
+
+private:
+    static size_t roundPow2(size_t n){
+        size_t p = 1;
+        while(p < n)
+            p <<= 1;
+        return p;
+    }
+
+    // consumer side: frames of the published chunks, so no frame is read before current() can tell its chunk
+    size_t readable() const {
+        const size_t rc = read_chunk.load(std::memory_order_relaxed);
+        const size_t wc = write_chunk.load(std::memory_order_acquire);
+        if(rc == wc)
+            return 0;
+        // not reused while chunk rc is unread
+        const Chunk& last = chunks[(wc - 1) & (chunk_capacity - 1)];
+        return last.start + last.frames - read_frame.load(std::memory_order_relaxed);
+    }
+
+    // move the read head to `frame` and pop the chunks fully read
+    void release(size_t frame){
+        size_t rc = read_chunk.load(std::memory_order_relaxed);
+        const size_t wc = write_chunk.load(std::memory_order_acquire);
+        while(rc != wc){
+            const Chunk& chunk = chunks[rc & (chunk_capacity - 1)];
+            if(chunk.start + chunk.frames > frame)
+                break;
+            ++rc;
+        }
+        read_chunk.store(rc, std::memory_order_release);
+        read_frame.store(frame, std::memory_order_release);
+    }
+
+    size_t num_channels = 0;
+    size_t frame_capacity = 0;
+    size_t chunk_capacity = 0;
+    std::vector<T> data;
+    std::vector<Chunk> chunks;
+
+    alignas(64) std::atomic<size_t> write_frame{0};
+    std::atomic<size_t> write_chunk{0};
+    alignas(64) std::atomic<size_t> read_frame{0};
+    std::atomic<size_t> read_chunk{0};
+};
+
+#endif /* ringbuffer_hpp */
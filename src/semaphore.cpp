@@ -0,0 +1,122 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "semaphore.hpp"
+
+#include <climits>
+
+#if defined(_WIN32)
+    #include <windows.h>
+#elif defined(__linux__)
+    #include <linux/futex.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#if defined(__APPLE__)
+
+OsSemaphore::OsSemaphore(){
+    semaphore = dispatch_semaphore_create(0);
+}
+
+OsSemaphore::~OsSemaphore(){
+    dispatch_release(semaphore);
+}
+
+void OsSemaphore::signal(int count){
+    while(count-- > 0)
+        dispatch_semaphore_signal(semaphore);
+}
+
+void OsSemaphore::wait(){
+    dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER);
+}
+
+#elif defined(_WIN32)
+
+OsSemaphore::OsSemaphore(){
+    semaphore = CreateSemaphore(nullptr, 0, LONG_MAX, nullptr);
+}
+
+OsSemaphore::~OsSemaphore(){
+    CloseHandle(semaphore);
+}
+
+void OsSemaphore::signal(int count){
+    ReleaseSemaphore(semaphore, count, nullptr);
+}
+
+void OsSemaphore::wait(){
+    WaitForSingleObject(semaphore, INFINITE);
+}
+
+#elif defined(__linux__)
+
+static long futex(std::atomic_int* address, int op, int value){
+    return syscall(SYS_futex, reinterpret_cast<int*>(address), op, value, nullptr, nullptr, 0);
+}
+
+OsSemaphore::OsSemaphore(){}
+
+OsSemaphore::~OsSemaphore(){}
+
+void OsSemaphore::signal(int count){
+    value.fetch_add(count, std::memory_order_release);
+    futex(&value, FUTEX_WAKE_PRIVATE, count);
+}
+
+void OsSemaphore::wait(){
+    while(true){
+        int current = value.load(std::memory_order_relaxed);
+        while(current > 0){
+            if(value.compare_exchange_weak(current, current - 1, std::memory_order_acquire))
+                return;
+        }
+        // sleeps only if value is still 0
+        futex(&value, FUTEX_WAIT_PRIVATE, 0);
+    }
+}
+
+#else
+
+OsSemaphore::OsSemaphore(){}
+
+OsSemaphore::~OsSemaphore(){}
+
+void OsSemaphore::signal(int count){
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        value += count;
+    }
+    cv.notify_all();
+}
+
+void OsSemaphore::wait(){
+    std::unique_lock<std::mutex> lock(mutex);
+    cv.wait(lock, [this](){ return value > 0; });
+    value--;
+}
+
+#endif
@@ -0,0 +1,116 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef semaphore_hpp
+#define semaphore_hpp
+
+#include <atomic>
+
+#include "trace.hpp"
+
+#if defined(__APPLE__)
+    #include <dispatch/dispatch.h>
+#elif defined(_WIN32)
+    // HANDLE, without including windows.h in every translation unit
+    typedef void* HANDLE;
+#elif !defined(__linux__)
+    #include <condition_variable>
+    #include <mutex>
+#endif
+
+/**
+ Counting semaphore of the platform: futex on Linux, dispatch on macOS, kernel semaphore on Windows.
+ Every call is a syscall, use Semaphore instead.
+ */
+class OsSemaphore {
+public:
+    OsSemaphore();
+    ~OsSemaphore();
+    OsSemaphore(const OsSemaphore&) = delete;
+    OsSemaphore& operator=(const OsSemaphore&) = delete;
+
+    void signal(int count = 1);
+    void wait();
+
+private:
+#if defined(__APPLE__)
+    dispatch_semaphore_t semaphore;
+#elif defined(_WIN32)
+    HANDLE semaphore;
+#elif defined(__linux__)
+    std::atomic_int value{0};
+#else
+    std::mutex mutex;
+    std::condition_variable cv;
+    int value = 0;
+#endif
+};
+
+/**
+ Semaphore only entering the kernel when a thread is actually sleeping on it:
+ signal() is a single atomic add when nobody waits, so it can be called from the audio thread.
+ */
+class Semaphore {
+public:
+    void signal(int count = 1){
+        int previous = value.fetch_add(count, std::memory_order_release);
+        int to_wake = previous < 0 ? (-previous < count ? -previous : count) : 0;
+        if(to_wake > 0){
+            syscall_count.fetch_add(1, std::memory_order_relaxed);
+            os.signal(to_wake);
+        }
+    }
+
+    bool tryWait(){
+        int current = value.load(std::memory_order_relaxed);
+        while(current > 0){
+            if(value.compare_exchange_weak(current, current - 1, std::memory_order_acquire))
+                return true;
+        }
+        return false;
+    }
+
+    void wait(){
+        // spin a little before sleeping: wakeups usually come right after a render
+        for(int i = 0; i < 64; ++i){
+            if(tryWait())
+                return;
+        }
+        if(value.fetch_sub(1, std::memory_order_acquire) <= 0){
+            TRACE_SCOPE("semaphore_wait", 0);
+            os.wait();
+        }
+    }
+
+    // number of signals which had to wake a sleeping thread
+    unsigned long long syscalls() const { return syscall_count.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic_int value{0};           // < 0: number of sleeping threads
+    std::atomic<unsigned long long> syscall_count{0};
+    OsSemaphore os;
+};
+
+#endif /* semaphore_hpp */
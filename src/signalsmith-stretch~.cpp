@@ -33,15 +33,11 @@
  */
 
 
+#include <chrono>
+#include <cmath>
 #include <cstddef>
 #include <thread>
 
-#if __APPLE__
-#include <dispatch/dispatch.h>
-#elif defined(__WIN32)
-#include <windows.h>
-#endif
-
 
 #include "../signalsmith-stretch/signalsmith-stretch.h"
 
@@ -51,15 +47,65 @@
 #include "ext_common.h" // contains CLAMP macro
 #include "z_dsp.h"
 #include "ext_buffer.h"
-#include <future>
 #include <shared_mutex>
-#include <deque>
 
+#include "analysis_cache.hpp"
+#include "capture_ring.hpp"
+#include "channel_groups.hpp"
 #include "deinterleave.hpp"
+#include "mapped_file.hpp"
+#include "mode_switch.hpp"
+#include "offline_render.hpp"
+#include "param_stream.hpp"
+#include "planar_mirror.hpp"
+#include "ringbuffer.hpp"
+#include "trace.hpp"
+#include "render_size.hpp"
+#include "render_stats.hpp"
+#include "reset_request.hpp"
+#include "resampler.hpp"
+#include "simd.hpp"
+#include "stretch_modes.hpp"
+#include "worker_pool.hpp"
 #include "common.h"
 
 using namespace signalsmith::stretch;
 
+/**
+ Source read from a file instead of the buffer~ (file message).
+ */
+struct FileSource {
+    std::unique_ptr<MappedAudioFile> file;
+    std::unique_ptr<FilePrefetcher> prefetcher;     // destroyed first
+};
+
+/**
+ Mode switch, see signalsmith_switch.
+ Idle -> Building (pool) -> Ready -> Fading (worker) -> Retiring -> Idle (pool)
+ */
+
+/**
+ Chunks synthesised from STFT frames instead of stretched (see SpectralSynth). Hyper: from the analysis cache,
+ stretch factors below HYPER_STRETCH_FACTOR (0 included). Freeze: stretch_factor 0 without analysis,
+ from two frames captured at the freeze point. The stretcher only renders the chunks crossfading in and out.
+ */
+enum SpectralPath { SpectralOff, SpectralHyper, SpectralFreeze };
+
+/**
+ Attribute values published to the worker and to perform64.
+ The attribute fields themselves only belong to the main thread.
+ */
+struct StretchParams {
+    std::atomic<float> stretch_factor{1.0f};
+    std::atomic<float> pitch{0.0f};
+    std::atomic_bool resample{true};
+    std::atomic_bool mirror{true};
+    std::atomic_bool auto_render_size{false};
+    std::atomic_bool live{false};
+    std::atomic_int live_policy{LiveFollow};
+    std::atomic_bool analysis{false};
+};
+
 typedef struct _signalsmith {
     t_pxobject l_obj;
     void* info_outlet;
@@ -69,33 +115,143 @@ typedef struct _signalsmith {
         
     t_buffer_ref *l_buffer_ref = nullptr;
     std::atomic_long buffer_nc {0};
-
-    std::unique_ptr<SignalsmithStretch<REAL>> stretch;
+    
+    // planar copy of the source buffer~, rebuilt on the pool when the buffer~ is bound or modified
+    long mirror_enabled = 1;                // attribute "mirror"
+    std::unique_ptr<PlanarMirror> mirror;
+    std::unique_ptr<PoolJob> mirror_job;
+    std::shared_ptr<const PlanarSnapshot> render_snapshot;  // worker side: held during a render
+    
+    // file source (file message), replaces the buffer~ when set. Swapped atomically, the worker holds it during a render
+    std::shared_ptr<FileSource> file_source;
+    std::shared_ptr<FileSource> render_file;    // worker side
+
+    // spectral analysis of the mirror (analysis attribute), computed once by the pool: stretch factors
+    // below HYPER_STRETCH_FACTOR are synthesised from it instead of being re-analysed by the stretcher
+    long analysis_enabled = 0;              // attribute "analysis"
+    t_symbol *analysis_folder = nullptr;    // attribute: folder of the sidecar files, empty: in memory only
+    std::atomic<t_symbol*> analysis_path{nullptr};  // analysis_folder as a native path, read by the pool
+    t_symbol *buffer_name = nullptr;        // names the sidecar files
+    std::unique_ptr<AnalysisCache> analysis;
+    std::unique_ptr<PoolJob> analysis_job;  // starts the analysis of the current mirror
+    std::vector<std::unique_ptr<PoolJob>> analysis_slice_jobs;  // one per pool thread, one slice per run
+    std::shared_ptr<AnalysisBuild> analysis_build;  // running build, swapped atomically
+    t_qelem *analysis_qelem = nullptr;      // reports a published analysis on the main thread
+    std::shared_ptr<const SpectralAnalysis> render_analysis;   // worker side: held during a render
+    
+    // spectral paths (see SpectralPath), worker side
+    std::unique_ptr<SpectralSynth> spectral_synth;
+    int spectral_path = SpectralOff;        // path of the last chunk
+    bool spectral_restart = false;          // the next synthesis starts over (seek, reset)
+    std::shared_ptr<const SpectralAnalysis> spectral_analysis;  // frames of the last hyper-stretch synthesis, kept alive to compare
+    std::vector<std::vector<REAL>> spectral_buffer;
+    std::vector<REAL*> spectral_outputs;
+    std::unique_ptr<SpectralAnalyser> freeze_analyser;
+    SpectralLayout freeze_layout;
+    std::vector<SpectralBin> freeze_frames; // 2 frames of stretcher_channels channels, a hop apart
+    std::vector<std::vector<REAL>> freeze_input;    // source frames around the freeze point, buffer_nc channels
+    bool freeze_captured = false;           // freeze_frames are the ones of the current freeze point
+
+    // live input (live attribute): the inlets after pitch are captured and stretched in place of the buffer~
+    long live = 0;                          // attribute
+    long live_size = LIVE_CAPTURE_MS;       // attribute: ms of input kept, applied by dsp64
+    long live_policy = LiveFollow;          // attribute, see LivePolicy
+    std::atomic_bool live_connected{false}; // audio side: a live inlet has a signal and the capture ring is sized for it
+    bool live_inlets = false;               // set by dsp64: a live inlet has a signal
+    size_t capture_frames = 0;              // capture ring size wanted by dsp64, see signalsmith_capture_resize
+    t_qelem *capture_qelem = nullptr;       // resizes the capture ring on the main thread, without waiting for a render
+    CaptureRing<REAL> capture;              // perform64 -> worker, l_chan channels, allocated by signalsmith_capture_resize
+    bool render_live = false;               // worker side: the render reads the capture ring
+
+    std::vector<StretchGroup> stretch_groups;  // empty: no stretcher
+    
+    // mode switch: the stretcher of the new mode is built on the pool, then crossfaded in by the worker
+    ModeSwitch mode_switch;                 // last mode set, state of the switch, crossfade
+    std::unique_ptr<PoolJob> switch_job;    // builds next_groups, destroys retired_groups
+    std::vector<StretchGroup> next_groups;  // Ready, Fading: the stretcher fading in
+    std::vector<StretchGroup> retired_groups;   // Retiring: the stretcher faded out
+    std::vector<std::vector<REAL>> crossfade_buffer;
+    std::vector<REAL*> crossfade_outputs;
+    std::vector<const REAL*> crossfade_inputs;
+    long groups = 1;                        // attribute: max number of channel groups rendered in parallel
     long mode = 0;
     float stretch_factor = 1.0f;
     float pitch = 0.0f;
-    long sample_position;
-    long stretch_blocksize = 0;
-
-#ifdef __APPLE__
-    dispatch_semaphore_t chunks_semaphore;
-    dispatch_semaphore_t process_semaphore;
-#elif defined(_WIN32)
-    HANDLE chunks_hSemaphore;
-    HANDLE process_hSemaphore;
-#endif
+    long sample_position;                   // attribute storage, see current_position
+    StretchParams params;                   // attributes, as read by the worker and perform64
+    std::atomic_long current_position{0};   // position of the next block, written by the worker
+    std::atomic_long input_latency{0};      // latencies of the current stretcher, for the message thread
+    std::atomic_long output_latency{0};
+    long stretcher_channels = 0;            // channels of the current stretcher
+    t_qelem *rebuild_qelem = nullptr;       // recreates the stretcher on the main thread, without waiting for a render
+    double read_position = 0;               // worker side: buffer position of the next block, fractional when resampling
+    long resample = 1;                      // attribute: buffer~ / DSP sample rate mismatch, 1: resample, 0: fold in stretch and pitch
+    PolyphaseResampler resampler;           // worker side
+    std::vector<std::vector<REAL>> source_buffer;  // buffer~ frames around a resampled block
+    std::atomic_long stretch_blocksize{0};
+
+    long latency = OUTPUT_STRETCH_BUFFER_SIZE;  // render size attribute, 0: automatic
+    std::atomic_long render_size{OUTPUT_STRETCH_BUFFER_SIZE}; // samples rendered by a job
+    RenderSizeTuner render_tuner;           // worker side, for the automatic render size
+    std::atomic<long long> request_time{0}; // steady clock (ns) of the last render request
+    unsigned long long tuner_underruns = 0;
     
-    std::deque<std::vector<std::vector<REAL>>> output_blocks;
-    std::deque<long> output_positions;
-    std::atomic_int num_blocks;
-    int blocksize;
+    std::unique_ptr<PoolJob> render_job;    // renders render_size samples on the shared pool
+    std::vector<std::vector<REAL>> extracted_buffer;
+    std::vector<std::vector<REAL>> rendered_buffer;
+    std::vector<const REAL*> rendered_channels;
+    std::vector<const REAL*> extracted_inputs;  // per render: extracted_buffer or mirror channels, for the groups
+    std::vector<REAL*> rendered_outputs;
+    long group_input_samples = 0;           // per render: samples processed by every group
+    long group_output_samples = 0;
+    std::unique_ptr<Semaphore> groups_done; // signaled by each group job
+    
+    // signal inlets for stretch_factor and pitch: when connected, one point per vector is streamed to the worker
+    bool stretch_signal = false;            // audio side, set by dsp64
+    bool pitch_signal = false;
+    std::atomic_bool param_signals{false};  // one of them is connected
+    ParamStream param_stream;               // perform64 -> worker
+    ParamPoint param_current;               // worker side: parameters of the last chunk
+    
+    PlanarRingBuffer<REAL> output_ring;     // worker -> perform64, l_chan channels
+    std::atomic_bool render_pending{false}; // a render has been requested to the worker
+    std::atomic_int blocksize{0};
     long last_position;
     
-    std::atomic_bool running{false};
-    std::future<void> task_stretch;
-    std::future<void> task_reset;
-
-    t_critical critical_output_blocks, critical_input_buffer, critical_sema_buffer;
+    std::atomic<unsigned long long> underruns{0}; // vectors not (fully) delivered by the worker
+    bool playing = false;                    // frames have been read since the last flush
+    std::vector<double> last_samples;        // last output sample per channel, for the underrun fade
+    
+    ResetRequest reset_request;             // any thread -> worker, perform64 drops the frames rendered before
+
+    // seek: position changes, applied by the worker and played by perform64
+    std::atomic_long seek_target{0};
+    std::atomic<unsigned long> seek_generation{0};  // incremented by each seek
+    unsigned long rendered_generation = 0;          // worker side
+    unsigned long played_generation = 0;            // perform64 side
+    std::atomic<long long> seek_time{0};            // steady clock (ns) of the last seek
+    std::atomic<long long> seek_latency{0};         // ns between the last seek and its first frame played
+    t_qelem *seek_qelem = nullptr;                  // reports seek_latency on the main thread
+    std::vector<std::vector<REAL>> preroll_buffer;  // input latency frames per channel, grown by a mode switch
+    std::vector<REAL*> preroll_channels;
+
+    // runtime statistics: stats message, and every stats_interval ms when > 0
+    std::unique_ptr<RenderStats> stats;
+    long stats_interval = 0;                // attribute, ms
+    t_clock *stats_clock = nullptr;
+
+    // offline render (render message)
+    std::thread offline_thread;
+    std::atomic_bool offline_cancel{false};
+    std::atomic_bool offline_done{false};       // the thread has finished, join it from the main thread
+    bool offline_complete = false;              // written by the thread before offline_done
+    std::atomic<double> offline_progress{0};
+    t_buffer_ref *offline_target_ref = nullptr;
+    t_symbol *offline_target = nullptr;
+    long offline_frames = 0;
+    t_qelem *offline_qelem = nullptr;           // progress and completion, reported on the main thread
+
+    t_critical critical_input_buffer;
 } t_signalsmith;
 
 
@@ -106,6 +262,7 @@ void *signalsmith_new(t_symbol *s_input, long chan, long mode);
 void signalsmith_free(t_signalsmith *x);
 
 void signalsmith_update_buffer(t_signalsmith *x);
+void signalsmith_file(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv);
 t_max_err signalsmith_notify(t_signalsmith *x, t_symbol *s, t_symbol *msg, void *sender, void *data);
 void signalsmith_dblclick(t_signalsmith *x);
 
@@ -113,23 +270,83 @@ void signalsmith_assist(t_signalsmith *x, void *b, long m, long a, char *s);
 
 void signalsmith_create_stretcher(t_signalsmith *x, long num_channels, long mode);
 void signalsmith_delete_stretcher(t_signalsmith *x);
+std::vector<StretchGroup> signalsmith_build_groups(t_signalsmith *x, long num_channels, long mode, const REAL** inputs, REAL** outputs);
+void signalsmith_remove_groups(std::vector<StretchGroup>& groups);
+void signalsmith_switch(t_signalsmith *x);
+void signalsmith_crossfade(t_signalsmith *x, long frames);
+bool signalsmith_spectral(t_signalsmith *x, int path, REAL** outputs, long frames, double step, float transpose);
+bool signalsmith_freeze_capture(t_signalsmith *x, double source_step);
+void signalsmith_spectral_crossfade(t_signalsmith *x, long frames, bool entering);
+void signalsmith_render(t_signalsmith *x);
+long signalsmith_next_params(t_signalsmith *x, long render_size, float &stretch_factor, float &pitch);
+void signalsmith_process_group(t_signalsmith *x, StretchGroup& group);
+void signalsmith_preroll(t_signalsmith *x, std::vector<StretchGroup>& groups, double position, double step);
+void signalsmith_seek_report(t_signalsmith *x);
+void signalsmith_quit(void);
 
 t_max_err signalsmith_stretch_factor_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
 t_max_err signalsmith_pitch_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
 t_max_err signalsmith_position_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
 t_max_err signalsmith_mode_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_latency_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_groups_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_resample_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_position_get(t_signalsmith *x, t_object *attr, long *argc, t_atom **argv);
+t_max_err signalsmith_live_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_live_size_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_live_policy_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
 
 void signalsmith_get_input_latency(t_signalsmith *x);
 void signalsmith_get_output_latency(t_signalsmith *x);
+void signalsmith_get_underruns(t_signalsmith *x);
+void signalsmith_get_render_size(t_signalsmith *x);
+void signalsmith_stats(t_signalsmith *x);
+void signalsmith_trace_dump(t_signalsmith *x, t_symbol *s);
+void signalsmith_stats_tick(t_signalsmith *x);
+t_max_err signalsmith_stats_interval_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
 void signalsmith_reset(t_signalsmith *x);
+void signalsmith_rebuild(t_signalsmith *x);
+void signalsmith_capture_resize(t_signalsmith *x);
 void signalsmith_buffer_notify(t_signalsmith *x);
-std::tuple<bool, long> signalsmith_extract_samples(t_signalsmith *x,
-                                                   std::vector<std::vector<REAL>> &output,
-                                                   long position,
-                                                   long blocksize,
-                                                   long min_blocksize = 4);
+void signalsmith_get_mirror_memory(t_signalsmith *x);
+void signalsmith_mirror_invalidate(t_signalsmith *x);
+void signalsmith_mirror_build(t_signalsmith *x);
+t_max_err signalsmith_mirror_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_analysis_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+t_max_err signalsmith_analysis_folder_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv);
+void signalsmith_analysis_invalidate(t_signalsmith *x);
+void signalsmith_analysis_start(t_signalsmith *x);
+void signalsmith_analysis_slice(t_signalsmith *x, size_t index);
+void signalsmith_analysis_report(t_signalsmith *x);
+
+void signalsmith_offline_render(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv);
+void signalsmith_offline_start(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv);
+void signalsmith_offline_cancel(t_signalsmith *x);
+void signalsmith_offline_report(t_signalsmith *x);
+void signalsmith_read_buffer(t_buffer_ref *ref, REAL* const* channels, long num_channels, long start, long frames);
+void signalsmith_write_buffer(t_buffer_ref *ref, const REAL* const* channels, long num_channels, long offset, long frames);
+std::tuple<bool, double> signalsmith_extract_samples(t_signalsmith *x,
+                                                     const REAL** inputs,
+                                                     double position,
+                                                     long input_latency,
+                                                     long blocksize,
+                                                     double step = 1.0,
+                                                     long min_blocksize = 4);
+void signalsmith_read_source(t_signalsmith *x, t_buffer_obj *buffer, REAL* const* channels, double start, long frames, double step);
+double signalsmith_source_step(t_signalsmith *x);
 static t_class *signalsmith_class;
 
+static double signalsmith_mean(const double *signal, long n){
+    double sum = 0.0;
+    for(long i = 0; i < n; ++i)
+        sum += signal[i];
+    return n > 0 ? sum / (double)n : 0.0;
+}
+
+static long long now_ns(){
+    return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
 void ext_main(void *r)
 {
     t_class *c = class_new("signalsmith-stretch~", 
@@ -148,10 +365,41 @@ void ext_main(void *r)
     CLASS_ATTR_ACCESSORS(c, "pitch", NULL, signalsmith_pitch_set);
     
     CLASS_ATTR_LONG(c, "position", 0, t_signalsmith, sample_position);
-    CLASS_ATTR_ACCESSORS(c, "position", NULL, signalsmith_position_set);
+    CLASS_ATTR_ACCESSORS(c, "position", signalsmith_position_get, signalsmith_position_set);
 
     CLASS_ATTR_LONG(c, "mode", 0, t_signalsmith, mode);
     CLASS_ATTR_ACCESSORS(c, "mode", NULL, signalsmith_mode_set);
+    
+    CLASS_ATTR_LONG(c, "latency", 0, t_signalsmith, latency);
+    CLASS_ATTR_ACCESSORS(c, "latency", NULL, signalsmith_latency_set);
+    
+    CLASS_ATTR_LONG(c, "resample", 0, t_signalsmith, resample);
+    CLASS_ATTR_ACCESSORS(c, "resample", NULL, signalsmith_resample_set);
+    
+    CLASS_ATTR_LONG(c, "mirror", 0, t_signalsmith, mirror_enabled);
+    CLASS_ATTR_ACCESSORS(c, "mirror", NULL, signalsmith_mirror_set);
+    
+    CLASS_ATTR_LONG(c, "groups", 0, t_signalsmith, groups);
+    CLASS_ATTR_ACCESSORS(c, "groups", NULL, signalsmith_groups_set);
+    
+    CLASS_ATTR_LONG(c, "stats_interval", 0, t_signalsmith, stats_interval);
+    CLASS_ATTR_ACCESSORS(c, "stats_interval", NULL, signalsmith_stats_interval_set);
+    
+    CLASS_ATTR_LONG(c, "live", 0, t_signalsmith, live);
+    CLASS_ATTR_ACCESSORS(c, "live", NULL, signalsmith_live_set);
+    
+    CLASS_ATTR_LONG(c, "live_size", 0, t_signalsmith, live_size);
+    CLASS_ATTR_ACCESSORS(c, "live_size", NULL, signalsmith_live_size_set);
+    
+    CLASS_ATTR_LONG(c, "live_policy", 0, t_signalsmith, live_policy);
+    CLASS_ATTR_ENUMINDEX(c, "live_policy", 0, "follow hold drift");
+    CLASS_ATTR_ACCESSORS(c, "live_policy", NULL, signalsmith_live_policy_set);
+    
+    CLASS_ATTR_LONG(c, "analysis", 0, t_signalsmith, analysis_enabled);
+    CLASS_ATTR_ACCESSORS(c, "analysis", NULL, signalsmith_analysis_set);
+    
+    CLASS_ATTR_SYM(c, "analysis_folder", 0, t_signalsmith, analysis_folder);
+    CLASS_ATTR_ACCESSORS(c, "analysis_folder", NULL, signalsmith_analysis_folder_set);
 
     class_addmethod(c, (method)signalsmith_dsp64, "dsp64", A_CANT, 0);
     class_addmethod(c, (method)signalsmith_assist, "assist", A_CANT, 0);
@@ -160,22 +408,26 @@ void ext_main(void *r)
     class_addmethod(c, (method)signalsmith_reset, "reset", 0);
     class_addmethod(c, (method)signalsmith_get_input_latency, "get_input_latency", 0);
     class_addmethod(c, (method)signalsmith_get_output_latency, "get_output_latency", 0);
+    class_addmethod(c, (method)signalsmith_get_underruns, "get_underruns", 0);
+    class_addmethod(c, (method)signalsmith_get_render_size, "get_render_size", 0);
+    class_addmethod(c, (method)signalsmith_get_mirror_memory, "get_mirror_memory", 0);
+    class_addmethod(c, (method)signalsmith_stats, "stats", 0);
+    class_addmethod(c, (method)signalsmith_file, "file", A_GIMME, 0);
+    class_addmethod(c, (method)signalsmith_trace_dump, "trace_dump", A_SYM, 0);
+    class_addmethod(c, (method)signalsmith_offline_render, "render", A_GIMME, 0);
+    class_addmethod(c, (method)signalsmith_offline_cancel, "render_cancel", 0);
 
     class_dspinit(c);
     class_register(CLASS_BOX, c);
     
     signalsmith_class = c;
     
+    // start the render threads once, shared by all the instances
+    WorkerPool::shared();
+    quittask_install((method)signalsmith_quit, NULL);
+    
     const char* version = "v0.0.1-pre";
-#if defined(__ARM_NEON__)
-            post("signalsmith-stretch~ %s by Alex Bouvier - Based on [signalsmith-stretch] by [Geraint Luff / Signalsmith Audio Ltd]. ARM NEON optimised. MIT License", version);
-#elif defined(__AVX2__)
-            post("signalsmith-stretch~ %s by Alex Bouvier - Based on [signalsmith-stretch] by [Geraint Luff / Signalsmith Audio Ltd]. AVX2 optimised. MIT License", version);
-#elif defined(__AVX__)
-            post("signalsmith-stretch~ %s  by Alex Bouvier - Based on [signalsmith-stretch] by [Geraint Luff / Signalsmith Audio Ltd]. AVX optimised. MIT License", version);
-#else
-            post("signalsmith-stretch~ %s  by Alex Bouvier - Based on [signalsmith-stretch] by [Geraint Luff / Signalsmith Audio Ltd]. MIT License", version);
-#endif
+    post("signalsmith-stretch~ %s by Alex Bouvier - Based on [signalsmith-stretch] by [Geraint Luff / Signalsmith Audio Ltd]. SIMD: %s. MIT License", version, getCurrentSIMD());
 }
 
 void *signalsmith_new(t_symbol *s_input_buffer, 
@@ -183,28 +435,61 @@ void *signalsmith_new(t_symbol *s_input_buffer,
                       long mode)
 {
     t_signalsmith *x = (t_signalsmith*)object_alloc(signalsmith_class);
-    dsp_setup((t_pxobject *)x, 1);
-
-#ifdef __APPLE__
-            x->chunks_semaphore = dispatch_semaphore_create(0);
-            x->process_semaphore = dispatch_semaphore_create(0);
-#elif defined(_WIN32)
-            x->chunks_hSemaphore = CreateSemaphore(nullptr, 0, 2048, nullptr);
-            x->process_hSemaphore = CreateSemaphore(nullptr, 0, 128, nullptr);
-#endif
+    x->l_chan = chan > 0 ? MIN(MAX(chan, 1), MAX_BUFFER_CHANNEL) : 1;  // num channels: [1,MAX_BUFFER_CHANNEL]
+    dsp_setup((t_pxobject *)x, 3 + x->l_chan);     // start/stop, stretch_factor, pitch, live input channels
+
+    x->render_job.reset(new PoolJob([x](){ signalsmith_render(x); },
+                                    [x](){ return 1.0f - (float)x->output_ring.readAvailable() / (float)x->render_size.load(); }));
+    x->groups_done.reset(new Semaphore());
+    x->stats.reset(new RenderStats());
+    x->stats_interval = 0;
+    x->stats_clock = clock_new(x, (method)signalsmith_stats_tick);
+    x->mirror.reset(new PlanarMirror());
+    x->mirror_job.reset(new PoolJob([x](){ signalsmith_mirror_build(x); }));
+    WorkerPool::shared().add(x->mirror_job.get());
+    x->switch_job.reset(new PoolJob([x](){ signalsmith_switch(x); }));
+    WorkerPool::shared().add(x->switch_job.get());
+    x->analysis.reset(new AnalysisCache());
+    x->analysis_job.reset(new PoolJob([x](){ signalsmith_analysis_start(x); }));
+    WorkerPool::shared().add(x->analysis_job.get());
+    for(size_t t = 0; t < WorkerPool::shared().size(); ++t){
+        x->analysis_slice_jobs.emplace_back(new PoolJob([x, t](){ signalsmith_analysis_slice(x, t); }));
+        WorkerPool::shared().add(x->analysis_slice_jobs.back().get());
+    }
+    x->spectral_synth.reset(new SpectralSynth());
+    x->freeze_analyser.reset(new SpectralAnalyser());
     
 
     x->sr = (int)sys_getsr();
     x->blocksize = sys_getblksize();
     
     x->mode = (int)mode;
+    x->mode_switch.request(mode);
+    x->mode_switch.rebuilt(mode);
     x->stretch_factor = 1.0f;
     x->pitch = 0.0f;
+    x->params.stretch_factor = 1.0f;
+    x->params.pitch = 0.0f;
+    x->params.resample = true;
+    x->params.mirror = true;
+    x->params.auto_render_size = false;
     x->sample_position = 0;
     x->last_position = -1;
-    
-    
-    x->l_chan = chan > 0 ? MIN(MAX(chan, 1), MAX_BUFFER_CHANNEL) : 1;  // num channels: [1,MAX_BUFFER_CHANNEL]
+    x->latency = OUTPUT_STRETCH_BUFFER_SIZE;
+    x->render_size = OUTPUT_STRETCH_BUFFER_SIZE;
+    x->groups = 1;
+    x->resample = 1;
+    x->mirror_enabled = 1;
+    x->live = 0;
+    x->live_size = LIVE_CAPTURE_MS;
+    x->live_policy = LiveFollow;
+    x->params.live = false;
+    x->params.live_policy = LiveFollow;
+    x->analysis_enabled = 0;
+    x->analysis_folder = gensym("");
+    x->analysis_path = gensym("");
+    x->params.analysis = false;
+    x->buffer_name = s_input_buffer;
     
     x->info_outlet = outlet_new((t_object *)x, NULL);
 
@@ -213,10 +498,20 @@ void *signalsmith_new(t_symbol *s_input_buffer,
     outlet_new((t_object *)x, "signal");    // for position
     outlet_new((t_object *)x, "signal");    // for blocksize
     
+    // room for the largest render while the previous one is still playing
+    // and as many sub-blocks when the parameters move
+    x->output_ring.allocate(x->l_chan, 2 * MAX_RENDER_SIZE, 2 * MAX_RENDER_SIZE / PARAM_SUBBLOCK_SIZE);
+    x->param_stream.allocate(PARAM_STREAM_SIZE);
+    x->param_current.stretch_factor = 1.0f;
+    x->param_current.pitch = 0.0f;
+    x->last_samples.assign(x->l_chan, 0.0);
 
-    critical_new(&x->critical_output_blocks);
     critical_new(&x->critical_input_buffer);
-    critical_new(&x->critical_sema_buffer);
+    x->offline_qelem = qelem_new(x, (method)signalsmith_offline_report);
+    x->seek_qelem = qelem_new(x, (method)signalsmith_seek_report);
+    x->rebuild_qelem = qelem_new(x, (method)signalsmith_rebuild);
+    x->capture_qelem = qelem_new(x, (method)signalsmith_capture_resize);
+    x->analysis_qelem = qelem_new(x, (method)signalsmith_analysis_report);
     
     if (!x->l_buffer_ref)
         x->l_buffer_ref = buffer_ref_new((t_object *)x, s_input_buffer);
@@ -224,6 +519,7 @@ void *signalsmith_new(t_symbol *s_input_buffer,
         buffer_ref_set(x->l_buffer_ref, s_input_buffer);
     
     signalsmith_update_buffer(x);
+    signalsmith_mirror_invalidate(x);
 
     
     return (x);
@@ -233,85 +529,554 @@ void signalsmith_free(t_signalsmith *x)
 {
     dsp_free((t_pxobject *)x);
     signalsmith_delete_stretcher(x);
+    WorkerPool::shared().remove(x->switch_job.get());
+    x->switch_job = nullptr;
+    x->render_job = nullptr;
+    x->groups_done = nullptr;
+    // waits for a running rebuild, before the buffer~ reference goes away
+    WorkerPool::shared().remove(x->mirror_job.get());
+    x->mirror_job = nullptr;
+    // then for the analysis jobs, the ones submitting the others first
+    WorkerPool::shared().remove(x->analysis_job.get());
+    std::shared_ptr<AnalysisBuild> build = std::atomic_exchange(&x->analysis_build, std::shared_ptr<AnalysisBuild>());
+    if(build)
+        build->cancel();
+    for(auto& job : x->analysis_slice_jobs)
+        WorkerPool::shared().remove(job.get());
+    x->analysis_slice_jobs.clear();
+    x->analysis_job = nullptr;
+    x->analysis = nullptr;
+    x->spectral_synth = nullptr;
+    x->spectral_analysis = nullptr;
+    x->freeze_analyser = nullptr;
+    x->mirror = nullptr;
+    std::atomic_store(&x->file_source, std::shared_ptr<FileSource>());
     
-
-#ifdef __APPLE__
-    dispatch_release(x->chunks_semaphore);
-    dispatch_release(x->process_semaphore);
-#elif defined(_WIN32)
-    CloseHandle(x->chunks_hSemaphore);
-    CloseHandle(x->process_hSemaphore);
-#endif
-    
+    x->offline_cancel = true;
+    if(x->offline_thread.joinable())
+        x->offline_thread.join();
+    qelem_free(x->offline_qelem);
+    qelem_free(x->seek_qelem);
+    qelem_free(x->rebuild_qelem);
+    qelem_free(x->capture_qelem);
+    qelem_free(x->analysis_qelem);
+    clock_unset(x->stats_clock);
+    object_free(x->stats_clock);
+    object_free(x->offline_target_ref);
 
     object_free(x->l_buffer_ref);
+    x->output_ring.deallocate();
+    x->capture.deallocate();
+    x->param_stream.deallocate();
+    std::vector<double>().swap(x->last_samples);
     
-    critical_free(x->critical_output_blocks);
     critical_free(x->critical_input_buffer);
-    critical_free(x->critical_sema_buffer);
 }
 
 // ------
 
+// stretch_factor: 0 freezes the sound at the current position, see SpectralPath
 t_max_err signalsmith_stretch_factor_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
     float factor = atom_getfloat(argv);
     x->stretch_factor = MAX(factor, 0.0f);
+    x->params.stretch_factor = x->stretch_factor;
     return 0;
 }
 
 t_max_err signalsmith_pitch_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
     float val = atom_getfloat(argv);
     x->pitch = val;
+    x->params.pitch = val;
     return 0;
 }
 
+/**
+ position: seek. perform64 drops the frames rendered before the seek,
+ the worker restarts from the new position with a pre-rolled stretcher.
+ */
 t_max_err signalsmith_position_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
     long val = atom_getlong(argv);
     x->sample_position = val;
+    x->current_position = val;
+    x->seek_target = val;
+    x->seek_time = now_ns();
+    x->seek_generation++;
     return 0;
 }
 
+// position of the block being rendered, not the last one set
+t_max_err signalsmith_position_get(t_signalsmith *x, t_object *attr, long *argc, t_atom **argv){
+    char alloc;
+    if(atom_alloc(argc, argv, &alloc))
+        return 1;
+    atom_setlong(*argv, x->current_position.load());
+    return 0;
+}
 
-t_max_err signalsmith_mode_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
-    critical_enter(x->critical_input_buffer);
-    critical_enter(x->critical_sema_buffer);
 
+/**
+ mode: with a stretcher, the new one is built and crossfaded in on the pool (see signalsmith_switch),
+ the current one keeps playing meanwhile.
+ */
+t_max_err signalsmith_mode_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
     long val = atom_getlong(argv);
 
     x->mode = (int)val;
-    signalsmith_create_stretcher(x, (int)MIN(x->l_chan, x->buffer_nc.load()), x->mode);
+    x->mode_switch.request(val);
+    // the analysis layout follows the mode
+    signalsmith_analysis_invalidate(x);
+    if(x->stretcher_channels > 0)
+        WorkerPool::shared().submit(x->switch_job.get());
+    else
+        signalsmith_rebuild(x);
+    return 0;
+}
 
-    critical_exit(x->critical_sema_buffer);
-    critical_exit(x->critical_input_buffer);
+/**
+ latency: samples rendered by each worker job, [MIN_RENDER_SIZE, MAX_RENDER_SIZE].
+ 0 picks the smallest safe size from the measured render times.
+ The output queue holds up to 1.5 render + 1 vector.
+ */
+t_max_err signalsmith_latency_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    long val = atom_getlong(argv);
+    x->latency = val <= 0 ? 0 : CLAMP(val, MIN_RENDER_SIZE, MAX_RENDER_SIZE);
+    if(x->latency > 0)
+        x->render_size = x->latency;
+    x->params.auto_render_size = x->latency == 0;
+    return 0;
+}
+
+/**
+ groups: split the channels in up to `groups` groups of stereo pairs, each one with its own stretcher,
+ rendered concurrently by the worker pool. 1: a single stretcher for all the channels.
+ */
+t_max_err signalsmith_groups_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->groups = CLAMP((long)atom_getlong(argv), 1L, (long)MAX_BUFFER_CHANNEL / 2);
+    signalsmith_rebuild(x);
+    return 0;
+}
+
+t_max_err signalsmith_resample_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->resample = atom_getlong(argv) != 0 ? 1 : 0;
+    x->params.resample = x->resample != 0;
+    return 0;
+}
+
+/**
+ mirror: 1 keeps a planar copy of the buffer~ (as much memory as the buffer~), read without locking the buffer~.
+ 0 reads the buffer~ itself for each block.
+ */
+t_max_err signalsmith_mirror_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->mirror_enabled = atom_getlong(argv) != 0 ? 1 : 0;
+    x->params.mirror = x->mirror_enabled != 0;
+    signalsmith_mirror_invalidate(x);
+    return 0;
+}
+
+/**
+ analysis: 1 analyses the buffer~ once in the background (STFT frames, on every pool thread),
+ stretch factors below HYPER_STRETCH_FACTOR are then synthesised from the analysis instead of being stretched.
+ Takes about 4 times the memory of the buffer~. Not used for the file source and the live input.
+ */
+t_max_err signalsmith_analysis_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->analysis_enabled = atom_getlong(argv) != 0 ? 1 : 0;
+    x->params.analysis = x->analysis_enabled != 0;
+    // the analysis reads the mirror, built whatever the mirror attribute
+    if(x->params.mirror && x->mirror->current())
+        signalsmith_analysis_invalidate(x);
+    else
+        signalsmith_mirror_invalidate(x);
+    return 0;
+}
+
+/**
+ analysis_folder <folder>: keep the analyses in sidecar files of this folder, mapped in memory.
+ A sidecar is reused as long as the buffer~ contents and the layout of the mode are the same. Empty: in memory only.
+ */
+t_max_err signalsmith_analysis_folder_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    t_symbol *folder = argc > 0 && atom_gettype(argv) == A_SYM ? atom_getsym(argv) : gensym("");
+    char path[MAX_PATH_CHARS];
+    if(!folder->s_name[0] || path_nameconform(folder->s_name, path, PATH_STYLE_NATIVE, PATH_TYPE_BOOT))
+        strncpy_zero(path, folder->s_name, MAX_PATH_CHARS);
+    x->analysis_folder = folder;
+    x->analysis_path = gensym(path);
+    signalsmith_analysis_invalidate(x);
+    return 0;
+}
+
+/**
+ live: 1 stretches the live input inlets (one per output channel) instead of the buffer~ or the file.
+ The input is captured while a live inlet is connected, the read head runs behind it at the stretch factor (see live_policy).
+ */
+t_max_err signalsmith_live_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->live = atom_getlong(argv) != 0 ? 1 : 0;
+    x->params.live = x->live != 0;
+    if(!x->live)
+        signalsmith_mirror_invalidate(x);
+    signalsmith_update_buffer(x);
+    // restart behind the newest input, or at the position set
+    x->seek_time = now_ns();
+    x->seek_generation++;
+    return 0;
+}
+
+/**
+ live_size: ms of live input kept, bounds the delay of the read head whatever the stretch factor.
+ The capture ring is reallocated by the next DSP start.
+ */
+t_max_err signalsmith_live_size_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->live_size = CLAMP((long)atom_getlong(argv), 1L, (long)LIVE_CAPTURE_MAX_MS);
+    return 0;
+}
+
+// live_policy: follow, hold or drift, see LivePolicy
+t_max_err signalsmith_live_policy_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->live_policy = CLAMP((long)atom_getlong(argv), (long)LiveFollow, (long)LiveDrift);
+    x->params.live_policy = (int)x->live_policy;
     return 0;
 }
 
 // ------
 
 
+// cached when the stretcher is created: never waits for a render
 void signalsmith_get_input_latency(t_signalsmith *x){
-    critical_enter(x->critical_input_buffer);
-    t_atom_long latency = x->stretch ? (long)x->stretch->inputLatency() : 0;
     t_atom av[2];
     atom_setsym(&av[0], gensym("input_latency"));
-    atom_setlong(&av[1], latency);
+    atom_setlong(&av[1], (t_atom_long)x->input_latency.load());
     outlet_list(x->info_outlet, gensym("list"), 2, av);
-    critical_exit(x->critical_input_buffer);
 }
 
 void signalsmith_get_output_latency(t_signalsmith *x){
-    critical_enter(x->critical_input_buffer);
-    t_atom_long latency = x->stretch ? (long)x->stretch->outputLatency() : 0;
     t_atom av[2];
     atom_setsym(&av[0], gensym("output_latency"));
-    atom_setlong(&av[1], latency);
+    atom_setlong(&av[1], (t_atom_long)x->output_latency.load());
     outlet_list(x->info_outlet, gensym("list"), 2, av);
-    critical_exit(x->critical_input_buffer);
+}
+
+void signalsmith_get_underruns(t_signalsmith *x){
+    t_atom av[2];
+    atom_setsym(&av[0], gensym("underruns"));
+    atom_setlong(&av[1], (t_atom_long)x->underruns.load());
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+}
+
+void signalsmith_seek_report(t_signalsmith *x){
+    t_atom av[2];
+    atom_setsym(&av[0], gensym("seek_latency"));
+    atom_setfloat(&av[1], (double)x->seek_latency.load() * 1e-6);  // ms
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+}
+
+void signalsmith_get_mirror_memory(t_signalsmith *x){
+    t_atom av[2];
+    atom_setsym(&av[0], gensym("mirror_memory"));
+    atom_setlong(&av[1], (t_atom_long)x->mirror->bytes());    // bytes
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+}
+
+void signalsmith_get_render_size(t_signalsmith *x){
+    t_atom av[2];
+    atom_setsym(&av[0], gensym("render_size"));
+    atom_setlong(&av[1], x->render_size.load());
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+}
+
+// analysis_done <frames> <sidecar>: an analysis has been published, computed or read back from its sidecar file (1)
+void signalsmith_analysis_report(t_signalsmith *x){
+    std::shared_ptr<const SpectralAnalysis> analysis = x->analysis->acquire();
+    if(!analysis)
+        return;
+    t_atom av[3];
+    atom_setsym(&av[0], gensym("analysis_done"));
+    atom_setlong(&av[1], (t_atom_long)analysis->frames());
+    atom_setlong(&av[2], analysis->persistent() ? 1 : 0);
+    outlet_list(x->info_outlet, gensym("list"), 3, av);
+}
+
+// <name>_us count mean p50 p99 max, then <name>_histogram and the count of each bucket
+static void signalsmith_stats_histogram(t_signalsmith *x, const char *name, const DurationHistogram::Summary& summary){
+    char symbol[64];
+    t_atom av[DurationHistogram::BUCKETS + 1];
+    snprintf(symbol, sizeof(symbol), "%s_us", name);
+    atom_setsym(&av[0], gensym(symbol));
+    atom_setlong(&av[1], (t_atom_long)summary.count);
+    atom_setfloat(&av[2], summary.mean_us);
+    atom_setfloat(&av[3], summary.p50_us);
+    atom_setfloat(&av[4], summary.p99_us);
+    atom_setfloat(&av[5], summary.max_us);
+    outlet_list(x->info_outlet, gensym("list"), 6, av);
+    
+    snprintf(symbol, sizeof(symbol), "%s_histogram", name);
+    atom_setsym(&av[0], gensym(symbol));
+    for(int b = 0; b < DurationHistogram::BUCKETS; ++b)
+        atom_setlong(&av[b + 1], (t_atom_long)summary.buckets[b]);
+    outlet_list(x->info_outlet, gensym("list"), DurationHistogram::BUCKETS + 1, av);
+}
+
+/**
+ stats: statistics since the previous report, see RenderStats.
+ render_us, extract_us, lock_us (+ histograms), queue_depth <min> <avg>, underruns, realtime_ratio.
+ */
+void signalsmith_stats(t_signalsmith *x){
+    RenderStats::Summary summary = x->stats->take(x->sr);
+    signalsmith_stats_histogram(x, "render", summary.process);
+    signalsmith_stats_histogram(x, "extract", summary.extract);
+    signalsmith_stats_histogram(x, "lock", summary.lock);
+    
+    t_atom av[3];
+    atom_setsym(&av[0], gensym("queue_depth"));
+    atom_setlong(&av[1], (t_atom_long)summary.queue_min);
+    atom_setfloat(&av[2], summary.queue_avg);
+    outlet_list(x->info_outlet, gensym("list"), 3, av);
+    
+    signalsmith_get_underruns(x);
+    
+    atom_setsym(&av[0], gensym("realtime_ratio"));
+    atom_setfloat(&av[1], summary.realtime_ratio);
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+}
+
+/**
+ trace_dump <path>: write the timeline of the worker and audio threads (every instance) to a Chrome trace JSON file.
+ Only recorded when built with SIGNALSMITH_TRACE, see trace.hpp.
+ */
+void signalsmith_trace_dump(t_signalsmith *x, t_symbol *s){
+#if SIGNALSMITH_TRACE
+    char path[MAX_PATH_CHARS];
+    if(path_nameconform(s->s_name, path, PATH_STYLE_NATIVE, PATH_TYPE_BOOT))
+        strncpy_zero(path, s->s_name, MAX_PATH_CHARS);
+    if(Trace::dump(path))
+        post("signalsmith-stretch~: trace written to %s", path);
+    else
+        error("signalsmith-stretch~ error: cannot write the trace to %s.", path);
+#else
+    error("signalsmith-stretch~ error: built without tracing, configure with -DSIGNALSMITH_TRACE=ON.");
+#endif
+}
+
+void signalsmith_stats_tick(t_signalsmith *x){
+    signalsmith_stats(x);
+    if(x->stats_interval > 0)
+        clock_fdelay(x->stats_clock, (double)x->stats_interval);
+}
+
+/**
+ stats_interval: report the stats every stats_interval ms, 0: only on the stats message.
+ */
+t_max_err signalsmith_stats_interval_set(t_signalsmith *x, t_object *attr, long argc, t_atom *argv){
+    x->stats_interval = MAX((long)atom_getlong(argv), 0L);
+    if(x->stats_interval > 0)
+        clock_fdelay(x->stats_clock, (double)x->stats_interval);
+    else
+        clock_unset(x->stats_clock);
+    return 0;
+}
+
+// ------ offline render
+
+/**
+ render <target buffer~> [start] [end]: stretch [start, end[ of the buffer (in samples, default: all of it)
+ with the current mode, pitch and stretch_factor, as fast as possible on a background thread.
+ The target is resized to fit. Reports "render_progress <0..1>", then "render_done <target> <frames>"
+ or "render_cancelled <target>" on the info outlet. The realtime output is not affected.
+ */
+void signalsmith_offline_render(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv){
+    // the target is resized on the main thread
+    defer(x, (method)signalsmith_offline_start, s, (short)argc, argv);
+}
+
+void signalsmith_offline_start(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv){
+    if(x->offline_thread.joinable()){
+        error("signalsmith-stretch~ error: a render is already running.");
+        return;
+    }
+    if(argc < 1 || atom_gettype(argv) != A_SYM){
+        error("signalsmith-stretch~ error: render <buffer~> [start] [end]");
+        return;
+    }
+    
+    if(std::atomic_load(&x->file_source) || x->live){
+        error("signalsmith-stretch~ error: render reads the buffer~, not the file source or the live input.");
+        return;
+    }
+    t_buffer_obj *source = x->l_buffer_ref ? buffer_ref_getobject(x->l_buffer_ref) : nullptr;
+    long source_nc = x->buffer_nc;
+    if(!source || source_nc <= 0){
+        error("signalsmith-stretch~ error: render needs a source buffer~.");
+        return;
+    }
+    if(x->stretch_factor <= 0){
+        error("signalsmith-stretch~ error: render needs a stretch_factor > 0.");
+        return;
+    }
+    
+    OfflineRender::Settings settings;
+    settings.num_channels = (int)MIN(x->l_chan, source_nc);
+    settings.mode = x->mode;
+    settings.sample_rate = x->sr > 0 ? (float)x->sr : (float)sys_getsr();
+    settings.stretch_factor = x->stretch_factor;
+    settings.pitch = x->pitch;
+    long frames = buffer_getframecount(source);
+    settings.start = argc > 1 ? CLAMP((long)atom_getlong(argv + 1), 0L, frames) : 0;
+    settings.end = argc > 2 ? CLAMP((long)atom_getlong(argv + 2), 0L, frames) : frames;
+    long output_frames = OfflineRender::outputFrames(settings);
+    if(output_frames <= 0){
+        error("signalsmith-stretch~ error: nothing to render between %ld and %ld.", settings.start, settings.end);
+        return;
+    }
+    
+    t_symbol *target_name = atom_getsym(argv);
+    if(!x->offline_target_ref)
+        x->offline_target_ref = buffer_ref_new((t_object *)x, target_name);
+    else
+        buffer_ref_set(x->offline_target_ref, target_name);
+    t_buffer_obj *target = buffer_ref_getobject(x->offline_target_ref);
+    if(!target){
+        error("signalsmith-stretch~ error: no buffer~ %s.", target_name->s_name);
+        return;
+    }
+    
+    t_atom av[2];
+    atom_setlong(&av[0], output_frames);
+    atom_setlong(&av[1], settings.num_channels);
+    object_method_typed(target, gensym("sizeinsamps"), 2, av, NULL);
+    
+    x->offline_target = target_name;
+    x->offline_frames = output_frames;
+    x->offline_progress = 0;
+    x->offline_complete = false;
+    x->offline_cancel = false;
+    x->offline_done = false;
+    
+    x->offline_thread = std::thread([x, settings](){
+        OfflineRender render;
+        long nc = settings.num_channels;
+        bool complete = render.run(settings,
+                                   [x, nc](REAL* const* channels, long start, long frames){
+                                       signalsmith_read_buffer(x->l_buffer_ref, channels, nc, start, frames);
+                                   },
+                                   [x, nc](const REAL* const* channels, long offset, long frames){
+                                       signalsmith_write_buffer(x->offline_target_ref, channels, nc, offset, frames);
+                                   },
+                                   [x](double progress){
+                                       x->offline_progress = progress;
+                                       qelem_set(x->offline_qelem);
+                                   },
+                                   x->offline_cancel);
+        x->offline_complete = complete;
+        x->offline_done = true;
+        qelem_set(x->offline_qelem);
+    });
+}
+
+void signalsmith_offline_cancel(t_signalsmith *x){
+    x->offline_cancel = true;
+}
+
+void signalsmith_offline_report(t_signalsmith *x){
+    t_atom av[3];
+    atom_setsym(&av[0], gensym("render_progress"));
+    atom_setfloat(&av[1], x->offline_progress.load());
+    outlet_list(x->info_outlet, gensym("list"), 2, av);
+    
+    if(x->offline_done && x->offline_thread.joinable()){
+        x->offline_thread.join();
+        if(x->offline_complete){
+            t_buffer_obj *target = buffer_ref_getobject(x->offline_target_ref);
+            if(target)
+                buffer_setdirty(target);
+            atom_setsym(&av[0], gensym("render_done"));
+            atom_setsym(&av[1], x->offline_target);
+            atom_setlong(&av[2], x->offline_frames);
+            outlet_list(x->info_outlet, gensym("list"), 3, av);
+        }
+        else{
+            atom_setsym(&av[0], gensym("render_cancelled"));
+            atom_setsym(&av[1], x->offline_target);
+            outlet_list(x->info_outlet, gensym("list"), 2, av);
+        }
+    }
+}
+
+/**
+ Planar copy of [start, start + frames[ of a buffer~, zeros outside of the buffer.
+ */
+void signalsmith_read_buffer(t_buffer_ref *ref, REAL* const* channels, long num_channels, long start, long frames){
+    long begin = 0, end = 0;
+    t_buffer_obj *buffer = ref ? buffer_ref_getobject(ref) : nullptr;
+    if(buffer){
+        long fc = buffer_getframecount(buffer);
+        long nc = buffer_getchannelcount(buffer);
+        begin = CLAMP(start, 0L, fc);
+        end = CLAMP(start + frames, 0L, fc);
+        float *tab = buffer_locksamples(buffer);
+        if(tab){
+            long copied = MIN(num_channels, nc);
+            for(long i = begin; i < end; ++i){
+                for(long c = 0; c < copied; ++c)
+                    channels[c][i - start] = tab[i * nc + c];
+            }
+            for(long c = copied; c < num_channels; ++c)
+                std::fill(channels[c] + (begin - start), channels[c] + (end - start), 0.0f);
+        }
+        else{
+            end = begin;
+        }
+        buffer_unlocksamples(buffer);
+    }
+    long head = CLAMP(begin - start, 0L, frames);
+    long tail = CLAMP(end - start, head, frames);
+    for(long c = 0; c < num_channels; ++c){
+        std::fill(channels[c], channels[c] + head, 0.0f);
+        std::fill(channels[c] + tail, channels[c] + frames, 0.0f);
+    }
+}
+
+/**
+ Interleave planar frames into a buffer~ from frame `offset`, clipped to its current size.
+ */
+void signalsmith_write_buffer(t_buffer_ref *ref, const REAL* const* channels, long num_channels, long offset, long frames){
+    t_buffer_obj *buffer = ref ? buffer_ref_getobject(ref) : nullptr;
+    if(!buffer)
+        return;
+    float *tab = buffer_locksamples(buffer);
+    if(tab){
+        long fc = buffer_getframecount(buffer);
+        long nc = buffer_getchannelcount(buffer);
+        long count = MIN(frames, fc - offset);
+        long written = MIN(num_channels, nc);
+        for(long i = 0; i < count; ++i){
+            for(long c = 0; c < written; ++c)
+                tab[(offset + i) * nc + c] = channels[c][i];
+        }
+    }
+    buffer_unlocksamples(buffer);
 }
 
 void signalsmith_dsp64(t_signalsmith *x, t_object *dsp64, short *count, double samplerate, long maxvectorsize, long flags)
 {
     x->sr = (int)samplerate;
+    
+    // the parameter inlets are only read when a signal is connected
+    x->stretch_signal = count[1] != 0;
+    x->pitch_signal = count[2] != 0;
+    x->param_signals = x->stretch_signal || x->pitch_signal;
+    
+    // live input: the capture ring only takes memory while a live inlet is connected
+    qelem_unset(x->capture_qelem);
+    x->live_inlets = false;
+    for(long c = 0; c < x->l_chan; ++c)
+        x->live_inlets = x->live_inlets || count[3 + c] != 0;
+    x->capture_frames = x->live_inlets ? (size_t)((double)x->live_size * 1e-3 * samplerate) + LIVE_CAPTURE_GUARD : 0;
+    if(x->capture_frames > x->capture.capacity() || (x->capture.capacity() > 0 && 2 * x->capture_frames <= x->capture.capacity())){
+        // nothing captured until the ring is resized
+        x->live_connected = false;
+        signalsmith_capture_resize(x);
+    }
+    else{
+        x->live_connected = x->live_inlets;
+    }
     dsp_add64(dsp64, (t_object *)x, (t_perfroutine64)signalsmith_perform64, 0, NULL);
 }
 
@@ -339,6 +1104,9 @@ void signalsmith_assist(t_signalsmith *x, void *b, long m, long a, char *s)
     else {
         switch (a) {
             case 0: snprintf(s, 20, "(signal) start/stop");    break;
+            case 1: snprintf(s, 27, "(signal) stretch_factor");    break;
+            case 2: snprintf(s, 17, "(signal) pitch");    break;
+            default: snprintf(s, 64, "(signal) live input channel %ld", a - 3);    break;
         }
     }
 }
@@ -346,52 +1114,31 @@ void signalsmith_assist(t_signalsmith *x, void *b, long m, long a, char *s)
 // -----------------
 
 
+/**
+ Reset the stretcher. Safe from any thread, perform64 included: the worker resets the stretcher
+ and re-primes the queue before its next chunk, perform64 drops the frames rendered before the request.
+ */
 void signalsmith_reset(t_signalsmith*x){
-    if(x->task_reset.valid())
-        x->task_reset.wait();
-
-    x->task_reset = std::async(std::launch::async, std::bind([&](t_signalsmith* x){
-        if(x->stretch){
-            x->stretch->reset();
-        }
-
-        critical_enter(x->critical_output_blocks);
-        x->num_blocks = 0;
-        x->output_blocks.clear();
-        x->output_positions.clear();
-        x->last_position = -1;
-        critical_exit(x->critical_output_blocks);
-
-        bool trial = true;
-        do{
-            trial = critical_tryenter(x->critical_sema_buffer);
-            if(!trial){
-#ifdef __APPLE__
-        dispatch_release(x->chunks_semaphore);
-        x->chunks_semaphore = dispatch_semaphore_create(0);
-#elif defined(_WIN32)
-        CloseHandle(x->chunks_hSemaphore);
-        x->chunks_hSemaphore = CreateSemaphore(nullptr, 0, 2048, nullptr);
-#endif
-        critical_exit(x->critical_sema_buffer);
-            }
-        }while(trial);
-        
-        // launch process task
-#ifdef __APPLE__
-        dispatch_semaphore_signal(x->process_semaphore);
-#elif defined(_WIN32)
-        ReleaseSemaphore(x->process_hSemaphore, 1, nullptr);
-#endif
-    }, x));
-                               
+    TRACE_INSTANT("reset_request", x);
+    x->reset_request.request();
+}
+
+void signalsmith_quit(void){
+    WorkerPool::shared().shutdown();
 }
 
 void signalsmith_update_buffer(t_signalsmith *x)
 {
     // update buffer nc
     t_buffer_obj *buffer = buffer_ref_getobject(x->l_buffer_ref);
-    if (buffer) {
+    std::shared_ptr<FileSource> file = std::atomic_load(&x->file_source);
+    if(x->live){
+        x->buffer_nc = x->l_chan;
+    }
+    else if(file){
+        x->buffer_nc = file->file->channels();
+    }
+    else if (buffer) {
         x->buffer_nc = buffer_getchannelcount(buffer);
         
         if(x->buffer_nc > MAX_BUFFER_CHANNEL){
@@ -404,14 +1151,103 @@ void signalsmith_update_buffer(t_signalsmith *x)
         x->buffer_nc = 0;
     }
     
-    signalsmith_create_stretcher(x, (int)MIN(x->l_chan, x->buffer_nc.load()), x->mode);
+    signalsmith_rebuild(x);
     
     signalsmith_reset(x);
 }
 
+/**
+ file <path>: read a WAV or AIFF file instead of the buffer~. The file is mapped in memory, not loaded:
+ opening does not depend on its length, and a prefetch thread reads the pages ahead of the position.
+ file without argument: back to the buffer~.
+ */
+void signalsmith_file(t_signalsmith *x, t_symbol *s, long argc, t_atom *argv){
+    std::shared_ptr<FileSource> source;
+    if(argc > 0){
+        if(atom_gettype(argv) != A_SYM){
+            error("signalsmith-stretch~ error: file <path>");
+            return;
+        }
+        // a name in the search path, or an absolute path
+        t_symbol *name = atom_getsym(argv);
+        char path[MAX_PATH_CHARS];
+        char filename[MAX_PATH_CHARS];
+        short path_id = 0;
+        t_fourcc type = 0;
+        strncpy_zero(filename, name->s_name, MAX_PATH_CHARS);
+        if(!locatefile_extended(filename, &path_id, &type, nullptr, 0))
+            path_toabsolutesystempath(path_id, filename, path);
+        else if(path_nameconform(name->s_name, path, PATH_STYLE_NATIVE, PATH_TYPE_BOOT))
+            strncpy_zero(path, name->s_name, MAX_PATH_CHARS);
+        
+        std::string reason;
+        std::unique_ptr<MappedAudioFile> file = MappedAudioFile::open(path, reason);
+        if(!file){
+            error("signalsmith-stretch~ error: cannot read %s: %s.", path, reason.c_str());
+            return;
+        }
+        source = std::make_shared<FileSource>();
+        source->file = std::move(file);
+        source->prefetcher.reset(new FilePrefetcher(*source->file, FILE_PREFETCH_SECONDS));
+        source->prefetcher->update((double)x->seek_target.load(), x->params.stretch_factor * x->sr);
+        post("signalsmith-stretch~: %s, %ld frames, %ld channels, %.0f Hz", path, source->file->frames(), source->file->channels(), source->file->sampleRate());
+    }
+    
+    // the worker keeps the previous source until the end of its render
+    std::atomic_store(&x->file_source, source);
+    if(!source)
+        signalsmith_mirror_invalidate(x);
+    signalsmith_update_buffer(x);
+}
+
+/**
+ Recreate the stretcher for the current buffer~, mode and groups.
+ The worker only tries to enter the critical section and the main thread does the same:
+ while a render is running, try again on the next main thread tick instead of waiting for it.
+ */
+void signalsmith_rebuild(t_signalsmith *x){
+    if(critical_tryenter(x->critical_input_buffer)){
+        qelem_set(x->rebuild_qelem);
+        return;
+    }
+    signalsmith_create_stretcher(x, (int)MIN(x->l_chan, x->buffer_nc.load()), x->mode);
+    critical_exit(x->critical_input_buffer);
+}
+
+/**
+ Resize the capture ring as set by dsp64. perform64 does not write it meanwhile (live_connected is false),
+ the worker reads it within the critical section: as in signalsmith_rebuild, only try to enter it
+ and try again on the next main thread tick while a render is running.
+ */
+void signalsmith_capture_resize(t_signalsmith *x){
+    if(critical_tryenter(x->critical_input_buffer)){
+        qelem_set(x->capture_qelem);
+        return;
+    }
+    if(x->capture_frames > 0)
+        x->capture.allocate(x->l_chan, x->capture_frames);
+    else
+        x->capture.deallocate();
+    critical_exit(x->critical_input_buffer);
+    x->live_connected = x->live_inlets;
+    if(x->live)
+        signalsmith_reset(x);
+}
+
 t_max_err signalsmith_notify(t_signalsmith *x, t_symbol *s, t_symbol *msg, void *sender, void *data)
 {
-    signalsmith_update_buffer(x);
+    // the render target changes (resize, writes) must not reset the stretcher
+    if(x->offline_target_ref && sender && sender == buffer_ref_getobject(x->offline_target_ref)){
+        return buffer_ref_notify(x->offline_target_ref, s, msg, sender, data);
+    }
+    if(x->offline_target_ref)
+        buffer_ref_notify(x->offline_target_ref, s, msg, sender, data);
+    
+    // bound or modified: the planar mirror is out of date (the buffer~ is not read while a file or the live input is)
+    if(!std::atomic_load(&x->file_source) && !x->live){
+        signalsmith_mirror_invalidate(x);
+        signalsmith_update_buffer(x);
+    }
     return buffer_ref_notify(x->l_buffer_ref, s, msg, sender, data);
 }
 
@@ -419,13 +1255,20 @@ t_max_err signalsmith_notify(t_signalsmith *x, t_symbol *s, t_symbol *msg, void
 // -----------------
 
 void signalsmith_delete_stretcher(t_signalsmith *x){
-    if(x->stretch){
-        x->running = false;
-        if(x->task_stretch.valid()){
-            x->task_stretch.wait();
-        }
+    // waits for a running mode switch and drops a queued one: the new stretcher is built with the last mode
+    WorkerPool::shared().remove(x->switch_job.get());
+    WorkerPool::shared().add(x->switch_job.get());
+    if(x->stretch_groups.size()){
+        // waits for a running render, which waits for its groups
+        WorkerPool::shared().remove(x->render_job.get());
+        signalsmith_remove_groups(x->stretch_groups);
     }
-    x->stretch = nullptr;
+    signalsmith_remove_groups(x->next_groups);
+    signalsmith_remove_groups(x->retired_groups);
+    x->mode_switch.cancel();
+    x->stretcher_channels = 0;
+    x->input_latency = 0;
+    x->output_latency = 0;
 }
 
 
@@ -434,145 +1277,584 @@ void signalsmith_create_stretcher(t_signalsmith *x, long num_channels, long mode
     signalsmith_delete_stretcher(x);
     
     if(num_channels > 0){
-        x->stretch.reset(new SignalsmithStretch<REAL>());
-        if(x->stretch){
-            if(mode==1){
-                x->stretch->presetCheaper((int)num_channels, (float)x->sr);
-            }
-            else if (mode == 2){
-                x->stretch->configure((int)num_channels, (float)x->sr*0.12f, (float)x->sr*0.02f);
+        // channels pushed to the ring: the ones processed by the stretchers
+        x->rendered_buffer.assign(num_channels, std::vector<REAL>(MAX_RENDER_SIZE));
+        x->crossfade_buffer.assign(num_channels, std::vector<REAL>(MAX_RENDER_SIZE));
+        x->spectral_buffer.assign(num_channels, std::vector<REAL>(MAX_RENDER_SIZE));
+        x->rendered_channels.clear();
+        x->rendered_outputs.clear();
+        x->crossfade_outputs.clear();
+        x->spectral_outputs.clear();
+        for(int c = 0; c < num_channels; ++c){
+            x->rendered_channels.push_back(x->rendered_buffer[c].data());
+            x->rendered_outputs.push_back(x->rendered_buffer[c].data());
+            x->crossfade_outputs.push_back(x->crossfade_buffer[c].data());
+            x->spectral_outputs.push_back(x->spectral_buffer[c].data());
+        }
+        x->spectral_path = SpectralOff;
+        x->freeze_captured = false;
+        x->extracted_inputs.assign(MAX_BUFFER_CHANNEL, nullptr);  // every channel of the buffer~ is extracted
+        x->crossfade_inputs.assign(MAX_BUFFER_CHANNEL, nullptr);
+        
+        x->stretch_groups = signalsmith_build_groups(x, num_channels, mode, x->extracted_inputs.data(), x->rendered_outputs.data());
+        x->mode_switch.rebuilt(mode);
+        
+        // pre-roll read like a block: every channel of the buffer~
+        long buffer_channels = MAX(num_channels, x->buffer_nc.load());
+        x->preroll_buffer.assign(buffer_channels, std::vector<REAL>(x->stretch_groups[0].stretch->inputLatency()));
+        x->preroll_channels.clear();
+        for(long c = 0; c < buffer_channels; ++c){
+            x->preroll_channels.push_back(x->preroll_buffer[c].data());
+        }
+        x->resampler.setStep(signalsmith_source_step(x));
+        
+        x->stretcher_channels = num_channels;
+        x->input_latency = x->stretch_groups[0].stretch->inputLatency();
+        x->output_latency = x->stretch_groups[0].stretch->outputLatency();
+        
+        WorkerPool::shared().add(x->render_job.get());
+        
+        //launch 1st computation
+        x->render_pending = true;
+        WorkerPool::shared().submit(x->render_job.get());
+    }
+}
+
+/**
+ Configured stretchers for num_channels channels in mode, one per channel group.
+ The groups after the first one get a job registered on the pool.
+ 
+ - Parameters:
+ - x: current instance
+ - num_channels: channels of the whole stretcher
+ - mode: stretch mode, see configureStretch
+ - inputs, outputs: channels processed by the groups (see signalsmith_process_group)
+ */
+std::vector<StretchGroup> signalsmith_build_groups(t_signalsmith *x, long num_channels, long mode, const REAL** inputs, REAL** outputs){
+    std::vector<StretchGroup> groups;
+    for(const ChannelGroup& channels : channelGroups(num_channels, x->groups)){
+        StretchGroup group;
+        group.channels = channels;
+        group.stretch.reset(new SignalsmithStretch<REAL>());
+        configureStretch(*group.stretch, (int)channels.count, mode, (float)x->sr);
+        group.inputs = inputs;
+        group.outputs = outputs;
+        groups.push_back(std::move(group));
+    }
+    // the vector is not resized anymore: the jobs can keep a pointer to their group
+    for(size_t g = 1; g < groups.size(); ++g){
+        StretchGroup* group = &groups[g];
+        group->job.reset(new PoolJob([x, group](){
+            signalsmith_process_group(x, *group);
+            x->groups_done->signal();
+        }));
+        WorkerPool::shared().add(group->job.get());
+    }
+    return groups;
+}
+
+/**
+ Unregister the jobs of the groups (waiting for the running ones) and destroy them.
+ */
+void signalsmith_remove_groups(std::vector<StretchGroup>& groups){
+    for(auto& group : groups){
+        if(group.job)
+            WorkerPool::shared().remove(group.job.get());
+    }
+    groups.clear();
+}
+
+/**
+ Process the channels of one group, from its inputs to its outputs.
+ */
+void signalsmith_process_group(t_signalsmith *x, StretchGroup& group){
+    TRACE_SCOPE("process", x);
+    long long start = now_ns();
+    processGroup(group, x->group_input_samples, x->group_output_samples);
+    x->stats->process.add(now_ns() - start);
+}
+
+/**
+ Mode switch job, run on the pool after the mode has changed.
+ Destroys the stretcher retired by the last switch, then builds the stretcher of the last mode set
+ and hands it to the worker, which pre-rolls it at the current position and crossfades it in.
+ Never runs concurrently with itself, and never waits for a render.
+ */
+void signalsmith_switch(t_signalsmith *x){
+    if(x->mode_switch.retiring()){
+        signalsmith_remove_groups(x->retired_groups);
+        x->mode_switch.retired();
+    }
+    
+    long mode = 0;
+    if(!x->mode_switch.begin(mode))
+        return;     // a switch is running (the worker submits this job again once it is done), or nothing to switch
+    long num_channels = (long)x->rendered_outputs.size();
+    if(num_channels == 0){
+        x->mode_switch.cancel();
+        return;
+    }
+    x->next_groups = signalsmith_build_groups(x, num_channels, mode, x->crossfade_inputs.data(), x->crossfade_outputs.data());
+    x->mode_switch.ready();
+}
+
+/**
+ Worker side of the mode switch, for each rendered chunk: mix the next stretcher (crossfade_outputs)
+ in the current one (rendered_outputs), and once the crossfade is over, swap them.
+ */
+void signalsmith_crossfade(t_signalsmith *x, long frames){
+    if(!x->mode_switch.mix(x->rendered_outputs.data(), x->crossfade_outputs.data(), x->rendered_outputs.size(), frames))
+        return;
+    
+    // the next stretcher now renders to the ring, the old one is destroyed by the switch job
+    std::swap(x->stretch_groups, x->next_groups);
+    x->retired_groups = std::move(x->next_groups);
+    x->next_groups.clear();
+    for(auto& group : x->stretch_groups){
+        group.inputs = x->extracted_inputs.data();
+        group.outputs = x->rendered_outputs.data();
+    }
+    x->input_latency = x->stretch_groups[0].stretch->inputLatency();
+    x->output_latency = x->stretch_groups[0].stretch->outputLatency();
+    x->mode_switch.finish();
+    WorkerPool::shared().submit(x->switch_job.get());
+}
+
+/**
+ Synthesise `frames` frames of a spectral path at read_position (see SpectralPath). The caller moves read_position.
+ 
+ - Parameters:
+ - x: current instance
+ - path: SpectralHyper or SpectralFreeze
+ - outputs: stretcher_channels channels
+ - frames: frames to render
+ - step: source frames per output frame (hyper-stretch)
+ - transpose: frequency factor, the source / DSP sample rate ratio included
+ - Returns: false without frames (past the end of the buffer, no analysis), nothing rendered
+ */
+bool signalsmith_spectral(t_signalsmith *x, int path, REAL** outputs, long frames, double step, float transpose){
+    const SpectralAnalysis *analysis = x->render_analysis.get();
+    if(path == SpectralHyper && (!analysis || x->read_position >= (double)analysis->key().frames))
+        return false;
+    TRACE_SCOPE("synthesis", x);
+    long long start = now_ns();
+    const int channels = (int)x->rendered_outputs.size();
+    x->spectral_synth->configure(path == SpectralHyper ? analysis->key().layout : x->freeze_layout, channels);
+    if(x->spectral_restart){
+        x->spectral_synth->reset();
+        x->spectral_restart = false;
+    }
+    if(path == SpectralHyper){
+        // another analysis may reuse the address of the previous one: the held spectrum would be stale
+        if(x->spectral_analysis != x->render_analysis){
+            x->spectral_synth->framesChanged();
+            x->spectral_analysis = x->render_analysis;
+        }
+        double position = x->read_position;
+        x->spectral_synth->render([analysis](long index, int channel){ return analysis->frame(index, channel); },
+                                  position, step, transpose, outputs, frames);
+    }
+    else{
+        // the two captured frames, forever
+        const SpectralBin *captured = x->freeze_frames.data();
+        const size_t bins = (size_t)x->freeze_layout.bins();
+        double position = 0;
+        x->spectral_synth->render([captured, channels, bins](long index, int channel) -> const SpectralBin* {
+                                      return index == 0 || index == 1 ? captured + ((size_t)index * channels + channel) * bins : nullptr;
+                                  },
+                                  position, 0.0, transpose, outputs, frames);
+    }
+    x->stats->process.add(now_ns() - start);
+    return true;
+}
+
+/**
+ Freeze without analysis: analyse the two frames a hop apart around read_position, from any source.
+ The synthesis then plays them forever, each partial advancing its phase at the frequency measured between them.
+ The source is read at its own rate, like the analysis cache.
+ 
+ - Parameters:
+ - x: current instance
+ - source_step: source frames per DSP frame
+ - Returns: false without source
+ */
+bool signalsmith_freeze_capture(t_signalsmith *x, double source_step){
+    t_buffer_obj *buffer = x->render_file || x->render_live || !x->l_buffer_ref ? nullptr : buffer_ref_getobject(x->l_buffer_ref);
+    long nc = x->buffer_nc;
+    long channels = (long)x->rendered_outputs.size();
+    if((!buffer && !x->render_file && !x->render_live) || nc < channels)
+        return false;
+    TRACE_SCOPE("freeze", x);
+    
+    SpectralLayout layout = spectralLayout(x->mode_switch.mode(), source_step * (double)x->sr);
+    long total = layout.fft_size + layout.hop;
+    // centered on the read position, the live input: within the captured input
+    double start = std::floor(x->read_position) - (double)(layout.fft_size / 2);
+    if(x->render_live)
+        start = MIN(start, (double)x->capture.written() - (double)total);
+    REAL* input[MAX_BUFFER_CHANNEL];
+    x->freeze_input.resize(nc);
+    for(long c = 0; c < nc; ++c){
+        if(x->freeze_input[c].size() < (size_t)total)
+            x->freeze_input[c].resize(total);
+        input[c] = x->freeze_input[c].data();
+    }
+    signalsmith_read_source(x, buffer, input, start, total, 1.0);
+    
+    x->freeze_analyser->setLayout(layout);
+    x->freeze_frames.resize((size_t)(2 * channels * layout.bins()));
+    for(long c = 0; c < channels; ++c){
+        x->freeze_analyser->analyse(input[c], x->freeze_frames.data() + (size_t)c * layout.bins());
+        x->freeze_analyser->analyse(input[c] + layout.hop, x->freeze_frames.data() + (size_t)(channels + c) * layout.bins());
+    }
+    x->freeze_layout = layout;
+    x->freeze_captured = true;
+    // rewritten in place: the synthesis reads them again
+    x->spectral_synth->framesChanged();
+    return true;
+}
+
+/**
+ Crossfade the stretcher (rendered_outputs) and a spectral path (spectral_outputs) over a chunk, into rendered_outputs,
+ see spectralCrossfade.
+ */
+void signalsmith_spectral_crossfade(t_signalsmith *x, long frames, bool entering){
+    spectralCrossfade(x->rendered_outputs.data(), x->spectral_outputs.data(), x->rendered_outputs.size(), frames, entering);
+}
+
+/**
+ Pre-roll the stretchers with the input latency preceding the next block to render,
+ so the first block rendered after a seek is already in steady state.
+ A block at `position` starts input latency samples before it (see signalsmith_extract_samples).
+ */
+void signalsmith_preroll(t_signalsmith *x, std::vector<StretchGroup>& groups, double position, double step){
+    long preroll = groups.size() ? groups[0].stretch->inputLatency() : 0;
+    t_buffer_obj *buffer = x->l_buffer_ref ? buffer_ref_getobject(x->l_buffer_ref) : nullptr;
+    if(preroll == 0 || (!buffer && !x->render_file && !x->render_live) || (long)x->preroll_channels.size() < x->buffer_nc)
+        return;
+    // the stretcher of another mode can have a longer latency
+    if((long)x->preroll_buffer[0].size() < preroll){
+        for(size_t c = 0; c < x->preroll_buffer.size(); ++c){
+            x->preroll_buffer[c].resize(preroll);
+            x->preroll_channels[c] = x->preroll_buffer[c].data();
+        }
+    }
+    double start = MAX(position, preroll * step) - 2 * preroll * step;
+    signalsmith_read_source(x, buffer, x->preroll_channels.data(), start, preroll, step);
+    for(auto& group : groups)
+        group.stretch->seek(x->preroll_channels.data() + group.channels.first, (int)preroll, x->params.stretch_factor.load());
+}
+
+/**
+ Parameters of the next chunk from the signal inlets stream. While they hold still, a whole render;
+ while they move, sub-blocks of PARAM_SUBBLOCK_SIZE samples following the received values.
+ The points of the vectors covered by the chunk are consumed, the last one applies.
+ 
+ - Parameters:
+ - x: current instance
+ - render_size: frames of a whole render
+ - stretch_factor, pitch: parameters of the chunk
+ - Returns: frames to render with these parameters
+ */
+long signalsmith_next_params(t_signalsmith *x, long render_size, float &stretch_factor, float &pitch){
+    ParamStream& stream = x->param_stream;
+    const size_t vectors = (size_t)MAX(render_size / MAX((long)x->blocksize, 1L), 1L);
+    
+    // late worker: skip the oldest values instead of lagging more and more
+    if(stream.size() > 2 * vectors)
+        stream.pop(stream.size() - 2 * vectors);
+    
+    bool moving = false;
+    const size_t ahead = MIN(stream.size(), vectors);
+    for(size_t i = 0; i < ahead && !moving; ++i){
+        const ParamPoint& point = stream.peek(i);
+        moving = std::fabs(point.stretch_factor - x->param_current.stretch_factor) > PARAM_EPSILON
+              || std::fabs(point.pitch - x->param_current.pitch) > PARAM_EPSILON;
+    }
+    
+    long chunk_size = moving ? MIN(render_size, (long)PARAM_SUBBLOCK_SIZE) : render_size;
+    size_t consumed = MIN(stream.size(), (size_t)MAX(chunk_size / MAX((long)x->blocksize, 1L), 1L));
+    if(consumed > 0){
+        x->param_current = stream.peek(consumed - 1);
+        stream.pop(consumed);
+    }
+    stretch_factor = x->param_current.stretch_factor;
+    pitch = x->param_current.pitch;
+    return chunk_size;
+}
+
+/**
+ Render chunks of render_size samples and push them to the output ring,
+ until perform64 has more than half a render and a vector to play.
+ Run by the shared worker pool when perform64 asks for more samples.
+ */
+void signalsmith_render(t_signalsmith *x){
+    const long MIN_BLOCKSIZE = 4;
+    TRACE_SCOPE("render", x);
+    
+    // the stretcher is being replaced: perform64 asks again later
+    if(critical_tryenter(x->critical_input_buffer)){
+        x->render_pending = false;
+        return;
+    }
+    // empty, or the buffer~ lost channels and the rebuild is still pending
+    if(x->stretch_groups.empty() || x->stretcher_channels > x->buffer_nc){
+        x->render_pending = false;
+        critical_exit(x->critical_input_buffer);
+        return;
+    }
+    
+    long long requested = x->request_time.exchange(0);
+    double wait_seconds = requested > 0 ? (double)MAX(now_ns() - requested, 0LL) * 1e-9 : 0.0;
+    
+    // the mirror is read without locking: keep the current snapshot for this render
+    x->render_live = x->params.live;
+    x->render_file = x->render_live ? nullptr : std::atomic_load(&x->file_source);
+    x->render_snapshot = x->params.mirror && !x->render_file && !x->render_live ? x->mirror->acquire() : nullptr;
+    x->render_analysis = x->params.analysis && !x->render_file && !x->render_live ? x->analysis->acquire() : nullptr;
+    
+    long render_size = x->render_size;
+    do{
+        // the ring is full: stop, perform64 asks again once it has been consumed
+        if(x->output_ring.writeAvailable() < (size_t)render_size)
+            break;
+        
+        // parameters: the attributes, or the stream of the signal inlets
+        long chunk_size = render_size;
+        float stretch_param = x->params.stretch_factor;
+        float pitch_param = x->params.pitch;
+        if(x->param_signals)
+            chunk_size = signalsmith_next_params(x, render_size, stretch_param, pitch_param);
+        
+        // buffer~ and DSP sample rates differ: resample the buffer~ (resample 1),
+        // or read it as is and fold the ratio in the stretch factor and the pitch (resample 0)
+        double source_step = signalsmith_source_step(x);
+        bool resample = x->params.resample;
+        double input_step = resample ? source_step : 1.0;   // buffer samples per stretcher input sample
+        double transpose = pitch_param;
+        double  stretch_factor = stretch_param;
+        if(resample){
+            x->resampler.setStep(source_step);
+        }
+        else{
+            transpose += 12.0 * std::log2(source_step);
+            stretch_factor *= source_step;
+        }
+        
+        // seek: restart from the new position (live input: from the newest input)
+        unsigned long generation = x->seek_generation.load();
+        if(generation != x->rendered_generation){
+            x->rendered_generation = generation;
+            x->read_position = x->render_live ? (double)x->capture.written() : (double)x->seek_target;
+            signalsmith_preroll(x, x->stretch_groups, x->read_position, input_step);
+            if(x->mode_switch.fading())
+                signalsmith_preroll(x, x->next_groups, x->read_position, input_step);
+            x->spectral_restart = true;
+            x->freeze_captured = false;
+        }
+        
+        // reset: restart the stretchers pre-rolled at the current position
+        unsigned long reset = 0;
+        if(x->reset_request.service(reset)){
+            TRACE_SCOPE("reset", x);
+            for(auto& group : x->stretch_groups)
+                group.stretch->reset();
+            signalsmith_preroll(x, x->stretch_groups, x->read_position, input_step);
+            if(x->mode_switch.fading()){
+                for(auto& group : x->next_groups)
+                    group.stretch->reset();
+                signalsmith_preroll(x, x->next_groups, x->read_position, input_step);
             }
-            else if (mode == 3){
-                x->stretch->configure((int)num_channels, (float)x->sr*0.12f, (float)x->sr*0.015);
+            x->spectral_restart = true;
+            x->freeze_captured = false;
+        }
+        
+        // mode switch: the next stretcher starts pre-rolled at the current position
+        if(x->mode_switch.start())
+            signalsmith_preroll(x, x->next_groups, x->read_position, input_step);
+        bool fading = x->mode_switch.fading();
+        
+        for(auto& group : x->stretch_groups)
+            group.stretch->setTransposeSemitones((float)transpose);
+        int input_latency = x->stretch_groups[0].stretch->inputLatency();
+        int next_latency = input_latency;
+        if(fading){
+            for(auto& group : x->next_groups)
+                group.stretch->setTransposeSemitones((float)transpose);
+            next_latency = x->next_groups[0].stretch->inputLatency();
+        }
+        // one block for both stretchers while fading, each one starts its latency before the position
+        int extract_latency = MAX(input_latency, next_latency);
+        long block_samples = MAX((long)(stretch_factor * chunk_size), MIN_BLOCKSIZE);
+        
+        // spectral paths: synthesised from STFT frames, see SpectralPath
+        int spectral = SpectralOff;
+        if(!fading && x->render_analysis && stretch_param < HYPER_STRETCH_FACTOR
+           && x->render_analysis->key().channels >= (long)x->rendered_outputs.size())
+            spectral = SpectralHyper;
+        else if(!fading && stretch_param <= 0.0f)
+            spectral = SpectralFreeze;
+        // frozen again later: captured again, at that point
+        if(spectral != SpectralFreeze)
+            x->freeze_captured = false;
+        else if(!x->freeze_captured && !signalsmith_freeze_capture(x, source_step))
+            spectral = SpectralOff;
+        // both paths are analysed at the source rate
+        double hyper_step = stretch_factor * input_step;
+        float spectral_transpose = (float)(std::exp2(pitch_param / 12.0) * source_step);
+        if(spectral != SpectralOff && x->spectral_path != SpectralOff){
+            // hyper-stretch and freeze hand over without a crossfade: same synthesis, other frames
+            double step = spectral == SpectralHyper ? hyper_step : 0.0;
+            x->spectral_path = spectral;
+            long long chunk_start = now_ns();
+            ChunkInfo info;
+            info.position = (long)x->read_position;
+            info.length = lround(chunk_size * step);
+            info.blocksize = x->stretch_blocksize;
+            info.generation = x->rendered_generation;
+            info.reset = reset;
+            if(signalsmith_spectral(x, spectral, x->rendered_outputs.data(), chunk_size, step, spectral_transpose)){
+                x->render_tuner.addRender(chunk_size, (double)(now_ns() - chunk_start) * 1e-9, wait_seconds, x->sr);
+                x->stats->addRender(chunk_size, now_ns() - chunk_start);
+                wait_seconds = 0;
+                {
+                    TRACE_SCOPE("enqueue", x);
+                    x->output_ring.push(x->rendered_channels.data(), x->rendered_channels.size(), chunk_size, info);
+                }
+                x->read_position += chunk_size * step;
+                x->current_position = (long)x->read_position;
             }
             else{
-                x->stretch->presetDefault((int)num_channels, (float)x->sr);
+                TRACE_SCOPE("enqueue", x);
+                x->output_ring.push(nullptr, 0, chunk_size, info);
             }
+            continue;
+        }
+        // out of a spectral path: the stretcher restarts pre-rolled where the synthesis is
+        if(spectral == SpectralOff && x->spectral_path != SpectralOff){
+            for(auto& group : x->stretch_groups)
+                group.stretch->reset();
+            signalsmith_preroll(x, x->stretch_groups, x->read_position, input_step);
+        }
+        
+        // live input: the read head stays within the captured input, see LivePolicy
+        if(x->render_live){
+            LiveBlock live = placeLiveBlock((LivePolicy)x->params.live_policy.load(), x->read_position, block_samples, chunk_size,
+                                            extract_latency, (long)x->capture.written(), (long)x->capture.capacity() - LIVE_CAPTURE_GUARD,
+                                            LIVE_DRIFT_SECONDS * x->sr);
+            x->read_position = live.position;
+            block_samples = live.blocksize;
+            if(live.jumped){
+                signalsmith_preroll(x, x->stretch_groups, x->read_position, input_step);
+                if(fading)
+                    signalsmith_preroll(x, x->next_groups, x->read_position, input_step);
+            }
+        }
+        long long chunk_start = now_ns();
+        auto [can_compute, pos] = signalsmith_extract_samples(x, x->extracted_inputs.data(), x->read_position, extract_latency, block_samples, input_step, MIN_BLOCKSIZE);
+        if(can_compute)
+            x->stats->extract.add(now_ns() - chunk_start);
+        if(can_compute && fading){
+            for(long c = 0; c < x->buffer_nc; ++c){
+                x->crossfade_inputs[c] = x->extracted_inputs[c] + (extract_latency - next_latency);
+                x->extracted_inputs[c] += extract_latency - input_latency;
+            }
+        }
+        
+        
+        /*
+         can_compute if extraction done and buffer almost empty
+         update position
+         update block size
+         */
+        x->read_position = pos;
+        x->current_position = (long)pos;
+        x->stretch_blocksize = block_samples + input_latency;
+        
+        ChunkInfo info;
+        info.position = (long)pos;
+        info.length = can_compute ? lround(block_samples * input_step) : 0;
+        info.blocksize = x->stretch_blocksize;
+        info.generation = x->rendered_generation;
+        info.reset = reset;
+
+        if(can_compute)
+        {
+            long long render_start = now_ns();
+            x->group_input_samples = block_samples;
+            x->group_output_samples = chunk_size;
             
-            x->task_stretch = std::async(std::launch::async, std::bind([](t_signalsmith* x){
-                const long MIN_BLOCKSIZE = 4;
-                
-                x->running = true;
-
-                std::vector<std::vector<REAL>> extracted_buffer;
-                
-                critical_enter(x->critical_input_buffer);
-                std::vector<std::vector<REAL>> output_ptr(x->buffer_nc);
-                for (int i = 0; i < x->buffer_nc; i++) {
-                    output_ptr[i] = std::vector<REAL>(OUTPUT_STRETCH_BUFFER_SIZE);
-                }
-                critical_exit(x->critical_input_buffer);
-
-                //launch 1st computation
-#ifdef __APPLE__
-                dispatch_semaphore_signal(x->process_semaphore);
-#elif defined(_WIN32)
-                ReleaseSemaphore(x->process_hSemaphore, 1, nullptr);
-#endif
-                int prev_chunk_size = x->blocksize;
-                std::vector<std::vector<REAL>> data(x->buffer_nc);
-                for(int c = 0; c < x->buffer_nc; ++c){
-                    data[c].resize(prev_chunk_size);
-                }
-                
-                while(x->running){
-                   
-                    bool process = false;
-            #ifdef __APPLE__
-                    process = dispatch_semaphore_wait(x->process_semaphore, dispatch_time(DISPATCH_TIME_NOW, 10 * NSEC_PER_MSEC)) == 0;
-            #elif defined(_WIN32)
-                    process = WaitForSingleObject(x->process_hSemaphore, 10) == WAIT_OBJECT_0;
-            #endif
-                    
-                    if(process){
-                        critical_enter(x->critical_input_buffer);
-
-                        x->stretch->setTransposeSemitones(x->pitch);
-                        double  stretch_factor = x->stretch_factor;
-                        int input_latency = x->stretch->inputLatency();
-                        long block_samples = MAX((long)(stretch_factor * OUTPUT_STRETCH_BUFFER_SIZE), MIN_BLOCKSIZE);
-                        auto [can_compute, pos] = signalsmith_extract_samples(x, extracted_buffer, x->sample_position, block_samples, MIN_BLOCKSIZE);
-                        
-                        
-                        /*
-                         can_compute if extraction done and buffer almost empty
-                         update position
-                         update block size
-                         */
-                        x->sample_position = pos;
-                        x->stretch_blocksize = block_samples + input_latency;
-                        
-
-                        if(can_compute)
-                        {
-                            x->stretch->process(extracted_buffer, (int)block_samples, output_ptr, OUTPUT_STRETCH_BUFFER_SIZE);
-
-                            auto chunk_size = sys_getblksize();
-                            assert((OUTPUT_STRETCH_BUFFER_SIZE%chunk_size)==0);
-
-                            critical_enter(x->critical_output_blocks);
-                            
-                            // resize data if needed
-                            if(prev_chunk_size != chunk_size){
-                                prev_chunk_size = chunk_size;
-                                std::vector<std::vector<REAL>> data(x->buffer_nc);
-                                for(int c = 0; c < x->buffer_nc; ++c){
-                                    data[c].resize(prev_chunk_size);
-                                }
-                            }
-                            critical_exit(x->critical_output_blocks);
-
-                            for(int i = 0; i < OUTPUT_STRETCH_BUFFER_SIZE/chunk_size; ++i){
-                                critical_enter(x->critical_output_blocks);
-                                for(int c = 0; c < x->buffer_nc; ++c){
-                                    std::copy(output_ptr[c].begin() + (i * chunk_size), output_ptr[c].begin() + (i * chunk_size + chunk_size), data[c].begin());
-                                }
-                                x->output_blocks.push_back(data);
-                                x->output_positions.push_back(pos + i * block_samples / (OUTPUT_STRETCH_BUFFER_SIZE/chunk_size));// input_latency ?
-                                critical_exit(x->critical_output_blocks);
-                                x->num_blocks++;
-
-#ifdef __APPLE__
-                                dispatch_semaphore_signal(x->chunks_semaphore);
-#elif defined(_WIN32)
-                                ReleaseSemaphore(x->chunks_hSemaphore, 1, nullptr);
-#endif
-                            }
-                            x->sample_position += block_samples;
-                        }
-                        else{
-                            // if cannot extract any more samples, output silence
-                            std::vector<std::vector<REAL>> data(x->buffer_nc);
-                            for(int c = 0; c < x->buffer_nc; ++c){
-                                data[c].resize(x->blocksize);
-                                std::fill(data[c].begin(), data[c].end(), 0.0f);
-                            }
-                            
-                            for(int i = 0; i < OUTPUT_STRETCH_BUFFER_SIZE/x->blocksize; ++i){
-                                critical_enter(x->critical_output_blocks);
-                                x->output_blocks.push_back(data);
-                                x->num_blocks++;
-                                critical_exit(x->critical_output_blocks);
-#ifdef __APPLE__
-                                dispatch_semaphore_signal(x->chunks_semaphore);
-#elif defined(_WIN32)
-                                ReleaseSemaphore(x->chunks_hSemaphore, 1, nullptr);
-#endif                                
-                            }
-                        }
-                        critical_exit(x->critical_input_buffer);
-                    }
-                }
-            }, x));
+            // fork: the other groups go to the pool, the first one renders here
+            PoolJob* jobs[MAX_BUFFER_CHANNEL];
+            size_t num_jobs = 0;
+            for(size_t g = 1; g < x->stretch_groups.size(); ++g)
+                jobs[num_jobs++] = x->stretch_groups[g].job.get();
+            for(size_t g = 1; fading && g < x->next_groups.size(); ++g)
+                jobs[num_jobs++] = x->next_groups[g].job.get();
+            forkGroups(WorkerPool::shared(), jobs, num_jobs);
+            signalsmith_process_group(x, x->stretch_groups[0]);
+            if(fading)
+                signalsmith_process_group(x, x->next_groups[0]);
+            {
+                TRACE_SCOPE("join", x);
+                joinGroups(WorkerPool::shared(), *x->groups_done, jobs, num_jobs);
+            }
+            if(fading)
+                signalsmith_crossfade(x, chunk_size);
+            // in or out of a spectral path
+            bool entering = spectral != SpectralOff;
+            if(entering != (x->spectral_path != SpectralOff)){
+                int path = entering ? spectral : x->spectral_path;
+                if(entering)
+                    x->spectral_restart = true;
+                if(signalsmith_spectral(x, path, x->spectral_outputs.data(), chunk_size, path == SpectralHyper ? hyper_step : 0.0, spectral_transpose))
+                    signalsmith_spectral_crossfade(x, chunk_size, entering);
+                x->spectral_path = spectral;
+            }
+            
+            x->render_tuner.addRender(chunk_size, (double)(now_ns() - render_start) * 1e-9, wait_seconds, x->sr);
+            x->stats->addRender(chunk_size, now_ns() - chunk_start);
+            wait_seconds = 0;
+            
+            {
+                TRACE_SCOPE("enqueue", x);
+                x->output_ring.push(x->rendered_channels.data(), x->rendered_channels.size(), chunk_size, info);
+            }
+            x->read_position += block_samples * input_step;
+            x->current_position = (long)x->read_position;
+            // file source: the pages the next chunks read are faulted in meanwhile
+            if(x->render_file)
+                x->render_file->prefetcher->update(x->read_position, stretch_factor * input_step * x->sr);
         }
+        else{
+            // if cannot extract any more samples, output silence
+            TRACE_SCOPE("enqueue", x);
+            x->spectral_path = SpectralOff;
+            x->output_ring.push(nullptr, 0, chunk_size, info);
+        }
+    }while(x->output_ring.readAvailable() <= (size_t)(render_size / 2 + x->blocksize));
+    
+    // automatic render size, applied to the next render
+    if(x->params.auto_render_size){
+        unsigned long long underruns = x->underruns;
+        if(underruns != x->tuner_underruns){
+            x->tuner_underruns = underruns;
+            x->render_tuner.addUnderrun();
+        }
+        x->render_size = x->render_tuner.renderSize(x->blocksize);
     }
-    else{
-        x->stretch = nullptr;
-    }
+    
+    x->render_snapshot = nullptr;
+    x->render_analysis = nullptr;
+    x->render_file = nullptr;
+    x->render_pending = false;
+    critical_exit(x->critical_input_buffer);
 }
 
 void signalsmith_perform64(t_signalsmith *x, t_object *dsp64, double **ins, long numins, double **outs, long numouts, long sampleframes, long flags, void *userparam)
 {
+    TRACE_THREAD("audio");
+    TRACE_SCOPE("perform64", x);
     t_double    *in = ins[0];
     bool is_on = in[0] != 0. ? true : false;
 
@@ -582,80 +1864,98 @@ void signalsmith_perform64(t_signalsmith *x, t_object *dsp64, double **ins, long
         signalsmith_reset(x);
     }
     
+    // live input: captured whether the output is on or not, the worker reads behind it
+    if(x->live_connected)
+        x->capture.write(ins + 3, (size_t)MAX(MIN(numins - 3, x->l_chan), 0L), (size_t)sampleframes);
+    
+    const SimdKernels& simd = getSimdKernels();
+    long current_pos = x->last_position;
+    long bs = x->stretch_blocksize;
+    size_t num_read = 0;
+    
     if(is_on && x->buffer_nc > 0){
-        // wait for chunks
-        bool woken = false;
-        while(!woken){
-            critical_enter(x->critical_sema_buffer);
-#ifdef __APPLE__
-            woken = dispatch_semaphore_wait(x->chunks_semaphore, dispatch_time(DISPATCH_TIME_NOW, 1 * NSEC_PER_MSEC)) == 0;
-#elif defined(_WIN32)
-            woken = WaitForSingleObject(x->chunks_hSemaphore, 1) == WAIT_OBJECT_0;
-#endif
-        critical_exit(x->critical_sema_buffer);
+        x->stats->addQueueDepth(x->output_ring.readAvailable());
+        
+        // never wait for the worker: play what is ready
+        // position of the first frame read
+        PlanarRingBuffer<REAL>::Chunk chunk;
+        size_t offset = 0;
+        
+        // seek, reset: drop the frames rendered before it
+        bool seeking = false;
+        unsigned long generation = x->seek_generation.load();
+        while(x->output_ring.current(chunk, offset)
+              && (chunk.info.generation < generation || x->reset_request.stale(chunk.info.reset))){
+            seeking = true;
+            // never spin on the worker: nothing dropped, try again next vector
+            if(x->output_ring.drop(chunk.frames - offset) == 0)
+                break;
         }
-
-        if(x->num_blocks > 0){
-            // if call to reset method here, check empty after critical section
-            critical_enter(x->critical_output_blocks);
-            auto data = x->output_blocks.empty() ? std::vector<std::vector<REAL>>(): x->output_blocks.front();
-            if(!x->output_blocks.empty())
-                x->output_blocks.pop_front();
-            critical_exit(x->critical_output_blocks);
-            
-            for(long c = 0; c < data.size(); ++c){
-                for(size_t i = 0; i < sampleframes; ++i)
-                    outs[c][i] = data[c][i];
+        
+        if(x->output_ring.current(chunk, offset)){
+            if(chunk.info.generation != x->played_generation){
+                // first frame after a seek
+                x->played_generation = chunk.info.generation;
+                x->seek_latency = now_ns() - x->seek_time;
+                qelem_set(x->seek_qelem);
             }
-            
-            // silence the remaining channels
-            for(long i = data.size(); i < x->l_chan; ++i)
-                std::fill(&(outs[i][0]), &(outs[i][0]) + sampleframes, 0.0);
-            
-            x->num_blocks--;
+            current_pos = chunk.info.position + (long)(offset * chunk.info.length / chunk.frames);
+            bs = chunk.info.blocksize;
+            x->last_position = current_pos;
         }
-        else{
-            //silence all channels
-            for(long i = 0; i < x->l_chan; ++i)
-                std::fill(&(outs[i][0]), &(outs[i][0]) + sampleframes, 0.0);
+        
+        {
+            TRACE_SCOPE("dequeue", x);
+            TRACE_COUNTER("queue_depth", x->output_ring.readAvailable());
+            num_read = x->output_ring.read(outs, x->l_chan, sampleframes, simd.convert);
+        }
+        
+        if(num_read < (size_t)sampleframes && x->playing){
+            // underrun: fade the last samples out instead of clicking to silence
+            // (after a seek, the new frames are not expected yet)
+            if(!seeking)
+                x->underruns++;
+            long fade = MIN(sampleframes - (long)num_read, UNDERRUN_FADE_SIZE);
+            for(long c = 0; c < x->l_chan; ++c){
+                double last = num_read > 0 ? outs[c][num_read - 1] : x->last_samples[c];
+                for(long i = 0; i < fade; ++i)
+                    outs[c][num_read + i] = last * (double)(fade - 1 - i) / (double)fade;
+            }
+            num_read += fade;
+            x->playing = false;
+        }
+        else if(num_read > 0){
+            x->playing = true;
         }
     }
-    else{
 
-        //silence all channels
-        for(long i = 0; i < x->l_chan; ++i)
-            std::fill(&(outs[i][0]), &(outs[i][0]) + sampleframes, 0.0);
+    // silence what has not been read
+    for(long i = 0; i < x->l_chan; ++i){
+        simd.fill(outs[i] + num_read, 0.0, sampleframes - num_read);
+        x->last_samples[i] = outs[i][sampleframes - 1];
     }
     
-    
-    // pop current position
-    long current_pos = 0;
-    critical_enter(x->critical_output_blocks);
-    if(!x->output_positions.empty()){
-        current_pos =  x->output_positions.front();
-        x->last_position = current_pos;
-        x->output_positions.pop_front();
-    }
-    else{
-        current_pos = x->last_position;
-    }
-    critical_exit(x->critical_output_blocks);
-
     // position + blocksize. always output these parameters
-    long bs = x->stretch_blocksize;
-    for(size_t i = 0; i < sampleframes; ++i){
-        outs[x->l_chan][i] = current_pos;
-        outs[x->l_chan + 1][i] = bs;
-    }
+    simd.fill(outs[x->l_chan], (double)current_pos, sampleframes);
+    simd.fill(outs[x->l_chan + 1], (double)bs, sampleframes);
 
     
-    // Signal process when half chunks remains
-    if(x->num_blocks == (OUTPUT_STRETCH_BUFFER_SIZE/sampleframes)/2){
-#ifdef __APPLE__
-                                dispatch_semaphore_signal(x->process_semaphore);
-#elif defined(_WIN32)
-                                ReleaseSemaphore(x->process_hSemaphore, 1, nullptr);
-#endif
+    // signal inlets: one point per vector for the worker
+    if(x->stretch_signal || x->pitch_signal){
+        ParamPoint point;
+        point.stretch_factor = x->params.stretch_factor;
+        point.pitch = x->params.pitch;
+        if(x->stretch_signal && numins > 1)
+            point.stretch_factor = (float)MAX(signalsmith_mean(ins[1], sampleframes), 0.0);
+        if(x->pitch_signal && numins > 2)
+            point.pitch = (float)signalsmith_mean(ins[2], sampleframes);
+        x->param_stream.push(point);
+    }
+    
+    // ask for a render when half of a render remains
+    if(x->output_ring.readAvailable() <= (size_t)(x->render_size / 2 + sampleframes) && !x->render_pending.exchange(true)){
+        x->request_time = now_ns();
+        WorkerPool::shared().submit(x->render_job.get());
     }
 
 }
@@ -667,69 +1967,320 @@ void signalsmith_perform64(t_signalsmith *x, t_object *dsp64, double **ins, long
  
  - Parameters:
  - x: current instance
- - output: output vectors
- - position: desired start in buffer (in samples)
- - blocksize: desired blocksize to extract
+ - inputs: buffer_nc pointers, set to the extracted channels (in the mirror, or in extracted_buffer)
+ - position: desired start in buffer (in samples, fractional when resampling)
+ - input_latency: stretcher input samples extracted before the position
+ - blocksize: desired blocksize to extract (stretcher input samples)
+ - step: buffer samples per stretcher input sample (1: no resampling)
  - min_blocksize: min size of block to extract
  */
-std::tuple<bool, long> signalsmith_extract_samples(t_signalsmith *x,
-                                                   std::vector<std::vector<REAL>> &output,
-                                                   long position,
-                                                   long blocksize,
-                                                   long min_blocksize)
+std::tuple<bool, double> signalsmith_extract_samples(t_signalsmith *x,
+                                                     const REAL** inputs,
+                                                     double position,
+                                                     long input_latency,
+                                                     long blocksize,
+                                                     double step,
+                                                     long min_blocksize)
 {
-    if(!x->l_buffer_ref)
+    TRACE_SCOPE("extract", x);
+    const MappedAudioFile *file = x->render_file ? x->render_file->file.get() : nullptr;
+    bool live = x->render_live;
+    if(!x->l_buffer_ref && !file && !live)
         return {false, position};
 
-    t_buffer_obj *buffer = buffer_ref_getobject(x->l_buffer_ref);
-    if (buffer) {
-        auto buffer_sr = buffer_getsamplerate(buffer);
-        float sr_ratio = (float) buffer_sr / (float)x->sr;
-        long fc = buffer_getframecount(buffer) * sr_ratio;
+    t_buffer_obj *buffer = file || live ? nullptr : buffer_ref_getobject(x->l_buffer_ref);
+    if (buffer || file || live) {
+        long fc = live ? 0 : file ? file->frames() : buffer_getframecount(buffer);
+        double start = position - input_latency * step;
 
-        if(fc == 0 || fc < blocksize || blocksize < min_blocksize){
-            return {false, position};
+        if(live){
+            // already placed within the capture ring (see placeLiveBlock)
+            if(blocksize < min_blocksize)
+                return {false, position};
+        }
+        else{
+            if(fc == 0 || fc < blocksize * step || blocksize < min_blocksize){
+                return {false, position};
+            }
+            if(start < 0){
+                start = 0;
+                position = input_latency * step;
+            }
+            
+            if(start >= fc){
+                return {false, position};
+            }
         }
-        int input_latency = x->stretch->inputLatency();
         
-
+        long nc = x->buffer_nc;
+        size_t total = (size_t)(blocksize + input_latency);
         
-        long start = position - input_latency;
-        if(start < 0){
-            start = 0;
-            position = input_latency;
+        // within the mirror, no resampling: the block is read in place
+        const PlanarSnapshot *mirror = x->render_snapshot.get();
+        if(mirror && mirror->channels() == nc && mirror->frames() == fc
+           && step == 1.0 && start == std::floor(start) && (long)start + (long)total <= fc){
+            for(long c = 0; c < nc; ++c)
+                inputs[c] = mirror->channel(c) + (long)start;
+            return {true, position};
         }
         
-        if(start >= fc){
-            return {false, position};
+        // extracted_buffer only grows: no allocation once the largest block has been extracted
+        REAL* channels[MAX_BUFFER_CHANNEL];
+        x->extracted_buffer.resize(nc);
+        for(long c = 0; c < nc; ++c){
+            if(x->extracted_buffer[c].size() < total)
+                x->extracted_buffer[c].resize(total);
+            channels[c] = x->extracted_buffer[c].data();
+            inputs[c] = channels[c];
         }
         
-        long end = start + blocksize + input_latency;
-        long add_samples = 0;
-        if (end >= fc) {
-            end = fc-1;
-            add_samples = blocksize + input_latency - (end - start);
+        signalsmith_read_source(x, buffer, channels, start, (long)total, step);
+            
+        return {true, position};
+    }
+    else
+        return {false, position};
+}
+
+/**
+ Deinterleave the frames [first, first + frames[ of a buffer~ (buffer_nc channels), zeros outside of the buffer.
+ */
+static void signalsmith_copy_frames(const float *tab, long fc, long nc, REAL* const* channels, long first, long frames){
+    long begin = CLAMP(first, 0L, fc);
+    long end = CLAMP(first + frames, begin, fc);
+    long head = CLAMP(begin - first, 0L, frames);
+    long tail = CLAMP(end - first, head, frames);
+    REAL* shifted[MAX_BUFFER_CHANNEL];
+    for(long c = 0; c < nc; ++c){
+        std::fill(channels[c], channels[c] + head, 0.0f);
+        std::fill(channels[c] + tail, channels[c] + frames, 0.0f);
+        shifted[c] = channels[c] + head;
+    }
+    if(tail > head)
+        deinterleave(tab + begin * nc, shifted, tail - head, nc);
+}
+
+/**
+ Planar frames of the source buffer~ at start + i * step, for i in [0, frames[, zeros outside of the buffer.
+ From a whole frame at step 1, a plain copy. Otherwise the frames around are resampled
+ (the resampler must have been set for this step).
+ The frames come from the capture ring in live mode, from the file source when there is one,
+ then from the render snapshot of the mirror, the buffer~ is only locked otherwise.
+ 
+ - Parameters:
+ - x: current instance
+ - buffer: source buffer~, buffer_nc channels (unused with a file source)
+ - channels: buffer_nc output channels
+ - start: buffer position (in frames, fractional) of the first frame
+ - frames: number of frames
+ - step: buffer frames per output frame
+ */
+void signalsmith_read_source(t_signalsmith *x, t_buffer_obj *buffer, REAL* const* channels, double start, long frames, double step){
+    long nc = x->buffer_nc;
+    if(x->render_live){
+        // captured at the DSP sample rate: whole frames, step 1
+        x->capture.read(channels, nc, (long)std::floor(start), frames);
+        return;
+    }
+    const MappedAudioFile *file = x->render_file ? x->render_file->file.get() : nullptr;
+    if(file && file->channels() != nc)
+        file = nullptr;
+    if(!file && !buffer)
+        return;
+    long fc = file ? file->frames() : buffer_getframecount(buffer);
+    const PlanarSnapshot *mirror = x->render_snapshot.get();
+    if(mirror && (mirror->channels() != nc || mirror->frames() != fc))
+        mirror = nullptr;
+    
+    // frames [first, first + count[ of every channel, zeros outside of the buffer
+    RenderStats *stats = x->stats.get();
+    auto copy = [buffer, file, mirror, fc, nc, stats](REAL* const* output, long first, long count){
+        if(file){
+            file->read(output, first, count);
+            return;
         }
-        
-        assert(start>= 0 && start < fc);
-        assert(end>= input_latency && end < fc);
-        assert(end >= start);
-        assert((end + add_samples - start) == blocksize + input_latency);
+        if(mirror){
+            mirror->copy(output, first, count);
+            return;
+        }
+        long long lock_start = now_ns();
         float* tab = buffer_locksamples(buffer);
+        stats->lock.add(now_ns() - lock_start);
         if(tab){
-            deinterleave(tab + start*x->buffer_nc, output, end-start, x->buffer_nc);
+            signalsmith_copy_frames(tab, fc, nc, output, first, count);
+        }
+        else{
+            for(long c = 0; c < nc; ++c)
+                std::fill(output[c], output[c] + count, 0.0f);
         }
         buffer_unlocksamples(buffer);
+    };
+    
+    if(step == 1.0 && start == std::floor(start)){
+        copy(channels, (long)start, frames);
+        return;
+    }
+    
+    long first = (long)std::floor(start) - PolyphaseResampler::before();
+    long span = (long)std::floor(start + (double)(frames - 1) * step) + PolyphaseResampler::after() + 1 - first;
+    const REAL* source[MAX_BUFFER_CHANNEL];
+    if(mirror && first >= 0 && first + span <= fc){
+        // resampled in place
+        for(long c = 0; c < nc; ++c)
+            source[c] = mirror->channel(c) + first;
+    }
+    else{
+        REAL* padded[MAX_BUFFER_CHANNEL];
+        x->source_buffer.resize(nc);
+        for(long c = 0; c < nc; ++c){
+            if(x->source_buffer[c].size() < (size_t)span)
+                x->source_buffer[c].resize(span);
+            padded[c] = x->source_buffer[c].data();
+            source[c] = padded[c];
+        }
+        copy(padded, first, span);
+    }
+    for(long c = 0; c < nc; ++c)
+        x->resampler.process(source[c], channels[c], frames, start - (double)first, step);
+}
 
-        if(add_samples > 0){
-            std::vector<REAL> silence(add_samples);
-            for(auto& channel : output){
-                channel.insert(channel.end(), silence.begin(), silence.end());
-            }
+/**
+ Rebuild the planar mirror of the source buffer~. Run by the shared worker pool after an invalidation,
+ the snapshot is dropped if the buffer~ has changed again meanwhile (a new rebuild is then queued).
+ Without a usable buffer~ an empty snapshot is published: blocks are then read from the buffer~ itself.
+ */
+void signalsmith_mirror_build(t_signalsmith *x){
+    unsigned long generation = x->mirror->generation();
+    if(!(x->params.mirror || x->params.analysis))
+        return;
+    
+    t_buffer_obj *buffer = x->l_buffer_ref ? buffer_ref_getobject(x->l_buffer_ref) : nullptr;
+    long fc = buffer ? buffer_getframecount(buffer) : 0;
+    long nc = buffer ? buffer_getchannelcount(buffer) : 0;
+    std::shared_ptr<const PlanarSnapshot> snapshot;
+    if(fc > 0 && nc > 0 && nc <= MAX_BUFFER_CHANNEL){
+        float* tab = buffer_locksamples(buffer);
+        if(tab){
+            snapshot = std::make_shared<const PlanarSnapshot>(tab, fc, nc);
         }
-            
-        return {true, position};
+        buffer_unlocksamples(buffer);
     }
-    else
-        return {false, position};
+    
+    const bool built = snapshot != nullptr;
+    if(x->mirror->publish(generation, std::move(snapshot)) && built && x->params.analysis)
+        WorkerPool::shared().submit(x->analysis_job.get());
+}
+
+/**
+ The source buffer~ is bound or modified: rebuild the mirror. Renders keep reading the previous snapshot
+ until the new one is published (a different frame or channel count is read from the buffer~ meanwhile),
+ they never lock the buffer~ because of a rebuild. Without mirror nor analysis the snapshot is freed.
+ The analysis is dropped as well, and restarted once the mirror has been rebuilt.
+ */
+void signalsmith_mirror_invalidate(t_signalsmith *x){
+    signalsmith_analysis_invalidate(x);
+    if(x->params.mirror || x->params.analysis){
+        x->mirror->invalidate();
+        WorkerPool::shared().submit(x->mirror_job.get());
+    }
+    else{
+        x->mirror->clear();
+    }
+}
+
+/**
+ The analysed source or layout has changed: cancel the running build and drop the published analysis
+ (the worker stretches meanwhile), then start a new one from the current mirror.
+ */
+void signalsmith_analysis_invalidate(t_signalsmith *x){
+    x->analysis->invalidate();
+    std::shared_ptr<AnalysisBuild> build = std::atomic_exchange(&x->analysis_build, std::shared_ptr<AnalysisBuild>());
+    if(build)
+        build->cancel();
+    if(x->params.analysis)
+        WorkerPool::shared().submit(x->analysis_job.get());
+}
+
+/**
+ Start the analysis of the current mirror, run by the pool once the mirror is published or the analysis invalidated.
+ A complete sidecar of the same source and layout is published as is,
+ otherwise the slices are analysed by one job per pool thread (see signalsmith_analysis_slice).
+ */
+void signalsmith_analysis_start(t_signalsmith *x){
+    unsigned long generation = x->analysis->generation();
+    std::shared_ptr<const PlanarSnapshot> source = x->mirror->current();
+    t_buffer_obj *buffer = x->l_buffer_ref ? buffer_ref_getobject(x->l_buffer_ref) : nullptr;
+    if(!x->params.analysis || !source || !buffer || x->analysis->acquire())
+        return;
+    std::shared_ptr<AnalysisBuild> running = std::atomic_load(&x->analysis_build);
+    if(running && running->generation() == generation)
+        return;
+    
+    AnalysisKey key;
+    key.frames = source->frames();
+    key.channels = source->channels();
+    key.sample_rate = buffer_getsamplerate(buffer);
+    key.layout = spectralLayout(x->mode_switch.mode(), key.sample_rate > 0 ? key.sample_rate : (double)x->sr);
+    key.checksum = AnalysisKey::contentsChecksum(*source);
+    
+    std::string reason;
+    std::unique_ptr<SpectralAnalysis> created;
+    t_symbol *folder = x->analysis_path;
+    if(folder && folder->s_name[0]){
+        std::string path = std::string(folder->s_name) + "/" + key.sidecarName(x->buffer_name ? x->buffer_name->s_name : "");
+        created = SpectralAnalysis::create(key, path, reason);
+        if(!created)
+            error("signalsmith-stretch~ error: cannot write the analysis to %s: %s, kept in memory.", path.c_str(), reason.c_str());
+    }
+    if(!created)
+        created = SpectralAnalysis::create(key, std::string(), reason);
+    if(!created)
+        return;
+    
+    std::shared_ptr<SpectralAnalysis> analysis(std::move(created));
+    if(analysis->complete()){
+        if(x->analysis->publish(generation, analysis))
+            qelem_set(x->analysis_qelem);
+        return;
+    }
+    std::shared_ptr<AnalysisBuild> build = std::make_shared<AnalysisBuild>(source, analysis, generation);
+    std::shared_ptr<AnalysisBuild> previous = std::atomic_exchange(&x->analysis_build, build);
+    if(previous)
+        previous->cancel();
+    for(auto& job : x->analysis_slice_jobs)
+        WorkerPool::shared().submit(job.get());
+}
+
+/**
+ Analysis job `index`: analyse one slice of the running build and submit itself again,
+ so the renders queued meanwhile run first. The slice completing the build publishes it.
+ */
+void signalsmith_analysis_slice(t_signalsmith *x, size_t index){
+    std::shared_ptr<AnalysisBuild> build = std::atomic_load(&x->analysis_build);
+    if(!build)
+        return;
+    AnalysisBuild::Slice slice = build->runSlice();
+    if(slice == AnalysisBuild::Analysed){
+        WorkerPool::shared().submit(x->analysis_slice_jobs[index].get());
+    }
+    else if(slice == AnalysisBuild::Completed){
+        if(x->analysis->publish(build->generation(), build->analysis()))
+            qelem_set(x->analysis_qelem);
+        // the snapshot of the build is released once the worker does not hold it anymore
+        std::atomic_compare_exchange_strong(&x->analysis_build, &build, std::shared_ptr<AnalysisBuild>());
+    }
+}
+
+/**
+ Source frames per DSP sample: the buffer~ (or file) sample rate over the DSP one, 1 for the live input.
+ */
+double signalsmith_source_step(t_signalsmith *x){
+    if(x->params.live)
+        return 1.0;
+    std::shared_ptr<FileSource> file = std::atomic_load(&x->file_source);
+    t_buffer_obj *buffer = x->l_buffer_ref ? buffer_ref_getobject(x->l_buffer_ref) : nullptr;
+    double buffer_sr = file ? file->file->sampleRate() : buffer ? buffer_getsamplerate(buffer) : 0.0;
+    if(buffer_sr <= 0.0 || x->sr <= 0)
+        return 1.0;
+    return buffer_sr / (double)x->sr;
 }
@@ -0,0 +1,112 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+    #define SIMD_X86 1
+    #if defined(_MSC_VER)
+        #include <intrin.h>
+    #else
+        #include <cpuid.h>
+    #endif
+#endif
+
+#ifdef SIMD_X86
+
+struct CpuFeatures {
+    bool sse2 = false, avx = false, avx2 = false, avx512 = false;
+};
+
+static void cpuid(int info[4], int leaf){
+#if defined(_MSC_VER)
+    __cpuidex(info, leaf, 0);
+#else
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+    __cpuid_count(leaf, 0, a, b, c, d);
+    info[0] = (int)a; info[1] = (int)b; info[2] = (int)c; info[3] = (int)d;
+#endif
+}
+
+// registers saved by the OS
+static unsigned long long xgetbv0(){
+#if defined(_MSC_VER)
+    return _xgetbv(0);
+#else
+    unsigned int eax = 0, edx = 0;
+    __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+    return ((unsigned long long)edx << 32) | eax;
+#endif
+}
+
+static CpuFeatures detectCpu(){
+    CpuFeatures features;
+    int info[4];
+    cpuid(info, 0);
+    int max_leaf = info[0];
+
+    cpuid(info, 1);
+    features.sse2 = (info[3] >> 26) & 1;
+    bool osxsave = (info[2] >> 27) & 1;
+    bool avx = (info[2] >> 28) & 1;
+    unsigned long long xcr0 = osxsave ? xgetbv0() : 0;
+    bool os_ymm = (xcr0 & 0x6) == 0x6;
+    bool os_zmm = (xcr0 & 0xe6) == 0xe6;
+
+    features.avx = avx && os_ymm;
+    if(max_leaf >= 7){
+        cpuid(info, 7);
+        features.avx2 = features.avx && ((info[1] >> 5) & 1);
+        features.avx512 = features.avx2 && os_zmm && ((info[1] >> 16) & 1);
+    }
+    return features;
+}
+
+#endif
+
+std::vector<const SimdKernels*> getAvailableSimdKernels(){
+    std::vector<const SimdKernels*> kernels {&getScalarKernels()};
+#ifdef SIMD_X86
+    CpuFeatures cpu = detectCpu();
+    if(cpu.sse2 && getSimdKernelsSSE2())
+        kernels.push_back(getSimdKernelsSSE2());
+    if(cpu.avx && getSimdKernelsAVX())
+        kernels.push_back(getSimdKernelsAVX());
+    if(cpu.avx2 && getSimdKernelsAVX2())
+        kernels.push_back(getSimdKernelsAVX2());
+    if(cpu.avx512 && getSimdKernelsAVX512())
+        kernels.push_back(getSimdKernelsAVX512());
+#else
+    // NEON is part of the baseline when it is compiled in
+    if(getSimdKernelsNEON())
+        kernels.push_back(getSimdKernelsNEON());
+#endif
+    return kernels;
+}
+
+const SimdKernels& getSimdKernels(){
+    static const SimdKernels* kernels = getAvailableSimdKernels().back();
+    return *kernels;
+}
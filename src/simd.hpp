@@ -0,0 +1,71 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef simd_hpp
+#define simd_hpp
+
+#include <cstddef>
+#include <vector>
+#include "common.h"
+
+/**
+ Kernels of one instruction set. Each instruction set lives in its own translation unit (simd_*.cpp),
+ compiled with its own flags, and is only called if the CPU supports it.
+ */
+struct SimdKernels {
+    const char* name;
+
+    // output channels are written from their first sample, any numChannels is accepted
+    void (*deinterleave)(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels);
+
+    // output[i] = (double)input[i], same signature as a PlanarRingBuffer copy
+    void (*convert)(const float* input, double* output, size_t numSamples);
+
+    // output[i] = value
+    void (*fill)(double* output, double value, size_t numSamples);
+
+    // output[i] = input interpolated at position + i * step, with the polyphase filter bank of a PolyphaseResampler
+    // (phases rows of taps coefficients). input must be readable taps / 2 frames around every position.
+    void (*resample)(const float* input, REAL* output, size_t numSamples, double position, double step,
+                     const float* bank, size_t taps, size_t phases);
+};
+
+// best kernels for this CPU, selected once
+const SimdKernels& getSimdKernels();
+
+// reference implementation
+const SimdKernels& getScalarKernels();
+
+// every kernel set compiled in and supported by this CPU, scalar first
+std::vector<const SimdKernels*> getAvailableSimdKernels();
+
+// one per instruction set: nullptr when the translation unit was not compiled for it
+const SimdKernels* getSimdKernelsSSE2();
+const SimdKernels* getSimdKernelsAVX();
+const SimdKernels* getSimdKernelsAVX2();
+const SimdKernels* getSimdKernelsAVX512();
+const SimdKernels* getSimdKernelsNEON();
+
+#endif /* simd_hpp */
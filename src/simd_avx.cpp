@@ -0,0 +1,170 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__AVX__)
+
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+// transpose 4 rows of 4 floats inside each 128-bit lane
+static inline void transpose4_lanes(__m256& r0, __m256& r1, __m256& r2, __m256& r3){
+    __m256 t0 = _mm256_unpacklo_ps(r0, r1);
+    __m256 t1 = _mm256_unpackhi_ps(r0, r1);
+    __m256 t2 = _mm256_unpacklo_ps(r2, r3);
+    __m256 t3 = _mm256_unpackhi_ps(r2, r3);
+    r0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+    r1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+    r2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+    r3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+static void deinterleave_avx(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t simd_width = 8; // 8 floats per AVX register
+    size_t i = 0;
+
+    if (numChannels == 1) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            _mm256_storeu_ps(output[0] + i, _mm256_loadu_ps(interleaved + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 2;
+            __m256 stereo1 = _mm256_loadu_ps(in); // l0, r0, l1, r1, l2, r2, l3, r3
+            __m256 stereo2 = _mm256_loadu_ps(in + simd_width); // l4, r4, l5, r5, l6, r6, l7, r7
+
+            // AVX has no lane crossing shuffle: swap the middle halves first
+            __m256 low = _mm256_permute2f128_ps(stereo1, stereo2, 0x20); // l0, r0, l1, r1, l4, r4, l5, r5
+            __m256 high = _mm256_permute2f128_ps(stereo1, stereo2, 0x31); // l2, r2, l3, r3, l6, r6, l7, r7
+
+            _mm256_storeu_ps(output[0] + i, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0))); // L channel
+            _mm256_storeu_ps(output[1] + i, _mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))); // R channel
+        }
+    }
+    else if (numChannels == 3) {
+        // 128-bit shuffles, same as SSE2 but VEX encoded
+        for (; i + 4 <= numSamples; i += 4) {
+            const float* in = interleaved + i * 3;
+            __m128 vec0 = _mm_loadu_ps(in); // l0, r0, c0, l1
+            __m128 vec1 = _mm_loadu_ps(in + 4); // r1, c1, l2, r2
+            __m128 vec2 = _mm_loadu_ps(in + 8); // c2, l3, r3, c3
+
+            __m128 l_low = _mm_shuffle_ps(vec0, vec0, _MM_SHUFFLE(3, 3, 0, 0));
+            __m128 l_high = _mm_shuffle_ps(vec1, vec2, _MM_SHUFFLE(1, 1, 2, 2));
+            __m128 r_low = _mm_shuffle_ps(vec0, vec1, _MM_SHUFFLE(0, 0, 1, 1));
+            __m128 r_high = _mm_shuffle_ps(vec1, vec2, _MM_SHUFFLE(2, 2, 3, 3));
+            __m128 c_low = _mm_shuffle_ps(vec0, vec1, _MM_SHUFFLE(1, 1, 2, 2));
+            __m128 c_high = _mm_shuffle_ps(vec2, vec2, _MM_SHUFFLE(3, 3, 0, 0));
+
+            _mm_storeu_ps(output[0] + i, _mm_shuffle_ps(l_low, l_high, _MM_SHUFFLE(2, 0, 2, 0))); // L channel
+            _mm_storeu_ps(output[1] + i, _mm_shuffle_ps(r_low, r_high, _MM_SHUFFLE(2, 0, 2, 0))); // R channel
+            _mm_storeu_ps(output[2] + i, _mm_shuffle_ps(c_low, c_high, _MM_SHUFFLE(2, 0, 2, 0))); // C channel
+        }
+    }
+    else if (numChannels == 4) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 4;
+            __m256 vec0 = _mm256_loadu_ps(in); // frames 0, 1
+            __m256 vec1 = _mm256_loadu_ps(in + simd_width); // frames 2, 3
+            __m256 vec2 = _mm256_loadu_ps(in + 2 * simd_width); // frames 4, 5
+            __m256 vec3 = _mm256_loadu_ps(in + 3 * simd_width); // frames 6, 7
+
+            __m256 row0 = _mm256_permute2f128_ps(vec0, vec2, 0x20); // frames 0, 4
+            __m256 row1 = _mm256_permute2f128_ps(vec0, vec2, 0x31); // frames 1, 5
+            __m256 row2 = _mm256_permute2f128_ps(vec1, vec3, 0x20); // frames 2, 6
+            __m256 row3 = _mm256_permute2f128_ps(vec1, vec3, 0x31); // frames 3, 7
+            transpose4_lanes(row0, row1, row2, row3);
+
+            _mm256_storeu_ps(output[0] + i, row0); // L channel
+            _mm256_storeu_ps(output[1] + i, row1); // R channel
+            _mm256_storeu_ps(output[2] + i, row2); // C channel
+            _mm256_storeu_ps(output[3] + i, row3); // S channel
+        }
+    }
+    else {
+        i = deinterleave_wide(interleaved, output, numSamples, numChannels);
+    }
+
+    deinterleave_tail(interleaved, output, i, numSamples, numChannels);
+}
+
+static void convert_avx(const float* input, double* output, size_t numSamples){
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_pd(output + i, _mm256_cvtps_pd(_mm_loadu_ps(input + i)));
+        _mm256_storeu_pd(output + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(input + i + 4)));
+    }
+    convert_tail(input, output, i, numSamples);
+}
+
+static void fill_avx(double* output, double value, size_t numSamples){
+    const __m256d values = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_pd(output + i, values);
+        _mm256_storeu_pd(output + i + 4, values);
+    }
+    fill_tail(output, value, i, numSamples);
+}
+
+static void resample_avx(const float* input, REAL* output, size_t numSamples, double position, double step,
+                         const float* bank, size_t taps, size_t phases){
+    for(size_t i = 0; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        __m256 sum = _mm256_setzero_ps();
+        size_t k = 0;
+        for (; k + 8 <= taps; k += 8) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(in + k), _mm256_loadu_ps(row + k)));
+        }
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_add_ss(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 1, 1, 1)));
+        output[i] = _mm_cvtss_f32(half) + dot_tail(in, row, k, taps);
+    }
+}
+
+static const SimdKernels avx_kernels = {
+    "AVX",
+    deinterleave_avx,
+    convert_avx,
+    fill_avx,
+    resample_avx,
+};
+
+const SimdKernels* getSimdKernelsAVX(){
+    return &avx_kernels;
+}
+
+#else
+
+const SimdKernels* getSimdKernelsAVX(){
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,199 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+static void deinterleave_avx2(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t simd_width = 8; // 8 floats per AVX register
+    size_t i = 0;
+
+    if (numChannels == 1) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            _mm256_storeu_ps(output[0] + i, _mm256_loadu_ps(interleaved + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 2;
+            __m256 stereo1 = _mm256_loadu_ps(in); // l0, r0, l1, r1, ..., l3, r3
+            __m256 stereo2 = _mm256_loadu_ps(in + simd_width); // l4, r4, l5, r5, ..., l7, r7
+
+            __m256 deinterleavedL_low = _mm256_permutevar8x32_ps(stereo1, _mm256_setr_epi32(0, 2, 4, 6, -1, -1, -1, -1));
+            __m256 deinterleavedL_high = _mm256_permutevar8x32_ps(stereo2, _mm256_setr_epi32(-1, -1, -1, -1, 0, 2, 4, 6));
+
+            __m256 deinterleavedR_low = _mm256_permutevar8x32_ps(stereo1, _mm256_setr_epi32(1, 3, 5, 7, -1, -1, -1, -1));
+            __m256 deinterleavedR_high = _mm256_permutevar8x32_ps(stereo2, _mm256_setr_epi32(-1, -1, -1, -1, 1, 3, 5, 7));
+
+            __m256 deinterleavedL = _mm256_blend_ps(deinterleavedL_low, deinterleavedL_high, 0b11110000);
+            __m256 deinterleavedR = _mm256_blend_ps(deinterleavedR_low, deinterleavedR_high, 0b11110000);
+
+            _mm256_storeu_ps(output[0] + i, deinterleavedL); // L channel
+            _mm256_storeu_ps(output[1] + i, deinterleavedR); // R channel
+        }
+    }
+    else if (numChannels == 3) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 3;
+            __m256 vec0 = _mm256_loadu_ps(in); // l0, r0, c0, l1, r1, c1, l2, r2
+            __m256 vec1 = _mm256_loadu_ps(in + simd_width); // c2, l3, r3, c3, l4, r4, c4, l5
+            __m256 vec2 = _mm256_loadu_ps(in + 2 * simd_width); // r5, c5, l6, r6, c6, l7, r7, c7
+
+            __m256 shuffled_l0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 6, 3, 0));
+            __m256 shuffled_l1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 7, 4, 1, 0, 0, 0));
+            __m256 shuffled_l2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(5, 2, 0, 0, 0, 0, 0, 0));
+            shuffled_l0 = _mm256_blend_ps(shuffled_l1, shuffled_l0, 0b00000111);
+            shuffled_l0 = _mm256_blend_ps(shuffled_l2, shuffled_l0, 0b00111111);
+
+            __m256 shuffled_r0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 7, 4, 1));
+            __m256 shuffled_r1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 5, 2, 0, 0, 0));
+            __m256 shuffled_r2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(6, 3, 0, 0, 0, 0, 0, 0));
+            shuffled_r0 = _mm256_blend_ps(shuffled_r1, shuffled_r0, 0b00000111);
+            shuffled_r0 = _mm256_blend_ps(shuffled_r2, shuffled_r0, 0b00011111);
+
+            __m256 shuffled_c0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 0, 5, 2));
+            __m256 shuffled_c1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 6, 3, 0, 0, 0));
+            __m256 shuffled_c2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(7, 4, 1, 0, 0, 0, 0, 0));
+            shuffled_c0 = _mm256_blend_ps(shuffled_c1, shuffled_c0, 0b00000011);
+            shuffled_c0 = _mm256_blend_ps(shuffled_c2, shuffled_c0, 0b00011111);
+
+            _mm256_storeu_ps(output[0] + i, shuffled_l0); // L channel
+            _mm256_storeu_ps(output[1] + i, shuffled_r0); // R channel
+            _mm256_storeu_ps(output[2] + i, shuffled_c0); // C channel
+        }
+    }
+    else if (numChannels == 4) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 4;
+            __m256 vec0 = _mm256_loadu_ps(in); // l0, r0, c0, s0, l1, r1, c1, s1
+            __m256 vec1 = _mm256_loadu_ps(in + simd_width); // l2, r2, c2, s2, l3, r3, c3, s3
+            __m256 vec2 = _mm256_loadu_ps(in + 2 * simd_width); // l4, r4, c4, s4, l5, r5, c5, s5
+            __m256 vec3 = _mm256_loadu_ps(in + 3 * simd_width); // l6, r6, c6, s6, l7, r7, c7, s7
+
+            __m256 shuffled_l0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 0, 4, 0));
+            __m256 shuffled_l1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 0, 4, 0, 0, 0));
+            __m256 shuffled_l2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(0, 0, 4, 0, 0, 0, 0, 0));
+            __m256 shuffled_l3 = _mm256_permutevar8x32_ps(vec3, _mm256_set_epi32(4, 0, 0, 0, 0, 0, 0, 0));
+            shuffled_l0 = _mm256_blend_ps(shuffled_l1, shuffled_l0, 0b00000011);
+            shuffled_l0 = _mm256_blend_ps(shuffled_l2, shuffled_l0, 0b00001111);
+            shuffled_l0 = _mm256_blend_ps(shuffled_l3, shuffled_l0, 0b00111111);
+
+            __m256 shuffled_r0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 0, 5, 1));
+            __m256 shuffled_r1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 0, 5, 1, 0, 0));
+            __m256 shuffled_r2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(0, 0, 5, 1, 0, 0, 0, 0));
+            __m256 shuffled_r3 = _mm256_permutevar8x32_ps(vec3, _mm256_set_epi32(5, 1, 0, 0, 0, 0, 0, 0));
+            shuffled_r0 = _mm256_blend_ps(shuffled_r1, shuffled_r0, 0b00000011);
+            shuffled_r0 = _mm256_blend_ps(shuffled_r2, shuffled_r0, 0b00001111);
+            shuffled_r0 = _mm256_blend_ps(shuffled_r3, shuffled_r0, 0b00111111);
+
+            __m256 shuffled_c0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 0, 6, 2));
+            __m256 shuffled_c1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 0, 6, 2, 0, 0));
+            __m256 shuffled_c2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(0, 0, 6, 2, 0, 0, 0, 0));
+            __m256 shuffled_c3 = _mm256_permutevar8x32_ps(vec3, _mm256_set_epi32(6, 2, 0, 0, 0, 0, 0, 0));
+            shuffled_c0 = _mm256_blend_ps(shuffled_c1, shuffled_c0, 0b00000011);
+            shuffled_c0 = _mm256_blend_ps(shuffled_c2, shuffled_c0, 0b00001111);
+            shuffled_c0 = _mm256_blend_ps(shuffled_c3, shuffled_c0, 0b00111111);
+
+            __m256 shuffled_s0 = _mm256_permutevar8x32_ps(vec0, _mm256_set_epi32(0, 0, 0, 0, 0, 0, 7, 3));
+            __m256 shuffled_s1 = _mm256_permutevar8x32_ps(vec1, _mm256_set_epi32(0, 0, 0, 0, 7, 3, 0, 0));
+            __m256 shuffled_s2 = _mm256_permutevar8x32_ps(vec2, _mm256_set_epi32(0, 0, 7, 3, 0, 0, 0, 0));
+            __m256 shuffled_s3 = _mm256_permutevar8x32_ps(vec3, _mm256_set_epi32(7, 3, 0, 0, 0, 0, 0, 0));
+            shuffled_s0 = _mm256_blend_ps(shuffled_s1, shuffled_s0, 0b00000011);
+            shuffled_s0 = _mm256_blend_ps(shuffled_s2, shuffled_s0, 0b00001111);
+            shuffled_s0 = _mm256_blend_ps(shuffled_s3, shuffled_s0, 0b00111111);
+
+            _mm256_storeu_ps(output[0] + i, shuffled_l0); // L channel
+            _mm256_storeu_ps(output[1] + i, shuffled_r0); // R channel
+            _mm256_storeu_ps(output[2] + i, shuffled_c0); // C channel
+            _mm256_storeu_ps(output[3] + i, shuffled_s0); // S channel
+        }
+    }
+    else {
+        i = deinterleave_wide(interleaved, output, numSamples, numChannels);
+    }
+
+    deinterleave_tail(interleaved, output, i, numSamples, numChannels);
+}
+
+static void convert_avx2(const float* input, double* output, size_t numSamples){
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_pd(output + i, _mm256_cvtps_pd(_mm_loadu_ps(input + i)));
+        _mm256_storeu_pd(output + i + 4, _mm256_cvtps_pd(_mm_loadu_ps(input + i + 4)));
+    }
+    convert_tail(input, output, i, numSamples);
+}
+
+static void fill_avx2(double* output, double value, size_t numSamples){
+    const __m256d values = _mm256_set1_pd(value);
+    size_t i = 0;
+    for (; i + 8 <= numSamples; i += 8) {
+        _mm256_storeu_pd(output + i, values);
+        _mm256_storeu_pd(output + i + 4, values);
+    }
+    fill_tail(output, value, i, numSamples);
+}
+
+static void resample_avx2(const float* input, REAL* output, size_t numSamples, double position, double step,
+                         const float* bank, size_t taps, size_t phases){
+    for(size_t i = 0; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        __m256 sum = _mm256_setzero_ps();
+        size_t k = 0;
+        for (; k + 8 <= taps; k += 8) {
+            sum = _mm256_add_ps(sum, _mm256_mul_ps(_mm256_loadu_ps(in + k), _mm256_loadu_ps(row + k)));
+        }
+        __m128 half = _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+        half = _mm_add_ps(half, _mm_movehl_ps(half, half));
+        half = _mm_add_ss(half, _mm_shuffle_ps(half, half, _MM_SHUFFLE(1, 1, 1, 1)));
+        output[i] = _mm_cvtss_f32(half) + dot_tail(in, row, k, taps);
+    }
+}
+
+static const SimdKernels avx2_kernels = {
+    "AVX2",
+    deinterleave_avx2,
+    convert_avx2,
+    fill_avx2,
+    resample_avx2,
+};
+
+const SimdKernels* getSimdKernelsAVX2(){
+    return &avx2_kernels;
+}
+
+#else
+
+const SimdKernels* getSimdKernelsAVX2(){
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,182 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__AVX512F__)
+
+#include <immintrin.h>
+#include "simd_kernels.hpp"
+
+/**
+ Index of a two-register permutation: lane j takes sample `j * numChannels + channel` of the 32 floats of (a, b),
+ lanes out of range keep lane j of a.
+ */
+static inline __m512i strided_index(size_t numChannels, size_t channel){
+    alignas(64) int index[16];
+    for(int j = 0; j < 16; ++j){
+        int sample = (int)(j * numChannels + channel);
+        index[j] = sample < 32 ? sample : j;
+    }
+    return _mm512_load_si512(index);
+}
+
+static void deinterleave_avx512(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t simd_width = 16; // 16 floats per AVX-512 register
+    size_t i = 0;
+
+    if (numChannels == 1) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            _mm512_storeu_ps(output[0] + i, _mm512_loadu_ps(interleaved + i));
+        }
+    }
+    else if (numChannels == 2) {
+        const __m512i index_l = strided_index(2, 0);
+        const __m512i index_r = strided_index(2, 1);
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 2;
+            __m512 stereo1 = _mm512_loadu_ps(in); // l0, r0, ..., l7, r7
+            __m512 stereo2 = _mm512_loadu_ps(in + simd_width); // l8, r8, ..., l15, r15
+
+            _mm512_storeu_ps(output[0] + i, _mm512_permutex2var_ps(stereo1, index_l, stereo2)); // L channel
+            _mm512_storeu_ps(output[1] + i, _mm512_permutex2var_ps(stereo1, index_r, stereo2)); // R channel
+        }
+    }
+    else if (numChannels == 3) {
+        // samples 0..31 come from (vec0, vec1), the rest from vec2
+        __m512i index_low[3], index_high[3];
+        for(size_t c = 0; c < 3; ++c){
+            index_low[c] = strided_index(3, c);
+            alignas(64) int index[16];
+            for(int j = 0; j < 16; ++j){
+                int sample = (int)(j * 3 + c);
+                index[j] = sample < 32 ? j : 16 + (sample - 32);
+            }
+            index_high[c] = _mm512_load_si512(index);
+        }
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 3;
+            __m512 vec0 = _mm512_loadu_ps(in);
+            __m512 vec1 = _mm512_loadu_ps(in + simd_width);
+            __m512 vec2 = _mm512_loadu_ps(in + 2 * simd_width);
+
+            for(size_t c = 0; c < 3; ++c){
+                __m512 low = _mm512_permutex2var_ps(vec0, index_low[c], vec1);
+                _mm512_storeu_ps(output[c] + i, _mm512_permutex2var_ps(low, index_high[c], vec2));
+            }
+        }
+    }
+    else if (numChannels == 4) {
+        // first pass: 2 channels x 8 frames per register, second pass: merge the halves
+        alignas(64) int pair_index[2][16];
+        alignas(64) int merge_index[2][16];
+        for(int j = 0; j < 16; ++j){
+            for(int p = 0; p < 2; ++p){
+                pair_index[p][j] = (j & 7) * 4 + 2 * p + (j >> 3);
+                merge_index[p][j] = (j < 8 ? 0 : 16) + 8 * p + (j & 7);
+            }
+        }
+        const __m512i index_lr = _mm512_load_si512(pair_index[0]);
+        const __m512i index_cs = _mm512_load_si512(pair_index[1]);
+        const __m512i index_low = _mm512_load_si512(merge_index[0]);
+        const __m512i index_high = _mm512_load_si512(merge_index[1]);
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 4;
+            __m512 vec0 = _mm512_loadu_ps(in); // frames 0..3
+            __m512 vec1 = _mm512_loadu_ps(in + simd_width); // frames 4..7
+            __m512 vec2 = _mm512_loadu_ps(in + 2 * simd_width); // frames 8..11
+            __m512 vec3 = _mm512_loadu_ps(in + 3 * simd_width); // frames 12..15
+
+            __m512 lr_low = _mm512_permutex2var_ps(vec0, index_lr, vec1); // l0..l7, r0..r7
+            __m512 cs_low = _mm512_permutex2var_ps(vec0, index_cs, vec1); // c0..c7, s0..s7
+            __m512 lr_high = _mm512_permutex2var_ps(vec2, index_lr, vec3); // l8..l15, r8..r15
+            __m512 cs_high = _mm512_permutex2var_ps(vec2, index_cs, vec3); // c8..c15, s8..s15
+
+            _mm512_storeu_ps(output[0] + i, _mm512_permutex2var_ps(lr_low, index_low, lr_high)); // L channel
+            _mm512_storeu_ps(output[1] + i, _mm512_permutex2var_ps(lr_low, index_high, lr_high)); // R channel
+            _mm512_storeu_ps(output[2] + i, _mm512_permutex2var_ps(cs_low, index_low, cs_high)); // C channel
+            _mm512_storeu_ps(output[3] + i, _mm512_permutex2var_ps(cs_low, index_high, cs_high)); // S channel
+        }
+    }
+    else {
+        i = deinterleave_wide(interleaved, output, numSamples, numChannels);
+    }
+
+    deinterleave_tail(interleaved, output, i, numSamples, numChannels);
+}
+
+static void convert_avx512(const float* input, double* output, size_t numSamples){
+    size_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        _mm512_storeu_pd(output + i, _mm512_cvtps_pd(_mm256_loadu_ps(input + i)));
+        _mm512_storeu_pd(output + i + 8, _mm512_cvtps_pd(_mm256_loadu_ps(input + i + 8)));
+    }
+    convert_tail(input, output, i, numSamples);
+}
+
+static void fill_avx512(double* output, double value, size_t numSamples){
+    const __m512d values = _mm512_set1_pd(value);
+    size_t i = 0;
+    for (; i + 16 <= numSamples; i += 16) {
+        _mm512_storeu_pd(output + i, values);
+        _mm512_storeu_pd(output + i + 8, values);
+    }
+    fill_tail(output, value, i, numSamples);
+}
+
+static void resample_avx512(const float* input, REAL* output, size_t numSamples, double position, double step,
+                            const float* bank, size_t taps, size_t phases){
+    for(size_t i = 0; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        __m512 sum = _mm512_setzero_ps();
+        size_t k = 0;
+        for (; k + 16 <= taps; k += 16) {
+            sum = _mm512_fmadd_ps(_mm512_loadu_ps(in + k), _mm512_loadu_ps(row + k), sum);
+        }
+        output[i] = _mm512_reduce_add_ps(sum) + dot_tail(in, row, k, taps);
+    }
+}
+
+static const SimdKernels avx512_kernels = {
+    "AVX-512",
+    deinterleave_avx512,
+    convert_avx512,
+    fill_avx512,
+    resample_avx512,
+};
+
+const SimdKernels* getSimdKernelsAVX512(){
+    return &avx512_kernels;
+}
+
+#else
+
+const SimdKernels* getSimdKernelsAVX512(){
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,189 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef simd_kernels_hpp
+#define simd_kernels_hpp
+
+/**
+ Helpers shared by the simd_*.cpp translation units.
+
+ Everything here has internal linkage: each translation unit keeps its own copy, compiled with its own flags.
+ Standard library templates are avoided in the kernels for the same reason: the linker could
+ otherwise keep an AVX-512 instantiation for code running on any CPU.
+ */
+
+#include <cstddef>
+#include "common.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+    #include <xmmintrin.h>
+    #define SIMD_HAS_TRANSPOSE4 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #include <arm_neon.h>
+    #define SIMD_HAS_TRANSPOSE4 1
+#endif
+
+// frames per tile of the blocked transposes: 64 frames x 64 channels stay in L1
+#define DEINTERLEAVE_TILE 64
+
+/**
+ Cache blocked transpose from `from` to numSamples, any channel count.
+ Reads stay within a tile of frames while each output channel is written contiguously.
+ */
+static inline void deinterleave_tail(const float* interleaved, REAL* const* output, size_t from, size_t numSamples, size_t numChannels){
+    for(size_t start = from; start < numSamples; start += DEINTERLEAVE_TILE){
+        const size_t stop = start + DEINTERLEAVE_TILE < numSamples ? start + DEINTERLEAVE_TILE : numSamples;
+        for(size_t c = 0; c < numChannels; ++c){
+            const float* in = interleaved + c;
+            REAL* out = output[c];
+            for(size_t i = start; i < stop; ++i)
+                out[i] = in[i * numChannels];
+        }
+    }
+}
+
+#ifdef SIMD_HAS_TRANSPOSE4
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+typedef float32x4_t simd_float4;
+static inline simd_float4 simd_load4(const float* p){ return vld1q_f32(p); }
+static inline void simd_store4(float* p, simd_float4 v){ vst1q_f32(p, v); }
+static inline void simd_transpose4(simd_float4& r0, simd_float4& r1, simd_float4& r2, simd_float4& r3){
+    float32x4x2_t t01 = vtrnq_f32(r0, r1);
+    float32x4x2_t t23 = vtrnq_f32(r2, r3);
+    r0 = vcombine_f32(vget_low_f32(t01.val[0]), vget_low_f32(t23.val[0]));
+    r1 = vcombine_f32(vget_low_f32(t01.val[1]), vget_low_f32(t23.val[1]));
+    r2 = vcombine_f32(vget_high_f32(t01.val[0]), vget_high_f32(t23.val[0]));
+    r3 = vcombine_f32(vget_high_f32(t01.val[1]), vget_high_f32(t23.val[1]));
+}
+#else
+typedef __m128 simd_float4;
+static inline simd_float4 simd_load4(const float* p){ return _mm_loadu_ps(p); }
+static inline void simd_store4(float* p, simd_float4 v){ _mm_storeu_ps(p, v); }
+static inline void simd_transpose4(simd_float4& r0, simd_float4& r1, simd_float4& r2, simd_float4& r3){
+    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+#endif
+
+/**
+ Blocked 4x4 transposes, the channels left over by groups of 4 are copied one by one within the same tile.
+ N is the channel count known at compile time, or 0 to use numChannels.
+ - Returns: number of frames done (a multiple of 4), the rest is left to deinterleave_tail
+ */
+template<size_t N>
+static inline size_t deinterleave_transpose4(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t nc = N ? N : numChannels;
+    const size_t end = numSamples & ~(size_t)3;
+    for(size_t start = 0; start < end; start += DEINTERLEAVE_TILE){
+        const size_t stop = start + DEINTERLEAVE_TILE < end ? start + DEINTERLEAVE_TILE : end;
+        size_t c = 0;
+        for(; c + 4 <= nc; c += 4){
+            for(size_t i = start; i < stop; i += 4){
+                const float* in = interleaved + i * nc + c;
+                simd_float4 r0 = simd_load4(in);
+                simd_float4 r1 = simd_load4(in + nc);
+                simd_float4 r2 = simd_load4(in + 2 * nc);
+                simd_float4 r3 = simd_load4(in + 3 * nc);
+                simd_transpose4(r0, r1, r2, r3);
+                simd_store4(output[c] + i, r0);
+                simd_store4(output[c + 1] + i, r1);
+                simd_store4(output[c + 2] + i, r2);
+                simd_store4(output[c + 3] + i, r3);
+            }
+        }
+        // leftover channels: only with a runtime count (the specialized counts are multiples of 4)
+        if constexpr (N == 0 || N % 4 != 0){
+            for(; c < nc; ++c){
+                const float* in = interleaved + c;
+                REAL* out = output[c];
+                for(size_t i = start; i < stop; ++i)
+                    out[i] = in[i * nc];
+            }
+        }
+    }
+    return end;
+}
+
+/**
+ More than 4 channels: specialized for the usual multichannel layouts.
+ - Returns: number of frames done
+ */
+static inline size_t deinterleave_wide(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    switch(numChannels){
+        case 8: return deinterleave_transpose4<8>(interleaved, output, numSamples, numChannels);
+        case 16: return deinterleave_transpose4<16>(interleaved, output, numSamples, numChannels);
+        case 32: return deinterleave_transpose4<32>(interleaved, output, numSamples, numChannels);
+        case 64: return deinterleave_transpose4<64>(interleaved, output, numSamples, numChannels);
+        default: return deinterleave_transpose4<0>(interleaved, output, numSamples, numChannels);
+    }
+}
+
+#endif
+
+static inline void convert_tail(const float* input, double* output, size_t from, size_t numSamples){
+    for(size_t i = from; i < numSamples; ++i)
+        output[i] = input[i];
+}
+
+static inline void fill_tail(double* output, double value, size_t from, size_t numSamples){
+    for(size_t i = from; i < numSamples; ++i)
+        output[i] = value;
+}
+
+/**
+ Filter row and first input frame of the output sample at `position`:
+ the nearest of the `phases` fractional phases, applied to the taps frames around it.
+ A fraction rounding up to `phases` is phase 0 of the next frame: the taps then reach frame + taps / 2 + 1.
+ */
+static inline void resample_taps(const float* input, double position, const float* bank, size_t taps, size_t phases,
+                                 const float*& in, const float*& row){
+    long frame = (long)position;
+    size_t phase = (size_t)((position - (double)frame) * (double)phases + 0.5);
+    if(phase == phases){
+        ++frame;
+        phase = 0;
+    }
+    in = input + frame - (long)(taps / 2) + 1;
+    row = bank + phase * taps;
+}
+
+static inline float dot_tail(const float* a, const float* b, size_t from, size_t n){
+    float sum = 0.0f;
+    for(size_t i = from; i < n; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+static inline void resample_tail(const float* input, REAL* output, size_t from, size_t numSamples, double position, double step,
+                                 const float* bank, size_t taps, size_t phases){
+    for(size_t i = from; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        output[i] = dot_tail(in, row, 0, taps);
+    }
+}
+
+#endif /* simd_kernels_hpp */
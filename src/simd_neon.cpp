@@ -0,0 +1,135 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+
+#include <arm_neon.h>
+#include "simd_kernels.hpp"
+
+static void deinterleave_neon(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t simd_width = 4; // 4 floats
+    size_t i = 0;
+
+    if(numChannels == 1){
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            float32x4_t samples = vld1q_f32(&interleaved[i]);
+            vst1q_f32(&output[0][i], samples);
+        }
+    }
+    else if(numChannels==2){
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            // (L0, R0, L1, R1, L2, R2, L3, R3)
+            float32x4x2_t stereo = vld2q_f32(&interleaved[i * 2]);
+            vst1q_f32(&output[0][i], stereo.val[0]);
+            vst1q_f32(&output[1][i], stereo.val[1]);
+        }
+    }
+    else if(numChannels==3){
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            // (L0, R0, C0, L1, R1, C1, L2, R2, C2, L3, R3, C3)
+            float32x4x3_t multi = vld3q_f32(&interleaved[i * 3]);
+            vst1q_f32(&output[0][i], multi.val[0]);
+            vst1q_f32(&output[1][i], multi.val[1]);
+            vst1q_f32(&output[2][i], multi.val[2]);
+        }
+    }
+    else if(numChannels==4){
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            // (L0, R0, C0, D0, L1, R1, C1, D1
+            float32x4x4_t multi = vld4q_f32(&interleaved[i * 4]);
+            vst1q_f32(&output[0][i], multi.val[0]);
+            vst1q_f32(&output[1][i], multi.val[1]);
+            vst1q_f32(&output[2][i], multi.val[2]);
+            vst1q_f32(&output[3][i], multi.val[3]);
+        }
+    }
+    else{
+        i = deinterleave_wide(interleaved, output, numSamples, numChannels);
+    }
+
+    deinterleave_tail(interleaved, output, i, numSamples, numChannels);
+}
+
+static void convert_neon(const float* input, double* output, size_t numSamples){
+    size_t i = 0;
+#if defined(__aarch64__)
+    for (; i + 4 <= numSamples; i += 4) {
+        float32x4_t samples = vld1q_f32(input + i);
+        vst1q_f64(output + i, vcvt_f64_f32(vget_low_f32(samples)));
+        vst1q_f64(output + i + 2, vcvt_high_f64_f32(samples));
+    }
+#endif
+    convert_tail(input, output, i, numSamples);
+}
+
+static void fill_neon(double* output, double value, size_t numSamples){
+    size_t i = 0;
+#if defined(__aarch64__)
+    const float64x2_t values = vdupq_n_f64(value);
+    for (; i + 4 <= numSamples; i += 4) {
+        vst1q_f64(output + i, values);
+        vst1q_f64(output + i + 2, values);
+    }
+#endif
+    fill_tail(output, value, i, numSamples);
+}
+
+static void resample_neon(const float* input, REAL* output, size_t numSamples, double position, double step,
+                          const float* bank, size_t taps, size_t phases){
+    for(size_t i = 0; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        float32x4_t sum = vdupq_n_f32(0.0f);
+        size_t k = 0;
+        for (; k + 4 <= taps; k += 4) {
+            sum = vmlaq_f32(sum, vld1q_f32(in + k), vld1q_f32(row + k));
+        }
+        float32x2_t pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+        output[i] = vget_lane_f32(vpadd_f32(pair, pair), 0) + dot_tail(in, row, k, taps);
+    }
+}
+
+static const SimdKernels neon_kernels = {
+    "ARM NEON",
+    deinterleave_neon,
+    convert_neon,
+    fill_neon,
+    resample_neon,
+};
+
+const SimdKernels* getSimdKernelsNEON(){
+    return &neon_kernels;
+}
+
+#else
+
+const SimdKernels* getSimdKernelsNEON(){
+    return nullptr;
+}
+
+#endif
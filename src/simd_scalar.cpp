@@ -0,0 +1,56 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+#include "simd_kernels.hpp"
+
+static void deinterleave_scalar(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    deinterleave_tail(interleaved, output, 0, numSamples, numChannels);
+}
+
+static void convert_scalar(const float* input, double* output, size_t numSamples){
+    convert_tail(input, output, 0, numSamples);
+}
+
+static void fill_scalar(double* output, double value, size_t numSamples){
+    fill_tail(output, value, 0, numSamples);
+}
+
+static void resample_scalar(const float* input, REAL* output, size_t numSamples, double position, double step,
+                            const float* bank, size_t taps, size_t phases){
+    resample_tail(input, output, 0, numSamples, position, step, bank, taps, phases);
+}
+
+static const SimdKernels scalar_kernels = {
+    "NO SIMD",
+    deinterleave_scalar,
+    convert_scalar,
+    fill_scalar,
+    resample_scalar,
+};
+
+const SimdKernels& getScalarKernels(){
+    return scalar_kernels;
+}
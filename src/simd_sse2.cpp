@@ -0,0 +1,150 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "simd.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+
+#include <emmintrin.h>
+#include "simd_kernels.hpp"
+
+static void deinterleave_sse2(const float* interleaved, REAL* const* output, size_t numSamples, size_t numChannels){
+    const size_t simd_width = 4; // 4 floats per SSE register
+    size_t i = 0;
+
+    if (numChannels == 1) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            _mm_storeu_ps(output[0] + i, _mm_loadu_ps(interleaved + i));
+        }
+    }
+    else if (numChannels == 2) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 2;
+            __m128 stereo1 = _mm_loadu_ps(in); // l0, r0, l1, r1
+            __m128 stereo2 = _mm_loadu_ps(in + simd_width); // l2, r2, l3, r3
+
+            _mm_storeu_ps(output[0] + i, _mm_shuffle_ps(stereo1, stereo2, _MM_SHUFFLE(2, 0, 2, 0))); // L channel
+            _mm_storeu_ps(output[1] + i, _mm_shuffle_ps(stereo1, stereo2, _MM_SHUFFLE(3, 1, 3, 1))); // R channel
+        }
+    }
+    else if (numChannels == 3) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 3;
+            __m128 vec0 = _mm_loadu_ps(in); // l0, r0, c0, l1
+            __m128 vec1 = _mm_loadu_ps(in + simd_width); // r1, c1, l2, r2
+            __m128 vec2 = _mm_loadu_ps(in + 2 * simd_width); // c2, l3, r3, c3
+
+            // gather pairs (x x y y) then keep one of each
+            __m128 l_low = _mm_shuffle_ps(vec0, vec0, _MM_SHUFFLE(3, 3, 0, 0)); // l0 l0 l1 l1
+            __m128 l_high = _mm_shuffle_ps(vec1, vec2, _MM_SHUFFLE(1, 1, 2, 2)); // l2 l2 l3 l3
+            __m128 r_low = _mm_shuffle_ps(vec0, vec1, _MM_SHUFFLE(0, 0, 1, 1)); // r0 r0 r1 r1
+            __m128 r_high = _mm_shuffle_ps(vec1, vec2, _MM_SHUFFLE(2, 2, 3, 3)); // r2 r2 r3 r3
+            __m128 c_low = _mm_shuffle_ps(vec0, vec1, _MM_SHUFFLE(1, 1, 2, 2)); // c0 c0 c1 c1
+            __m128 c_high = _mm_shuffle_ps(vec2, vec2, _MM_SHUFFLE(3, 3, 0, 0)); // c2 c2 c3 c3
+
+            _mm_storeu_ps(output[0] + i, _mm_shuffle_ps(l_low, l_high, _MM_SHUFFLE(2, 0, 2, 0))); // L channel
+            _mm_storeu_ps(output[1] + i, _mm_shuffle_ps(r_low, r_high, _MM_SHUFFLE(2, 0, 2, 0))); // R channel
+            _mm_storeu_ps(output[2] + i, _mm_shuffle_ps(c_low, c_high, _MM_SHUFFLE(2, 0, 2, 0))); // C channel
+        }
+    }
+    else if (numChannels == 4) {
+        for (; i + simd_width <= numSamples; i += simd_width) {
+            const float* in = interleaved + i * 4;
+            __m128 vec0 = _mm_loadu_ps(in); // l0, r0, c0, s0
+            __m128 vec1 = _mm_loadu_ps(in + simd_width); // l1, r1, c1, s1
+            __m128 vec2 = _mm_loadu_ps(in + 2 * simd_width); // l2, r2, c2, s2
+            __m128 vec3 = _mm_loadu_ps(in + 3 * simd_width); // l3, r3, c3, s3
+
+            _MM_TRANSPOSE4_PS(vec0, vec1, vec2, vec3);
+
+            _mm_storeu_ps(output[0] + i, vec0); // L channel
+            _mm_storeu_ps(output[1] + i, vec1); // R channel
+            _mm_storeu_ps(output[2] + i, vec2); // C channel
+            _mm_storeu_ps(output[3] + i, vec3); // S channel
+        }
+    }
+    else {
+        i = deinterleave_wide(interleaved, output, numSamples, numChannels);
+    }
+
+    deinterleave_tail(interleaved, output, i, numSamples, numChannels);
+}
+
+static void convert_sse2(const float* input, double* output, size_t numSamples){
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 samples = _mm_loadu_ps(input + i);
+        _mm_storeu_pd(output + i, _mm_cvtps_pd(samples));
+        _mm_storeu_pd(output + i + 2, _mm_cvtps_pd(_mm_movehl_ps(samples, samples)));
+    }
+    convert_tail(input, output, i, numSamples);
+}
+
+static void fill_sse2(double* output, double value, size_t numSamples){
+    const __m128d values = _mm_set1_pd(value);
+    size_t i = 0;
+    for (; i + 4 <= numSamples; i += 4) {
+        _mm_storeu_pd(output + i, values);
+        _mm_storeu_pd(output + i + 2, values);
+    }
+    fill_tail(output, value, i, numSamples);
+}
+
+static void resample_sse2(const float* input, REAL* output, size_t numSamples, double position, double step,
+                          const float* bank, size_t taps, size_t phases){
+    for(size_t i = 0; i < numSamples; ++i){
+        const float* in;
+        const float* row;
+        resample_taps(input, position + (double)i * step, bank, taps, phases, in, row);
+        __m128 sum = _mm_setzero_ps();
+        size_t k = 0;
+        for (; k + 4 <= taps; k += 4) {
+            sum = _mm_add_ps(sum, _mm_mul_ps(_mm_loadu_ps(in + k), _mm_loadu_ps(row + k)));
+        }
+        sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+        sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+        output[i] = _mm_cvtss_f32(sum) + dot_tail(in, row, k, taps);
+    }
+}
+
+static const SimdKernels sse2_kernels = {
+    "SSE2",
+    deinterleave_sse2,
+    convert_sse2,
+    fill_sse2,
+    resample_sse2,
+};
+
+const SimdKernels* getSimdKernelsSSE2(){
+    return &sse2_kernels;
+}
+
+#else
+
+const SimdKernels* getSimdKernelsSSE2(){
+    return nullptr;
+}
+
+#endif
@@ -0,0 +1,679 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef spectral_hpp
+#define spectral_hpp
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+#include "common.h"
+
+/**
+ In-place radix-2 complex FFT. The twiddles and the bit reversal are computed by resize(),
+ the transforms do not allocate. inverse() is not normalised (scaled by size()).
+ The stages run on split real and imaginary parts: contiguous butterflies the compiler vectorises (see stage()).
+ */
+class Fft {
+public:
+    explicit Fft(size_t size = 0){ resize(size); }
+
+    // size: power of 2
+    void resize(size_t size){
+        if(size == reversed.size())
+            return;
+        const double pi = 3.14159265358979323846;
+        // the twiddles of every stage one after the other, those of a stage of half values from half - 1
+        twiddle_real.resize(size > 1 ? size - 1 : 0);
+        twiddle_imag.resize(twiddle_real.size());
+        for(size_t half = 1; half < size; half <<= 1){
+            for(size_t k = 0; k < half; ++k){
+                const double angle = -pi * (double)k / (double)half;
+                twiddle_real[half - 1 + k] = (float)std::cos(angle);
+                twiddle_imag[half - 1 + k] = (float)std::sin(angle);
+            }
+        }
+        reversed.resize(size);
+        size_t bits = 0;
+        while(((size_t)1 << bits) < size)
+            ++bits;
+        for(size_t i = 0; i < size; ++i){
+            size_t r = 0;
+            for(size_t b = 0; b < bits; ++b)
+                r |= ((i >> b) & 1) << (bits - 1 - b);
+            reversed[i] = r;
+        }
+        split_real.resize(size);
+        split_imag.resize(size);
+    }
+
+    size_t size() const { return reversed.size(); }
+
+    void forward(std::complex<float>* data){ transform(data, false); }
+    void inverse(std::complex<float>* data){ transform(data, true); }
+
+    // split real and imaginary parts
+    void forward(float* real, float* imag) const {
+        reorder(real, imag);
+        stages(real, imag);
+    }
+    // the forward transform with the real and imaginary parts swapped
+    void inverse(float* real, float* imag) const { forward(imag, real); }
+
+    // position of input value i in bit reversed order: filled in this order, the input skips the reordering
+    size_t reversedIndex(size_t i) const { return reversed[i]; }
+    void forwardReordered(float* real, float* imag) const { stages(real, imag); }
+    void inverseReordered(float* real, float* imag) const { stages(imag, real); }
+
+private:
+    void transform(std::complex<float>* data, bool inverse){
+        const size_t n = size();
+        for(size_t i = 0; i < n; ++i){
+            split_real[i] = data[i].real();
+            split_imag[i] = data[i].imag();
+        }
+        if(inverse)
+            this->inverse(split_real.data(), split_imag.data());
+        else
+            forward(split_real.data(), split_imag.data());
+        for(size_t i = 0; i < n; ++i)
+            data[i] = std::complex<float>(split_real[i], split_imag[i]);
+    }
+
+    void reorder(float* real, float* imag) const {
+        const size_t n = size();
+        for(size_t i = 0; i < n; ++i){
+            const size_t r = reversed[i];
+            if(i < r){
+                std::swap(real[i], real[r]);
+                std::swap(imag[i], imag[r]);
+            }
+        }
+    }
+
+    void stages(float* real, float* imag) const {
+        const size_t n = size();
+        if(n == 2){
+            const float ar = real[0], ai = imag[0];
+            real[0] += real[1];
+            imag[0] += imag[1];
+            real[1] = ar - real[1];
+            imag[1] = ai - imag[1];
+            return;
+        }
+        // first two stages at once: twiddles 1 and -i
+        for(size_t i = 0; i + 3 < n; i += 4){
+            const float s0r = real[i] + real[i + 1], s0i = imag[i] + imag[i + 1];
+            const float d0r = real[i] - real[i + 1], d0i = imag[i] - imag[i + 1];
+            const float s1r = real[i + 2] + real[i + 3], s1i = imag[i + 2] + imag[i + 3];
+            const float d1r = real[i + 2] - real[i + 3], d1i = imag[i + 2] - imag[i + 3];
+            real[i] = s0r + s1r;
+            imag[i] = s0i + s1i;
+            real[i + 2] = s0r - s1r;
+            imag[i + 2] = s0i - s1i;
+            real[i + 1] = d0r + d1i;
+            imag[i + 1] = d0i - d1r;
+            real[i + 3] = d0r - d1i;
+            imag[i + 3] = d0i + d1r;
+        }
+        for(size_t half = 4; half < n; half <<= 1){
+            for(size_t block = 0; block < n; block += 2 * half)
+                stage(real + block, imag + block, real + block + half, imag + block + half, half,
+                      twiddle_real.data() + half - 1, twiddle_imag.data() + half - 1);
+        }
+    }
+
+    // butterflies of one block of 2 * half values, a = first half, b = second half: none of the arrays overlap
+    static void stage(float* __restrict ar, float* __restrict ai, float* __restrict br, float* __restrict bi, size_t half,
+                      const float* __restrict wr, const float* __restrict wi){
+        for(size_t k = 0; k < half; ++k){
+            const float tr = wr[k] * br[k] - wi[k] * bi[k];
+            const float ti = wr[k] * bi[k] + wi[k] * br[k];
+            br[k] = ar[k] - tr;
+            bi[k] = ai[k] - ti;
+            ar[k] += tr;
+            ai[k] += ti;
+        }
+    }
+
+    std::vector<float> twiddle_real;
+    std::vector<float> twiddle_imag;
+    std::vector<size_t> reversed;
+    std::vector<float> split_real;      // interleaved complex transforms
+    std::vector<float> split_imag;
+};
+
+/**
+ FFT of real signals of a power of 2 size, through a complex FFT of half the size.
+ The spectrum holds the size / 2 + 1 bins of positive frequencies. inverse() is not normalised (scaled by size()).
+ */
+class RealFft {
+public:
+    // size: power of 2, at least 4
+    void resize(size_t size){
+        if(size == full)
+            return;
+        const double pi = 3.14159265358979323846;
+        full = size;
+        half.resize(size / 2);
+        packed_real.resize(size / 2);
+        packed_imag.resize(size / 2);
+        twiddle_real.resize(size / 2);
+        twiddle_imag.resize(size / 2);
+        for(size_t k = 0; k < size / 2; ++k){
+            twiddle_real[k] = (float)std::cos(-2.0 * pi * (double)k / (double)size);
+            twiddle_imag[k] = (float)std::sin(-2.0 * pi * (double)k / (double)size);
+        }
+    }
+
+    size_t size() const { return full; }
+
+    void forward(const float* input, std::complex<float>* spectrum){
+        const size_t h = full / 2;
+        for(size_t m = 0; m < h; ++m){
+            const size_t r = half.reversedIndex(m);
+            packed_real[r] = input[2 * m];
+            packed_imag[r] = input[2 * m + 1];
+        }
+        half.forwardReordered(packed_real.data(), packed_imag.data());
+        // even and odd samples untangled from the packed spectrum: X[k] = E[k] + twiddle[k] O[k]
+        spectrum[0] = std::complex<float>(packed_real[0] + packed_imag[0], 0.0f);
+        spectrum[h] = std::complex<float>(packed_real[0] - packed_imag[0], 0.0f);
+        for(size_t k = 1; k < h; ++k){
+            const float zr = packed_real[k], zi = packed_imag[k];
+            const float mr = packed_real[h - k], mi = -packed_imag[h - k];
+            const float er = 0.5f * (zr + mr), ei = 0.5f * (zi + mi);
+            const float orr = 0.5f * (zi - mi), oi = -0.5f * (zr - mr);
+            spectrum[k] = std::complex<float>(er + twiddle_real[k] * orr - twiddle_imag[k] * oi,
+                                              ei + twiddle_real[k] * oi + twiddle_imag[k] * orr);
+        }
+    }
+
+    void inverse(const std::complex<float>* spectrum, float* output){
+        const size_t h = full / 2;
+        for(size_t k = 0; k < h; ++k){
+            const float xr = spectrum[k].real(), xi = spectrum[k].imag();
+            const float mr = spectrum[h - k].real(), mi = -spectrum[h - k].imag();
+            const float er = 0.5f * (xr + mr), ei = 0.5f * (xi + mi);
+            const float dr = 0.5f * (xr - mr), di = 0.5f * (xi - mi);
+            // O[k] = (X[k] - conj(X[h - k])) / 2 * conj(twiddle[k]), Z[k] = E[k] + i O[k]
+            const float orr = dr * twiddle_real[k] + di * twiddle_imag[k];
+            const float oi = di * twiddle_real[k] - dr * twiddle_imag[k];
+            const size_t r = half.reversedIndex(k);
+            packed_real[r] = er - oi;
+            packed_imag[r] = ei + orr;
+        }
+        half.inverseReordered(packed_real.data(), packed_imag.data());
+        // scaled by size() like Fft
+        for(size_t m = 0; m < h; ++m){
+            output[2 * m] = 2.0f * packed_real[m];
+            output[2 * m + 1] = 2.0f * packed_imag[m];
+        }
+    }
+
+private:
+    size_t full = 0;
+    Fft half;
+    std::vector<float> packed_real;
+    std::vector<float> packed_imag;
+    std::vector<float> twiddle_real;
+    std::vector<float> twiddle_imag;
+};
+
+/**
+ STFT frames of the spectral paths (analysis cache, freeze): a Hann window of fft_size samples every hop samples.
+ */
+struct SpectralLayout {
+    int fft_size = 0;
+    int hop = 0;
+
+    int bins() const { return fft_size / 2 + 1; }
+    bool operator==(const SpectralLayout& other) const { return fft_size == other.fft_size && hop == other.hop; }
+    bool operator!=(const SpectralLayout& other) const { return !(*this == other); }
+};
+
+/**
+ Layout matching the block and interval of a mode (see configureStretch), in powers of 2.
+ The hop is at most a quarter of the window, for a constant overlap-add gain.
+ */
+inline SpectralLayout spectralLayout(long mode, double sampleRate){
+    const double block = mode == 1 ? 0.1 : 0.12;
+    const double interval = mode == 1 ? 0.04 : mode == 2 ? 0.02 : mode == 3 ? 0.015 : 0.03;
+    auto nearestPow2 = [](double n){
+        return 1 << (int)std::lround(std::log2(std::max(n, 16.0)));
+    };
+    SpectralLayout layout;
+    layout.fft_size = nearestPow2(block * sampleRate);
+    layout.hop = std::min(nearestPow2(interval * sampleRate), layout.fft_size / 4);
+    return layout;
+}
+
+/**
+ Magnitude and phase of one bin of an analysis frame.
+ */
+struct SpectralBin {
+    float magnitude;
+    float phase;
+};
+
+/**
+ Analysis of single STFT frames. Allocates in setLayout() only.
+ */
+class SpectralAnalyser {
+public:
+    void setLayout(const SpectralLayout& newLayout){
+        if(newLayout == layout)
+            return;
+        layout = newLayout;
+        fft.resize((size_t)layout.fft_size);
+        window = hannWindow(layout.fft_size);
+        windowed.resize((size_t)layout.fft_size);
+        spectrum.resize((size_t)layout.bins());
+    }
+
+    const SpectralLayout& getLayout() const { return layout; }
+
+    /**
+     - Parameters:
+     - input: fft_size samples, centered on the frame position
+     - output: bins() bins
+     */
+    void analyse(const REAL* input, SpectralBin* output){
+        const int n = layout.fft_size;
+        for(int i = 0; i < n; ++i)
+            windowed[i] = input[i] * window[i];
+        fft.forward(windowed.data(), spectrum.data());
+        for(int b = 0; b < layout.bins(); ++b){
+            output[b].magnitude = std::sqrt(spectrum[b].real() * spectrum[b].real() + spectrum[b].imag() * spectrum[b].imag());
+            output[b].phase = std::arg(spectrum[b]);
+        }
+    }
+
+    static std::vector<float> hannWindow(int size){
+        const double pi = 3.14159265358979323846;
+        std::vector<float> window((size_t)size);
+        for(int i = 0; i < size; ++i)
+            window[i] = (float)(0.5 - 0.5 * std::cos(2.0 * pi * (double)i / (double)size));
+        return window;
+    }
+
+private:
+    SpectralLayout layout;
+    RealFft fft;
+    std::vector<float> window;
+    std::vector<float> windowed;
+    std::vector<std::complex<float>> spectrum;
+};
+
+/**
+ Phase vocoder synthesis from analysis frames: the spectral paths only pay for the synthesis.
+
+ Every hop, the magnitudes are interpolated between the two frames around the read position
+ and each peak of the spectrum advances its phase by the frequency measured between these frames: a position
+ moving slowly (or not at all) plays the sound at its pitch instead of repeating a frame.
+ The other bins keep their analysed phase offset to the nearest peak (identity phase locking),
+ so the bins of a partial stay coherent instead of drifting apart.
+ While the hops read the same frames at the same fraction (freeze), the spectrum is held: only the peaks
+ turn by their phase advance, a complex product per bin instead of a sine and cosine.
+ The output is overlap-added with the analysis window, hop samples are ready after each synthesis.
+ Allocates in configure() only, when the layout or the channel count change.
+ */
+class SpectralSynth {
+public:
+    void configure(const SpectralLayout& newLayout, int numChannels){
+        if(newLayout == layout && numChannels == num_channels)
+            return;
+        layout = newLayout;
+        num_channels = numChannels;
+        const int n = layout.fft_size;
+        const size_t bins = (size_t)layout.bins();
+        fft.resize((size_t)n);
+        window = SpectralAnalyser::hannWindow(n);
+        // Hann analysis x Hann synthesis, overlapped every hop: the gain is applied with the synthesis window
+        double sum = 0.0;
+        for(int i = 0; i < n; ++i)
+            sum += (double)window[i] * (double)window[i];
+        const float ola_gain = (float)((double)layout.hop / sum / (double)n);
+        for(float& w : window)
+            w *= ola_gain;
+        spectrum.resize(bins);
+        signal.resize((size_t)n);
+        states.assign((size_t)num_channels, Channel());
+        for(Channel& channel : states){
+            channel.phase.assign(bins, 0.0f);
+            channel.overlap.assign((size_t)n, 0.0f);
+            channel.magnitudes.resize(bins);
+            channel.sources.resize(bins);
+            channel.peaks.resize(bins);
+            channel.deltas.resize(bins);
+            channel.shape.resize(bins);
+            channel.regions.reserve(bins);
+        }
+        reset();
+    }
+
+    const SpectralLayout& getLayout() const { return layout; }
+    int channels() const { return num_channels; }
+
+    /**
+     Restart: drop the overlap-add tail, the next synthesis takes the phases of its frames.
+     */
+    void reset(){
+        for(Channel& channel : states){
+            std::fill(channel.overlap.begin(), channel.overlap.end(), 0.0f);
+            channel.a = channel.b = nullptr;
+            channel.held = false;
+        }
+        ready = 0;
+        restart = true;
+    }
+
+    /**
+     The frames given by frameAt have been rewritten (or replaced by others at the same address):
+     the next synthesis reads them again, the phases go on.
+     */
+    void framesChanged(){
+        for(Channel& channel : states)
+            release(channel);
+    }
+
+    /**
+     Render `frames` output frames.
+     
+     - Parameters:
+     - frameAt: `const SpectralBin* frameAt(long index, int channel)`, analysis frame `index` (centered on index * hop), nullptr: silence
+     - position: read position in analysis samples, moved by step * hop every hop
+     - step: analysis samples per output sample
+     - transpose: frequency factor
+     - output: channels() channels
+     - frames: frames to render
+     */
+    template<class Frames>
+    void render(const Frames& frameAt, double& position, double step, float transpose, REAL* const* output, long frames){
+        long done = 0;
+        while(done < frames){
+            if(ready == 0){
+                // after a restart the overlap-add starts full: the windows before the position are synthesised first
+                if(restart){
+                    const int overlaps = layout.fft_size / layout.hop;
+                    for(int k = overlaps - 1; k > 0; --k)
+                        synthesise(frameAt, position - step * (double)(k * layout.hop), transpose);
+                }
+                synthesise(frameAt, position, transpose);
+                position += step * (double)layout.hop;
+            }
+            const long start = layout.hop - ready;
+            const long count = std::min((long)ready, frames - done);
+            for(int c = 0; c < num_channels; ++c)
+                std::copy(states[c].overlap.data() + start, states[c].overlap.data() + start + count, output[c] + done);
+            ready -= (int)count;
+            done += count;
+        }
+    }
+
+private:
+    // held run of bins turning with the same peak (peak < 0: bins without a peak, not turning)
+    struct Region {
+        int peak;
+        int end;                                // one past the last bin
+        std::complex<float> rotation;           // e^(i phase)
+        std::complex<float> advance;            // e^(i delta)
+    };
+
+    // synthesis state of one channel
+    struct Channel {
+        std::vector<float> phase;               // per output bin: phase at the last synthesis (of the peaks while not held)
+        std::vector<REAL> overlap;              // fft_size samples being overlap-added, the first hop is the next output
+        // frames and fraction of the last synthesis
+        const SpectralBin* a = nullptr;
+        const SpectralBin* b = nullptr;
+        float fraction = 0.0f;
+        float transpose = 0.0f;
+        int used = 0;                           // output bins read from the source
+        std::vector<float> magnitudes;          // per output bin
+        std::vector<int> sources;               // source bin of each output bin
+        std::vector<int> peaks;                 // nearest peak of each output bin
+        std::vector<float> deltas;              // per peak: phase advance over a hop
+        // held spectrum (same frames and fraction as the last synthesis)
+        bool held = false;
+        std::vector<std::complex<float>> shape;     // per bin: magnitude at its phase offset to its peak
+        std::vector<Region> regions;                // bins of the same peak, in order
+    };
+
+    // back from a held spectrum: the phases of the peaks are those of their rotations
+    static void release(Channel& channel){
+        if(channel.held){
+            for(const Region& region : channel.regions){
+                if(region.peak >= 0)
+                    channel.phase[region.peak] = std::arg(region.rotation);
+            }
+        }
+        channel.held = false;
+        channel.a = channel.b = nullptr;
+    }
+
+    template<class Frames>
+    void synthesise(const Frames& frameAt, double position, float transpose){
+        const double pi = 3.14159265358979323846;
+        const int n = layout.fft_size;
+        const int hop = layout.hop;
+        const double index = position / (double)hop;
+        const long first = (long)std::floor(index);
+        const float fraction = (float)(index - (double)first);
+        
+        for(int c = 0; c < num_channels; ++c){
+            Channel& channel = states[c];
+            // the hop played before
+            std::vector<REAL>& ola = channel.overlap;
+            std::copy(ola.begin() + hop, ola.end(), ola.begin());
+            std::fill(ola.end() - hop, ola.end(), 0.0f);
+            
+            const SpectralBin* a = frameAt(first, c);
+            const SpectralBin* b = frameAt(first + 1, c);
+            if(!a){
+                a = b;
+            }
+            if(!b){
+                b = a;
+            }
+            if(!a){
+                release(channel);
+                continue;
+            }
+            
+            if(!restart && a == channel.a && b == channel.b && fraction == channel.fraction && transpose == channel.transpose){
+                hold(channel);
+            }
+            else{
+                release(channel);
+                readFrames(channel, a, b, fraction, transpose);
+                
+                std::vector<float>& phase = channel.phase;
+                for(int bin = 0; bin < channel.used; ++bin){
+                    const int peak = channel.peaks[bin];
+                    if(peak != bin)
+                        continue;
+                    if(restart)
+                        phase[bin] = a[channel.sources[bin]].phase;
+                    else{
+                        const double advanced = (double)phase[bin] + (double)channel.deltas[bin];
+                        phase[bin] = (float)(advanced - 2.0 * pi * std::floor(advanced / (2.0 * pi)));
+                    }
+                }
+                for(int bin = 0; bin < channel.used; ++bin){
+                    const int peak = channel.peaks[bin];
+                    if(peak >= 0 && peak != bin)
+                        phase[bin] = phase[peak] + a[channel.sources[bin]].phase - a[channel.sources[peak]].phase;
+                    spectrum[bin] = std::polar(channel.magnitudes[bin], phase[bin]);
+                }
+            }
+            std::fill(spectrum.begin() + channel.used, spectrum.end(), std::complex<float>(0.0f, 0.0f));
+            
+            fft.inverse(spectrum.data(), signal.data());
+            for(int i = 0; i < n; ++i)
+                ola[i] += signal[i] * window[i];
+        }
+        restart = false;
+        ready = hop;
+    }
+
+    // magnitudes, peaks and phase advances of the bins, from frames a and b
+    void readFrames(Channel& channel, const SpectralBin* a, const SpectralBin* b, float fraction, float transpose){
+        const double pi = 3.14159265358979323846;
+        const int bins = layout.bins();
+        channel.a = a;
+        channel.b = b;
+        channel.fraction = fraction;
+        channel.transpose = transpose;
+        
+        // magnitudes, read from the source bin of each output bin
+        std::vector<float>& magnitudes = channel.magnitudes;
+        std::vector<int>& peaks = channel.peaks;
+        int used = 0;
+        for(; used < bins; ++used){
+            const int s = (int)((float)used / transpose + 0.5f);
+            if(s >= bins)
+                break;
+            channel.sources[used] = s;
+            magnitudes[used] = a[s].magnitude + fraction * (b[s].magnitude - a[s].magnitude);
+        }
+        channel.used = used;
+        
+        // nearest peak of every bin
+        int last = -1;
+        for(int bin = 0; bin < used; ++bin){
+            const bool peak = (bin == 0 || magnitudes[bin] >= magnitudes[bin - 1])
+                           && (bin + 1 == used || magnitudes[bin] > magnitudes[bin + 1]);
+            if(peak)
+                last = bin;
+            peaks[bin] = last;
+        }
+        int next = -1;
+        for(int bin = used - 1; bin >= 0; --bin){
+            if(peaks[bin] == bin)
+                next = bin;
+            if(next >= 0 && (peaks[bin] < 0 || next - bin < bin - peaks[bin]))
+                peaks[bin] = next;
+        }
+        
+        // phase advance of the peaks over a hop: the expected one of the bin, plus the measured deviation
+        for(int bin = 0; bin < used; ++bin){
+            if(peaks[bin] != bin)
+                continue;
+            const int s = channel.sources[bin];
+            const double expected = 2.0 * pi * (double)s * (double)layout.hop / (double)layout.fft_size;
+            double deviation = (double)b[s].phase - (double)a[s].phase - expected;
+            deviation -= 2.0 * pi * std::floor(deviation / (2.0 * pi) + 0.5);
+            double delta = (expected + deviation) * (double)transpose;
+            channel.deltas[bin] = (float)(delta - 2.0 * pi * std::floor(delta / (2.0 * pi)));
+        }
+    }
+
+    // same frames and fraction as the last synthesis: the peaks turn, the spectrum keeps its shape
+    void hold(Channel& channel){
+        const int used = channel.used;
+        const int* peaks = channel.peaks.data();
+        std::complex<float>* shape = channel.shape.data();
+        std::vector<Region>& regions = channel.regions;
+        if(!channel.held){
+            // the nearest peak of the bins only changes between runs
+            const SpectralBin* a = channel.a;
+            const int* sources = channel.sources.data();
+            regions.clear();
+            for(int bin = 0; bin < used; ++bin){
+                const int peak = peaks[bin];
+                if(regions.empty() || regions.back().peak != peak){
+                    Region region{peak, bin, {1.0f, 0.0f}, {1.0f, 0.0f}};
+                    if(peak >= 0){
+                        region.rotation = std::polar(1.0f, channel.phase[peak]);
+                        region.advance = std::polar(1.0f, channel.deltas[peak]);
+                    }
+                    regions.push_back(region);
+                }
+                regions.back().end = bin + 1;
+                if(peak == bin)
+                    shape[bin] = std::complex<float>(channel.magnitudes[bin], 0.0f);
+                else if(peak >= 0)
+                    shape[bin] = std::polar(channel.magnitudes[bin], a[sources[bin]].phase - a[sources[peak]].phase);
+                else
+                    shape[bin] = std::polar(channel.magnitudes[bin], channel.phase[bin]);
+            }
+            channel.held = true;
+        }
+        // written out: std::complex products check for infinities and NaNs
+        std::complex<float>* out = spectrum.data();
+        int bin = 0;
+        for(Region& region : regions){
+            float re = region.rotation.real(), im = region.rotation.imag();
+            if(region.peak >= 0){
+                const std::complex<float> d = region.advance;
+                const float turnedRe = re * d.real() - im * d.imag();
+                const float turnedIm = re * d.imag() + im * d.real();
+                // stays on the unit circle (one Newton step of 1 / |r|)
+                const float gain = 1.5f - 0.5f * (turnedRe * turnedRe + turnedIm * turnedIm);
+                re = turnedRe * gain;
+                im = turnedIm * gain;
+                region.rotation = std::complex<float>(re, im);
+            }
+            for(; bin < region.end; ++bin){
+                const std::complex<float> s = shape[bin];
+                out[bin] = std::complex<float>(s.real() * re - s.imag() * im, s.real() * im + s.imag() * re);
+            }
+        }
+    }
+
+    SpectralLayout layout;
+    int num_channels = 0;
+    RealFft fft;
+    std::vector<float> window;                  // synthesis window, overlap-add gain included
+    std::vector<std::complex<float>> spectrum;  // bins of the synthesis
+    std::vector<float> signal;
+    std::vector<Channel> states;
+    int ready = 0;                              // samples of the first hop not output yet
+    bool restart = true;
+};
+
+/**
+ Crossfade of the stretcher output and a spectral path over a chunk, into `outputs`:
+ towards the synthesis when entering the spectral path, towards the stretcher when leaving it.
+ The first frame is still (almost) the path handing over, the last one the path taking over.
+ */
+inline void spectralCrossfade(REAL* const* outputs, const REAL* const* spectral, size_t channels, long frames, bool entering){
+    for(size_t c = 0; c < channels; ++c){
+        REAL* out = outputs[c];
+        const REAL* in = spectral[c];
+        for(long i = 0; i < frames; ++i){
+            REAL gain = (REAL)(i + 1) / (REAL)frames;
+            if(!entering)
+                gain = 1.0f - gain;
+            out[i] += gain * (in[i] - out[i]);
+        }
+    }
+}
+
+#endif /* spectral_hpp */
@@ -0,0 +1,56 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef stretch_modes_hpp
+#define stretch_modes_hpp
+
+#include "../signalsmith-stretch/signalsmith-stretch.h"
+#include "common.h"
+
+/**
+ Configure a stretcher for one of the presets of the `mode` attribute.
+
+ - Parameters:
+ - stretch: stretcher to configure
+ - numChannels: channels processed
+ - mode: 0 default, 1 cheaper, 2 and 3 longer blocks with shorter intervals
+ - sampleRate: output sample rate
+ */
+inline void configureStretch(signalsmith::stretch::SignalsmithStretch<REAL>& stretch, int numChannels, long mode, float sampleRate){
+    if(mode==1){
+        stretch.presetCheaper(numChannels, sampleRate);
+    }
+    else if (mode == 2){
+        stretch.configure(numChannels, sampleRate*0.12f, sampleRate*0.02f);
+    }
+    else if (mode == 3){
+        stretch.configure(numChannels, sampleRate*0.12f, sampleRate*0.015);
+    }
+    else{
+        stretch.presetDefault(numChannels, sampleRate);
+    }
+}
+
+#endif /* stretch_modes_hpp */
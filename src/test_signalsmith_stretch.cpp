@@ -1,6 +1,31 @@
 #include <gtest/gtest.h>
+#include "analysis_cache.hpp"
+#include "capture_ring.hpp"
+#include "channel_groups.hpp"
 #include "deinterleave.hpp" // Include your external's header
+#include "mapped_file.hpp"
+#include "mode_switch.hpp"
+#include "offline_render.hpp"
+#include "param_stream.hpp"
+#include "planar_mirror.hpp"
+#include "render_size.hpp"
+#include "render_stats.hpp"
+#include "reset_request.hpp"
+#include "resampler.hpp"
+#include "ringbuffer.hpp"
+#include "semaphore.hpp"
+#include "simd.hpp"
+#include "trace.hpp"
+#include "worker_pool.hpp"
 
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <thread>
 #include <tuple>
 
 void getData(int num_elements, int num_channels, int test_channel, std::vector<float>& input, std::vector<float>& expected){
@@ -22,6 +47,32 @@ void doTest(int num_elements, int num_channels, int test_channel){
     EXPECT_EQ(output[test_channel], expected);
 }
 
+// the pointer API, with an offset, must match the vector API and leave the rest of the buffers untouched
+void doParityTest(int num_elements, int num_channels, int offset){
+    std::vector<float> input;
+    std::vector<float> unused;
+    getData(num_elements, num_channels, 0, input, unused);
+
+    std::vector<std::vector<REAL>> reference;
+    deinterleave(input.data(), reference, num_elements, num_channels);
+
+    const REAL guard = -1.0f;
+    std::vector<std::vector<REAL>> planar(num_channels, std::vector<REAL>(offset + num_elements + 8, guard));
+    std::vector<REAL*> channels;
+    for(auto& channel : planar)
+        channels.push_back(channel.data());
+    deinterleave(input.data(), channels.data(), num_elements, num_channels, offset);
+
+    for(int c = 0; c < num_channels; ++c){
+        for(int i = 0; i < offset; ++i)
+            ASSERT_EQ(planar[c][i], guard);
+        for(int i = 0; i < num_elements; ++i)
+            ASSERT_EQ(planar[c][offset + i], reference[c][i]) << "channel " << c << " sample " << i;
+        for(int i = offset + num_elements; i < (int)planar[c].size(); ++i)
+            ASSERT_EQ(planar[c][i], guard);
+    }
+}
+
 TEST(TestSignalsmithStretch, Error0) {
     std::vector<float> data {0.1, 0.2, 0.3, 0.4, 0.5, 0.6, 0.7, 0.8};
     std::vector<std::vector<REAL>> output;
@@ -127,7 +178,1988 @@ TEST(TestSignalsmithStretch, Test4channels_4)
     doTest(4, 4, 0);
 }
 
+// ----- more channels
+
+TEST(TestSignalsmithStretch, Test6channels_0)
+{
+    doTest(131, 6, 5);
+}
+
+TEST(TestSignalsmithStretch, Test8channels_0)
+{
+    doTest(257, 8, 7);
+}
+
+TEST(TestSignalsmithStretch, Test12channels_0)
+{
+    doTest(67, 12, 9);
+}
+
+TEST(TestSignalsmithStretch, Test16channels_0)
+{
+    doTest(130, 16, 3);
+}
+
+TEST(TestSignalsmithStretch, Test64channels_0)
+{
+    doTest(1077, 64, 0);
+}
+
+TEST(TestSignalsmithStretch, Test64channels_1)
+{
+    doTest(65, 64, 63);
+}
+
+// ----- caller owned buffers
+
+TEST(TestSignalsmithStretch, ParityPlanar)
+{
+    for(int num_channels : {1, 2, 3, 4, 6, 8, 16, MAX_BUFFER_CHANNEL}){
+        for(int num_elements : {1, 3, 4, 7, 8, 9, 16, 57, 126, 1077}){
+            for(int offset : {0, 1, 5, 32}){
+                doParityTest(num_elements, num_channels, offset);
+            }
+        }
+    }
+}
+
+// every kernel this CPU can run must match the scalar reference
+TEST(TestSignalsmithStretch, SimdKernelsMatchScalar)
+{
+    std::vector<const SimdKernels*> kernels = getAvailableSimdKernels();
+    ASSERT_FALSE(kernels.empty());
+    EXPECT_EQ(kernels.front(), &getScalarKernels());
+    EXPECT_EQ(kernels.back(), &getSimdKernels());
+
+    for(const SimdKernels* kernel : kernels){
+        for(int num_channels : {1, 2, 3, 4, 5, 6, 8, 12, 16, 32, 64, 65}){
+            for(int num_elements : {1, 3, 4, 7, 8, 15, 16, 17, 31, 33, 64, 1077}){
+                std::vector<float> input;
+                std::vector<float> unused;
+                getData(num_elements, num_channels, 0, input, unused);
+
+                std::vector<std::vector<REAL>> expected(num_channels, std::vector<REAL>(num_elements + 1, -1.0f));
+                std::vector<std::vector<REAL>> output = expected;
+                std::vector<REAL*> expected_channels, output_channels;
+                for(int c = 0; c < num_channels; ++c){
+                    expected_channels.push_back(expected[c].data());
+                    output_channels.push_back(output[c].data());
+                }
+                getScalarKernels().deinterleave(input.data(), expected_channels.data(), num_elements, num_channels);
+                kernel->deinterleave(input.data(), output_channels.data(), num_elements, num_channels);
+                ASSERT_EQ(output, expected) << kernel->name << " " << num_channels << " channels, " << num_elements << " samples";
+            }
+        }
+
+        for(int num_elements : {0, 1, 3, 4, 7, 8, 15, 16, 17, 33, 1077}){
+            std::vector<float> input(num_elements);
+            for(int i = 0; i < num_elements; ++i)
+                input[i] = 0.1f * i - 3.f;
+            std::vector<double> output(num_elements + 1, -1.0);
+            kernel->convert(input.data(), output.data(), num_elements);
+            for(int i = 0; i < num_elements; ++i)
+                ASSERT_EQ(output[i], (double)input[i]) << kernel->name << " convert " << num_elements;
+            ASSERT_EQ(output[num_elements], -1.0);
+
+            kernel->fill(output.data(), 42.5, num_elements);
+            for(int i = 0; i < num_elements; ++i)
+                ASSERT_EQ(output[i], 42.5) << kernel->name << " fill " << num_elements;
+            ASSERT_EQ(output[num_elements], -1.0);
+        }
+
+        // same phases and taps as the scalar reference, the sums only differ by rounding
+        PolyphaseResampler resampler;
+        for(double step : {0.5, 44100.0 / 48000.0, 1.0, 48000.0 / 44100.0, 2.0}){
+            resampler.setStep(step);
+            std::vector<float> input(2048);
+            for(size_t i = 0; i < input.size(); ++i)
+                input[i] = std::sin(0.05f * (float)i) + 0.25f * std::sin(0.7f * (float)i);
+            const size_t num_samples = 500;
+            std::vector<REAL> expected(num_samples + 1, -1.0f), output(num_samples + 1, -1.0f);
+            getScalarKernels().resample(input.data(), expected.data(), num_samples, 20.3, step, resampler.filterBank().data(),
+                                        PolyphaseResampler::TAPS, PolyphaseResampler::PHASES);
+            kernel->resample(input.data(), output.data(), num_samples, 20.3, step, resampler.filterBank().data(),
+                             PolyphaseResampler::TAPS, PolyphaseResampler::PHASES);
+            for(size_t i = 0; i < num_samples; ++i)
+                ASSERT_NEAR(output[i], expected[i], 1e-5f) << kernel->name << " resample " << step << " " << i;
+            ASSERT_EQ(output[num_samples], -1.0f);
+        }
+    }
+}
+
+TEST(TestSignalsmithStretch, PolyphaseResamplerSine)
+{
+    // a 44.1 kHz buffer~ played at 48 kHz
+    const double step = 44100.0 / 48000.0;
+    const double frequency = 0.02;     // radians per buffer frame, well below the cutoff
+    std::vector<float> input(4096);
+    for(size_t i = 0; i < input.size(); ++i)
+        input[i] = (float)std::sin(frequency * (double)i);
+
+    PolyphaseResampler resampler;
+    resampler.setStep(step);
+    const size_t num_samples = 2000;
+    std::vector<REAL> output(num_samples);
+
+    // two consecutive blocks carrying their fractional position: one continuous stream
+    const double start = 100.25;
+    resampler.process(input.data(), output.data(), 1000, start, step);
+    resampler.process(input.data(), output.data() + 1000, 1000, start + 1000 * step, step);
+    for(size_t i = 0; i < num_samples; ++i)
+        ASSERT_NEAR(output[i], std::sin(frequency * (start + (double)i * step)), 2e-3) << i;
+
+    // DC is kept for every phase
+    std::vector<float> dc(256, 1.0f);
+    std::vector<REAL> out(100);
+    resampler.setStep(2.0);
+    resampler.process(dc.data(), out.data(), out.size(), 20.01, 1.37);
+    for(REAL sample : out)
+        ASSERT_NEAR(sample, 1.0f, 1e-5f);
+}
+
+TEST(TestSignalsmithStretch, PolyphaseResamplerReadsWithinSpan)
+{
+    // the last position rounds up to phase 0 of the next frame: the input ends exactly at floor(last) + after(),
+    // followed by NaNs (and the end of the allocation for the address sanitizer)
+    PolyphaseResampler resampler;
+    resampler.setStep(1.0);
+    const size_t num_samples = 64;
+    const double start = PolyphaseResampler::before() + 0.9995;
+    const double last = start + (double)(num_samples - 1);
+    const size_t span = (size_t)std::floor(last) + PolyphaseResampler::after() + 1;
+    std::vector<float> dc(span + 8, std::numeric_limits<float>::quiet_NaN());
+    std::fill(dc.begin(), dc.begin() + span, 1.0f);
+    std::vector<float> exact(dc.begin(), dc.begin() + span);
+    
+    for(const SimdKernels* kernel : getAvailableSimdKernels()){
+        for(const std::vector<float>* input : {&dc, &exact}){
+            std::vector<REAL> out(num_samples);
+            kernel->resample(input->data(), out.data(), num_samples, start, 1.0, resampler.filterBank().data(),
+                             PolyphaseResampler::TAPS, PolyphaseResampler::PHASES);
+            for(size_t i = 0; i < num_samples; ++i)
+                ASSERT_NEAR(out[i], 1.0f, 1e-5f) << kernel->name << " " << i;
+        }
+    }
+}
+
+TEST(TestSignalsmithStretch, VectorReuse)
+{
+    std::vector<float> input;
+    std::vector<float> expected;
+    getData(100, 2, 1, input, expected);
+
+    std::vector<std::vector<REAL>> output;
+    deinterleave(input.data(), output, 100, 2);
+    const REAL* storage = output[1].data();
+
+    // smaller block: same storage, exact size
+    deinterleave(input.data(), output, 50, 2);
+    EXPECT_EQ(output[1].data(), storage);
+    EXPECT_EQ(output[1], std::vector<REAL>(expected.begin(), expected.begin() + 50));
+}
+
+// ----- ring buffer
+
+TEST(TestSignalsmithStretch, RingBufferWraparound)
+{
+    PlanarRingBuffer<float> ring;
+    ring.allocate(2, 16, 4);
+    EXPECT_EQ(ring.capacity(), 16);
+
+    std::vector<float> left(10), right(10);
+    const float* input[2] = {left.data(), right.data()};
+    std::vector<float> out_left(16), out_right(16);
+    float* output[2] = {out_left.data(), out_right.data()};
+
+    float next = 0;
+    float expected = 0;
+    for(int round = 0; round < 8; ++round){
+        for(int i = 0; i < 10; ++i){
+            left[i] = next;
+            right[i] = -next;
+            next++;
+        }
+        ChunkInfo info;
+        info.position = round * 100;
+        info.length = 10;
+        ASSERT_TRUE(ring.push(input, 2, 10, info));
+        // not enough room for a second chunk
+        EXPECT_FALSE(ring.push(input, 2, 10, info));
+
+        // read in two parts, across the end of the storage
+        for(size_t part : {3, 7}){
+            PlanarRingBuffer<float>::Chunk chunk;
+            size_t offset = 0;
+            ASSERT_TRUE(ring.current(chunk, offset));
+            EXPECT_EQ(chunk.info.position, round * 100);
+            EXPECT_EQ(offset, part == 3 ? 0 : 3);
+
+            ASSERT_EQ(ring.read(output, 2, part), part);
+            for(size_t i = 0; i < part; ++i){
+                EXPECT_EQ(out_left[i], expected);
+                EXPECT_EQ(out_right[i], -expected);
+                expected++;
+            }
+        }
+        EXPECT_EQ(ring.readAvailable(), 0);
+    }
+}
+
+TEST(TestSignalsmithStretch, RingBufferMissingChannelsAndFlush)
+{
+    PlanarRingBuffer<float> ring;
+    ring.allocate(3, 32);
+
+    std::vector<float> mono(8, 1.0f);
+    const float* input[1] = {mono.data()};
+    ring.push(input, 1, 8, ChunkInfo());
+    ring.push(nullptr, 0, 8, ChunkInfo());
+    EXPECT_EQ(ring.readAvailable(), 16);
+
+    std::vector<double> a(16, -1), b(16, -1), c(16, -1);
+    double* output[3] = {a.data(), b.data(), c.data()};
+    ASSERT_EQ(ring.read(output, 3, 16), 16);
+    for(int i = 0; i < 16; ++i){
+        EXPECT_EQ(a[i], i < 8 ? 1.0 : 0.0);
+        EXPECT_EQ(b[i], 0.0);
+        EXPECT_EQ(c[i], 0.0);
+    }
+
+    ring.push(input, 1, 8, ChunkInfo());
+    ring.flush();
+    EXPECT_EQ(ring.readAvailable(), 0);
+    PlanarRingBuffer<float>::Chunk chunk;
+    size_t offset;
+    EXPECT_FALSE(ring.current(chunk, offset));
+}
+
+TEST(TestSignalsmithStretch, RingBufferDropStaleGeneration)
+{
+    PlanarRingBuffer<float> ring;
+    ring.allocate(1, 64);
+
+    std::vector<float> samples(8);
+    const float* input[1] = {samples.data()};
+    ChunkInfo info;
+    for(unsigned long generation = 0; generation < 3; ++generation){
+        std::fill(samples.begin(), samples.end(), (float)generation);
+        info.generation = generation;
+        ring.push(input, 1, 8, info);
+    }
+
+    // partly read chunk: only its remaining frames are dropped
+    std::vector<double> out(8, -1);
+    double* output[1] = {out.data()};
+    ASSERT_EQ(ring.read(output, 1, 3), 3);
+
+    // what perform64 does after a seek to generation 2
+    PlanarRingBuffer<float>::Chunk chunk;
+    size_t offset = 0;
+    while(ring.current(chunk, offset) && chunk.info.generation < 2)
+        EXPECT_EQ(ring.drop(chunk.frames - offset), chunk.frames - offset);
+    ASSERT_TRUE(ring.current(chunk, offset));
+    EXPECT_EQ(chunk.info.generation, 2u);
+    EXPECT_EQ(offset, 0u);
+    EXPECT_EQ(ring.readAvailable(), 8u);
+
+    ASSERT_EQ(ring.read(output, 1, 8), 8);
+    EXPECT_EQ(out[0], 2.0);
+    EXPECT_EQ(ring.drop(8), 0u);
+}
+
+TEST(TestSignalsmithStretch, RingBufferConcurrent)
+{
+    const size_t total = 1 << 20;
+    PlanarRingBuffer<float> ring;
+    ring.allocate(2, 1024, 8);
+
+    std::thread producer([&](){
+        std::vector<float> left(97), right(97);
+        const float* input[2] = {left.data(), right.data()};
+        size_t value = 0;
+        while(value < total){
+            size_t frames = std::min<size_t>(1 + value % 97, total - value);
+            for(size_t i = 0; i < frames; ++i){
+                left[i] = (float)(value + i);
+                right[i] = -(float)(value + i);
+            }
+            ChunkInfo info;
+            info.position = (long)value;
+            info.length = (long)frames;
+            if(ring.push(input, 2, frames, info))
+                value += frames;
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    std::vector<float> left(64), right(64);
+    float* output[2] = {left.data(), right.data()};
+    size_t expected = 0;
+    bool ok = true;
+    while(expected < total && ok){
+        PlanarRingBuffer<float>::Chunk chunk;
+        size_t offset = 0;
+        if(ring.current(chunk, offset)){
+            // metadata always describes the frames read next
+            ok &= (size_t)chunk.info.position + offset == expected;
+            ok &= offset < chunk.frames;
+        }
+        size_t n = ring.read(output, 2, 1 + expected % 64);
+        for(size_t i = 0; i < n; ++i){
+            ok &= left[i] == (float)(expected + i);
+            ok &= right[i] == -(float)(expected + i);
+        }
+        expected += n;
+        if(n == 0)
+            std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(expected, total);
+}
+
+TEST(TestSignalsmithStretch, RingBufferVisibleChunkIsReadable)
+{
+    // small chunks of stale generations, pushed as fast as possible: the consumer keeps hitting
+    // the window between the publication of the frames and of the chunk
+    const size_t total = 1 << 18;
+    PlanarRingBuffer<float> ring;
+    ring.allocate(1, 256, 16);
+
+    std::thread producer([&](){
+        std::vector<float> samples(7);
+        const float* input[1] = {samples.data()};
+        size_t pushed = 0;
+        unsigned long generation = 0;
+        while(pushed < total){
+            ChunkInfo info;
+            info.generation = generation;
+            if(ring.push(input, 1, 1 + pushed % 7, info)){
+                pushed += 1 + pushed % 7;
+                generation++;
+            }
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    size_t dropped = 0;
+    bool ok = true;
+    while(dropped < total && ok){
+        // what perform64 does with stale chunks: every chunk seen has its frames readable, so the drop moves on
+        PlanarRingBuffer<float>::Chunk chunk;
+        size_t offset = 0;
+        while(ring.current(chunk, offset)){
+            ok &= offset < chunk.frames;
+            ok &= ring.readAvailable() >= chunk.frames - offset;
+            const size_t n = ring.drop(chunk.frames - offset);
+            ok &= n == chunk.frames - offset;
+            dropped += n;
+            if(n == 0)
+                break;
+        }
+        std::this_thread::yield();
+    }
+    producer.join();
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(dropped, total);
+}
+
+// ----- planar mirror
+
+TEST(TestSignalsmithStretch, PlanarSnapshotCopy)
+{
+    const long frames = 1001, channels = 3;
+    std::vector<float> interleaved(frames * channels);
+    for(long i = 0; i < frames * channels; ++i)
+        interleaved[i] = (float)i;
+
+    PlanarSnapshot snapshot(interleaved.data(), frames, channels);
+    ASSERT_EQ(snapshot.frames(), frames);
+    ASSERT_EQ(snapshot.channels(), channels);
+    EXPECT_GE(snapshot.bytes(), frames * channels * sizeof(REAL));
+    for(long c = 0; c < channels; ++c){
+        EXPECT_EQ((uintptr_t)snapshot.channel(c) % 64, 0u);
+        for(long i = 0; i < frames; ++i)
+            ASSERT_EQ(snapshot.channel(c)[i], (REAL)(i * channels + c));
+    }
+
+    // zeros on both sides of the buffer
+    std::vector<std::vector<REAL>> out(channels, std::vector<REAL>(20, -1.0f));
+    REAL* outputs[channels] = {out[0].data(), out[1].data(), out[2].data()};
+    snapshot.copy(outputs, -5, 10);
+    for(long c = 0; c < channels; ++c){
+        for(long i = 0; i < 10; ++i)
+            EXPECT_EQ(out[c][i], i < 5 ? 0.0f : (REAL)((i - 5) * channels + c));
+        EXPECT_EQ(out[c][10], -1.0f);
+    }
+    snapshot.copy(outputs, frames - 3, 10);
+    for(long c = 0; c < channels; ++c){
+        for(long i = 0; i < 10; ++i)
+            EXPECT_EQ(out[c][i], i < 3 ? (REAL)((frames - 3 + i) * channels + c) : 0.0f);
+    }
+    snapshot.copy(outputs, frames + 100, 10);
+    for(long c = 0; c < channels; ++c)
+        EXPECT_EQ(out[c][0], 0.0f);
+}
+
+TEST(TestSignalsmithStretch, PlanarMirrorGenerations)
+{
+    std::vector<float> interleaved(64, 1.0f);
+    PlanarMirror mirror;
+    EXPECT_EQ(mirror.acquire(), nullptr);
+    EXPECT_EQ(mirror.bytes(), 0u);
+
+    unsigned long generation = mirror.invalidate();
+    EXPECT_TRUE(mirror.publish(generation, std::make_shared<const PlanarSnapshot>(interleaved.data(), 32, 2)));
+    auto reader = mirror.acquire();
+    ASSERT_NE(reader, nullptr);
+    EXPECT_EQ(mirror.current(), reader);
+    EXPECT_EQ(mirror.bytes(), reader->bytes());
+
+    // a rebuild started before the last invalidation is dropped
+    unsigned long stale = mirror.generation();
+    unsigned long current = mirror.invalidate();
+    EXPECT_FALSE(mirror.publish(stale, std::make_shared<const PlanarSnapshot>(interleaved.data(), 32, 2)));
+    
+    // readers keep the previous snapshot until the rebuild is published, it is not current anymore
+    EXPECT_EQ(mirror.acquire(), reader);
+    EXPECT_EQ(mirror.current(), nullptr);
+    EXPECT_EQ(reader->channel(1)[31], 1.0f);
+
+    EXPECT_TRUE(mirror.publish(current, std::make_shared<const PlanarSnapshot>(interleaved.data(), 16, 4)));
+    EXPECT_EQ(mirror.acquire()->channels(), 4);
+    EXPECT_EQ(mirror.current(), mirror.acquire());
+    
+    // the snapshot acquired before stays valid for its reader
+    EXPECT_EQ(reader->channel(1)[31], 1.0f);
+    
+    // no more mirror: the snapshot is freed
+    mirror.clear();
+    EXPECT_EQ(mirror.acquire(), nullptr);
+    EXPECT_EQ(mirror.bytes(), 0u);
+}
+
+// ----- render size
+
+TEST(TestSignalsmithStretch, RenderSizeTuner)
+{
+    RenderSizeTuner tuner;
+    EXPECT_EQ(tuner.renderSize(64), OUTPUT_STRETCH_BUFFER_SIZE);
+
+    // renders 100x faster than realtime, woken after 0.1 ms
+    for(int i = 0; i < 16; ++i)
+        tuner.addRender(1024, 1024 / 48000.0 / 100.0, 0.0001, 48000);
+    long fast = tuner.renderSize(64);
+    EXPECT_GE(fast, MIN_RENDER_SIZE);
+    EXPECT_LT(fast, OUTPUT_STRETCH_BUFFER_SIZE);
+    EXPECT_GE(tuner.renderSize(1024), 1024);
+
+    // underruns make it more careful
+    for(int i = 0; i < 4; ++i)
+        tuner.addUnderrun();
+    EXPECT_GT(tuner.renderSize(64), fast);
+
+    // cannot keep up
+    RenderSizeTuner slow;
+    for(int i = 0; i < 16; ++i)
+        slow.addRender(1024, 1024 / 48000.0, 0.0, 48000);
+    EXPECT_EQ(slow.renderSize(64), MAX_RENDER_SIZE);
+}
+
+// ----- param stream
+
+TEST(TestSignalsmithStretch, ParamStreamPeekPop)
+{
+    ParamStream stream;
+    stream.allocate(5);     // rounded to 8
+    EXPECT_EQ(stream.size(), 0u);
+
+    ParamPoint point;
+    for(int i = 0; i < 10; ++i){
+        point.stretch_factor = (float)i;
+        EXPECT_EQ(stream.push(point), i < 8);
+    }
+    ASSERT_EQ(stream.size(), 8u);
+    EXPECT_EQ(stream.peek(0).stretch_factor, 0.0f);
+    EXPECT_EQ(stream.peek(7).stretch_factor, 7.0f);
+
+    stream.pop(3);
+    EXPECT_EQ(stream.size(), 5u);
+    EXPECT_EQ(stream.peek(0).stretch_factor, 3.0f);
+
+    // wraps around
+    point.stretch_factor = 42.0f;
+    EXPECT_TRUE(stream.push(point));
+    EXPECT_EQ(stream.peek(5).stretch_factor, 42.0f);
+
+    stream.pop(100);
+    EXPECT_EQ(stream.size(), 0u);
+}
+
+TEST(TestSignalsmithStretch, ParamStreamConcurrent)
+{
+    const int total = 100000;
+    ParamStream stream;
+    stream.allocate(64);
+
+    std::thread producer([&](){
+        ParamPoint point;
+        for(int i = 0; i < total; ){
+            point.pitch = (float)i;
+            if(stream.push(point))
+                ++i;
+            else
+                std::this_thread::yield();
+        }
+    });
+
+    int expected = 0;
+    while(expected < total){
+        size_t available = stream.size();
+        for(size_t i = 0; i < available; ++i)
+            ASSERT_EQ(stream.peek(i).pitch, (float)(expected + (int)i));
+        stream.pop(available);
+        expected += (int)available;
+    }
+    producer.join();
+    EXPECT_EQ(stream.size(), 0u);
+}
+
+// ----- stats
+
+TEST(TestSignalsmithStretch, DurationHistogramBuckets)
+{
+    EXPECT_EQ(DurationHistogram::bucket(0), 0);
+    EXPECT_EQ(DurationHistogram::bucket(999), 0);
+    EXPECT_EQ(DurationHistogram::bucket(1000), 1);      // [1, 2[ us
+    EXPECT_EQ(DurationHistogram::bucket(3999), 2);      // [2, 4[ us
+    EXPECT_EQ(DurationHistogram::bucket(4000), 3);
+    EXPECT_EQ(DurationHistogram::bucket(1000000000000LL), DurationHistogram::BUCKETS - 1);
+
+    DurationHistogram histogram;
+    for(int i = 0; i < 98; ++i)
+        histogram.add(1500);            // 1.5 us
+    histogram.add(100000);              // 100 us
+    histogram.add(-5);                  // clock going backwards counts as 0
+    DurationHistogram::Summary summary = histogram.take();
+    EXPECT_EQ(summary.count, 100u);
+    EXPECT_EQ(summary.buckets[0], 1u);
+    EXPECT_EQ(summary.buckets[1], 98u);
+    EXPECT_EQ(summary.buckets[DurationHistogram::bucket(100000)], 1u);
+    EXPECT_NEAR(summary.mean_us, (98 * 1.5 + 100) / 100.0, 1e-9);
+    EXPECT_EQ(summary.p50_us, 2.0);
+    EXPECT_EQ(summary.p99_us, 2.0);
+    EXPECT_EQ(summary.max_us, 100.0);
+
+    // each summary covers the time since the previous one
+    summary = histogram.take();
+    EXPECT_EQ(summary.count, 0u);
+    EXPECT_EQ(summary.max_us, 0.0);
+}
+
+TEST(TestSignalsmithStretch, RenderStatsConcurrent)
+{
+    RenderStats stats;
+    std::thread worker([&](){
+        for(int i = 0; i < 10000; ++i){
+            stats.process.add(2000);
+            stats.addRender(480, 1000000);  // 10 ms rendered in 1 ms
+        }
+    });
+    for(size_t i = 0; i < 10000; ++i)
+        stats.addQueueDepth(100 + i % 3);
+    worker.join();
+
+    RenderStats::Summary summary = stats.take(48000);
+    EXPECT_EQ(summary.process.count, 10000u);
+    EXPECT_EQ(summary.queue_min, 100u);
+    EXPECT_NEAR(summary.queue_avg, 101.0, 1e-3);
+    EXPECT_NEAR(summary.realtime_ratio, 10.0, 1e-9);
+
+    summary = stats.take(48000);
+    EXPECT_EQ(summary.queue_min, 0u);
+    EXPECT_EQ(summary.realtime_ratio, 0.0);
+}
+
+// ----- semaphore
+
+TEST(TestSignalsmithStretch, SemaphoreWakeup)
+{
+    Semaphore semaphore;
+    semaphore.signal(2);
+    EXPECT_TRUE(semaphore.tryWait());
+    EXPECT_TRUE(semaphore.tryWait());
+    EXPECT_FALSE(semaphore.tryWait());
+    EXPECT_EQ(semaphore.syscalls(), 0);
+
+    std::atomic_int woken{0};
+    std::vector<std::thread> waiters;
+    for(int i = 0; i < 3; ++i){
+        waiters.emplace_back([&](){
+            semaphore.wait();
+            woken++;
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(woken, 0);
+    semaphore.signal(3);
+    for(auto& waiter : waiters)
+        waiter.join();
+    EXPECT_EQ(woken, 3);
+}
+
+// ----- worker pool
+
+TEST(TestSignalsmithStretch, WorkerPoolRunsSubmittedJobs)
+{
+    WorkerPool pool(2);
+    std::atomic_int count{0};
+    PoolJob job([&](){ count++; });
+    pool.add(&job);
+
+    for(int i = 0; i < 100; ++i){
+        pool.submit(&job);
+        while(count <= i)
+            std::this_thread::yield();
+    }
+    pool.remove(&job);
+    EXPECT_EQ(count, 100);
+
+    // a removed job is not run anymore
+    pool.submit(&job);
+    std::this_thread::sleep_for(std::chrono::milliseconds(30));
+    EXPECT_EQ(count, 100);
+}
+
+TEST(TestSignalsmithStretch, WorkerPoolUrgencyOrder)
+{
+    WorkerPool pool(1);
+    std::atomic_bool release{false};
+    std::mutex order_mutex;
+    std::vector<int> order;
+
+    PoolJob blocker([&](){
+        while(!release)
+            std::this_thread::yield();
+    });
+    pool.add(&blocker);
+    pool.submit(&blocker);
+
+    std::vector<std::unique_ptr<PoolJob>> jobs;
+    for(int i = 0; i < 4; ++i){
+        float urgency = (float)((i * 3) % 4);   // 0, 3, 2, 1
+        jobs.emplace_back(new PoolJob([&, urgency](){
+            std::lock_guard<std::mutex> lock(order_mutex);
+            order.push_back((int)urgency);
+        }, [urgency](){ return urgency; }));
+        pool.add(jobs.back().get());
+        pool.submit(jobs.back().get());
+    }
+    release = true;
+
+    for(int n = 0; n < 1000; ++n){
+        {
+            std::lock_guard<std::mutex> lock(order_mutex);
+            if(order.size() == 4)
+                break;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    for(auto& job : jobs)
+        pool.remove(job.get());
+    pool.remove(&blocker);
+    EXPECT_EQ(order, std::vector<int>({3, 2, 1, 0}));
+}
+
+TEST(TestSignalsmithStretch, WorkerPoolStealsWork)
+{
+    WorkerPool pool(2);
+    std::atomic_bool release{false};
+    std::atomic_bool done{false};
+
+    // with two workers, the jobs are spread on both: keep one worker busy
+    PoolJob blocker([&](){
+        while(!release)
+            std::this_thread::yield();
+    });
+    PoolJob other([&](){ done = true; });
+    pool.add(&blocker);
+    pool.add(&other);
+    pool.submit(&blocker);
+    pool.submit(&other);
+
+    for(int n = 0; n < 1000 && !done; ++n)
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    EXPECT_TRUE(done);
+
+    release = true;
+    pool.remove(&blocker);
+    pool.remove(&other);
+}
+
+TEST(TestSignalsmithStretch, WorkerPoolResubmitWhileRunning)
+{
+    WorkerPool pool(1);
+    std::atomic_int count{0};
+    std::atomic_bool release{false};
+    PoolJob job([&](){
+        count++;
+        while(!release)
+            std::this_thread::yield();
+    });
+    pool.add(&job);
+    pool.submit(&job);
+    while(count == 0)
+        std::this_thread::yield();
+
+    // runs once more after the current run, whatever the number of submissions
+    EXPECT_TRUE(pool.submit(&job));
+    EXPECT_FALSE(pool.submit(&job));
+    release = true;
+    while(count < 2)
+        std::this_thread::yield();
+    pool.remove(&job);
+    EXPECT_EQ(count, 2);
+}
+
+TEST(TestSignalsmithStretch, WorkerPoolRunIfQueued)
+{
+    WorkerPool pool(1);
+    std::atomic_bool started{false};
+    std::atomic_bool release{false};
+    std::atomic_int count{0};
+    PoolJob blocker([&](){
+        started = true;
+        while(!release)
+            std::this_thread::yield();
+    });
+    PoolJob job([&](){ count++; });
+    pool.add(&blocker);
+    pool.add(&job);
+    pool.submit(&blocker);
+    while(!started)
+        std::this_thread::yield();
+
+    // the only worker is busy: the caller runs the job itself, once
+    EXPECT_FALSE(pool.runIfQueued(&job));
+    EXPECT_TRUE(pool.submit(&job));
+    EXPECT_TRUE(pool.runIfQueued(&job));
+    EXPECT_EQ(count, 1);
+    EXPECT_FALSE(pool.runIfQueued(&job));
+
+    release = true;
+    pool.remove(&blocker);
+    pool.remove(&job);
+    EXPECT_EQ(count, 1);
+}
+
+// ----- channel groups
+
+TEST(TestSignalsmithStretch, ChannelGroupsKeepPairs)
+{
+    EXPECT_TRUE(channelGroups(0, 4).empty());
+    for(long channels = 1; channels <= MAX_BUFFER_CHANNEL; ++channels){
+        for(long max_groups = 0; max_groups <= 8; ++max_groups){
+            auto groups = channelGroups(channels, max_groups);
+            ASSERT_FALSE(groups.empty());
+            EXPECT_LE((long)groups.size(), std::max(max_groups, 1L));
+            long next = 0, fewest_pairs = channels, most_pairs = 0;
+            for(const ChannelGroup& group : groups){
+                // contiguous, starting on a pair
+                EXPECT_EQ(group.first, next);
+                EXPECT_EQ(group.first % 2, 0);
+                EXPECT_GT(group.count, 0);
+                next += group.count;
+                fewest_pairs = std::min(fewest_pairs, (group.count + 1) / 2);
+                most_pairs = std::max(most_pairs, (group.count + 1) / 2);
+            }
+            EXPECT_EQ(next, channels);
+            EXPECT_LE(most_pairs - fewest_pairs, 1);
+        }
+    }
+    // one group per pair at most
+    EXPECT_EQ(channelGroups(5, 8).size(), 3u);
+}
+
+TEST(TestSignalsmithStretch, ChannelGroupsForkJoinMatchesSerial)
+{
+    const long num_channels = 7;
+    const long input_samples = 512, output_samples = 768;
+    const float sr = 48000;
+    // extracted like a block: the input latency follows the samples processed
+    signalsmith::stretch::SignalsmithStretch<REAL> probe;
+    configureStretch(probe, 2, 1, sr);
+    const long input_span = input_samples + probe.inputLatency();
+    std::vector<std::vector<REAL>> input(num_channels, std::vector<REAL>(input_span));
+    std::vector<std::vector<REAL>> parallel(num_channels, std::vector<REAL>(output_samples)), serial = parallel;
+    std::vector<const REAL*> inputs;
+    std::vector<REAL*> parallel_outputs, serial_outputs;
+    for(long c = 0; c < num_channels; ++c){
+        inputs.push_back(input[c].data());
+        parallel_outputs.push_back(parallel[c].data());
+        serial_outputs.push_back(serial[c].data());
+    }
+
+    // same groups as signalsmith_build_groups: the first one renders in place, the others on the pool
+    WorkerPool pool(3);
+    Semaphore done;
+    auto build = [&](REAL** outputs){
+        std::vector<StretchGroup> groups;
+        for(const ChannelGroup& channels : channelGroups(num_channels, 4)){
+            StretchGroup group;
+            group.channels = channels;
+            group.stretch.reset(new signalsmith::stretch::SignalsmithStretch<REAL>());
+            configureStretch(*group.stretch, (int)channels.count, 1, sr);
+            group.inputs = inputs.data();
+            group.outputs = outputs;
+            groups.push_back(std::move(group));
+        }
+        return groups;
+    };
+    std::vector<StretchGroup> groups = build(parallel_outputs.data()), reference = build(serial_outputs.data());
+    ASSERT_EQ(groups.size(), 4u);
+    std::atomic_int signals{0};
+    std::vector<PoolJob*> jobs;
+    for(size_t g = 1; g < groups.size(); ++g){
+        StretchGroup* group = &groups[g];
+        group->job.reset(new PoolJob([&, group](){
+            processGroup(*group, input_samples, output_samples);
+            signals++;
+            done.signal();
+        }));
+        pool.add(group->job.get());
+        jobs.push_back(group->job.get());
+    }
+
+    for(int chunk = 0; chunk < 40; ++chunk){
+        // every channel its own signal, moving from chunk to chunk
+        for(long c = 0; c < num_channels; ++c){
+            for(long i = 0; i < input_span; ++i)
+                input[c][i] = 0.5f * std::sin(0.01f * (float)((c + 1) * (chunk * input_samples + i)));
+        }
+        forkGroups(pool, jobs.data(), jobs.size());
+        processGroup(groups[0], input_samples, output_samples);
+        joinGroups(pool, done, jobs.data(), jobs.size());
+        for(StretchGroup& group : reference)
+            processGroup(group, input_samples, output_samples);
+
+        // each group wrote its own channels: the merge is the serial render
+        for(long c = 0; c < num_channels; ++c)
+            ASSERT_EQ(parallel[c], serial[c]) << "chunk " << chunk << " channel " << c;
+        // every signal of the chunk was consumed by the join
+        EXPECT_EQ(signals.load(), (chunk + 1) * (int)jobs.size());
+        EXPECT_FALSE(done.tryWait());
+    }
+    for(PoolJob* job : jobs)
+        pool.remove(job);
+}
+
+// ----- offline render
+
+TEST(TestSignalsmithStretch, OfflineRenderCoversOutput)
+{
+    const long source_frames = 48000;
+    std::vector<std::vector<REAL>> source(2, std::vector<REAL>(source_frames));
+    for(long i = 0; i < source_frames; ++i){
+        source[0][i] = std::sin(0.01f * i);
+        source[1][i] = std::sin(0.02f * i);
+    }
+
+    OfflineRender::Settings settings;
+    settings.num_channels = 2;
+    settings.sample_rate = 48000;
+    settings.stretch_factor = 0.25;     // 4 times longer
+    settings.start = 1000;
+    settings.end = 21000;
+    const long total = OfflineRender::outputFrames(settings);
+    ASSERT_EQ(total, 80000);
+
+    long min_read = source_frames;
+    std::vector<int> writes(total, 0);
+    std::vector<double> progress;
+    std::atomic_bool cancel{false};
+    OfflineRender render;
+    bool complete = render.run(settings,
+        [&](REAL* const* channels, long start, long frames){
+            min_read = std::min(min_read, start);
+            for(int c = 0; c < 2; ++c)
+                for(long i = 0; i < frames; ++i)
+                    channels[c][i] = (start + i >= 0 && start + i < source_frames) ? source[c][start + i] : 0;
+        },
+        [&](const REAL* const* channels, long offset, long frames){
+            ASSERT_GE(offset, 0);
+            ASSERT_LE(offset + frames, total);
+            for(long i = 0; i < frames; ++i){
+                writes[offset + i]++;
+                for(int c = 0; c < 2; ++c)
+                    ASSERT_TRUE(std::isfinite(channels[c][i])) << "frame " << offset + i;
+            }
+        },
+        [&](double p){ progress.push_back(p); },
+        cancel);
+
+    EXPECT_TRUE(complete);
+    EXPECT_EQ(min_read, settings.start);
+    for(long i = 0; i < total; ++i)
+        ASSERT_EQ(writes[i], 1) << "frame " << i;
+    ASSERT_FALSE(progress.empty());
+    EXPECT_TRUE(std::is_sorted(progress.begin(), progress.end()));
+    EXPECT_EQ(progress.back(), 1.0);
+}
+
+TEST(TestSignalsmithStretch, OfflineRenderCancel)
+{
+    OfflineRender::Settings settings;
+    settings.num_channels = 1;
+    settings.stretch_factor = 0.01;
+    settings.end = 48000;
+    EXPECT_EQ(OfflineRender::outputFrames(settings), 4800000);
+
+    std::atomic_bool cancel{false};
+    long written = 0;
+    OfflineRender render;
+    bool complete = render.run(settings,
+        [&](REAL* const* channels, long, long frames){ std::fill(channels[0], channels[0] + frames, 0.0f); },
+        [&](const REAL* const*, long, long frames){ written += frames; cancel = true; },
+        nullptr,
+        cancel);
+    EXPECT_FALSE(complete);
+    EXPECT_LT(written, 4800000);
+
+    settings.stretch_factor = 0;
+    EXPECT_EQ(OfflineRender::outputFrames(settings), 0);
+    EXPECT_FALSE(render.run(settings, nullptr, nullptr, nullptr, cancel));
+}
+
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
     return RUN_ALL_TESTS();
 }
+
+// ----- reset
+
+// perform64 changing its vector size again and again: a reset request each time, never waiting for the worker
+TEST(TestSignalsmithStretch, ResetRequestVectorSizeStress)
+{
+    const int render = 512;
+    PlanarRingBuffer<REAL> ring;
+    ring.allocate(2, 4 * render, 64);
+    ResetRequest reset;
+    signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+    stretch.presetCheaper(2, 48000);
+
+    std::vector<std::vector<REAL>> input(2, std::vector<REAL>(render, 0.5f)), output(2, std::vector<REAL>(render));
+    const REAL* inputs[2] = {input[0].data(), input[1].data()};
+    REAL* outputs[2] = {output[0].data(), output[1].data()};
+    const REAL* rendered[2] = {output[0].data(), output[1].data()};
+
+    // worker: services the requests before each chunk, the frames carry the generation they were rendered for
+    std::atomic_int resets{0};
+    std::atomic_bool pending{false};
+    WorkerPool pool(2);
+    PoolJob job([&](){
+        while(ring.writeAvailable() >= (size_t)render){
+            unsigned long generation = 0;
+            if(reset.service(generation)){
+                stretch.reset();
+                resets++;
+            }
+            stretch.process(inputs, render, outputs, render);
+            for(int c = 0; c < 2; ++c)
+                std::fill(output[c].begin(), output[c].end(), (REAL)generation);
+            ChunkInfo info;
+            info.reset = generation;
+            ring.push(rendered, 2, render, info);
+        }
+        pending = false;
+    });
+    pool.add(&job);
+
+    const long sizes[] = {64, 32, 128, 256, 48, 512};
+    std::vector<double> left(512), right(512);
+    double* out[2] = {left.data(), right.data()};
+    long blocksize = 0;
+    int requests = 0;
+    size_t fresh = 0;
+    bool ok = true;
+    int stalls = 0;     // stale chunks seen without their frames: perform64 would have spun on them
+    // drop loop of perform64
+    auto dropStale = [&](){
+        PlanarRingBuffer<REAL>::Chunk chunk;
+        size_t offset = 0;
+        while(ring.current(chunk, offset) && reset.stale(chunk.info.reset)){
+            if(ring.drop(chunk.frames - offset) == 0){
+                stalls++;
+                break;
+            }
+        }
+    };
+    // plays up to `size` frames, chunk by chunk: a chunk found fresh has its frames, and they carry its generation
+    // (a chunk pushed after a drop may have been rendered before the request: it is only checked once in front)
+    auto play = [&](long size){
+        size_t played = 0;
+        PlanarRingBuffer<REAL>::Chunk chunk;
+        size_t offset = 0;
+        while(played < (size_t)size){
+            dropStale();
+            if(!ring.current(chunk, offset) || reset.stale(chunk.info.reset))
+                break;
+            size_t n = ring.read(out, 2, std::min((size_t)size - played, chunk.frames - offset));
+            ok &= n > 0;
+            for(size_t j = 0; j < n; ++j)
+                ok &= left[j] == (double)chunk.info.reset && right[j] == (double)chunk.info.reset;
+            if(n == 0)
+                break;
+            played += n;
+        }
+        return played;
+    };
+    // perform routine: drops the stale chunks, plays the rest and asks for more
+    auto perform = [&](long size){
+        fresh += play(size);
+        if(ring.readAvailable() <= (size_t)(render / 2 + size) && !pending.exchange(true))
+            pool.submit(&job);
+    };
+    for(int i = 0; i < 8000; ++i){
+        long size = sizes[(i / 3) % 6];
+        if(size != blocksize){
+            blocksize = size;
+            reset.request();
+            requests++;
+        }
+        perform(size);
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+    // then the size settles: a loaded machine may not have rendered a chunk between the requests
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while(fresh == 0 && std::chrono::steady_clock::now() < deadline){
+        perform(blocksize);
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    pool.remove(&job);
+    EXPECT_GT(fresh, 0u);
+    EXPECT_GT(resets, 0);
+    EXPECT_LE(resets, requests);
+
+    // then across the publication window: tiny chunks pushed as fast as possible while the requests keep
+    // making them stale, the consumer dropping and reading without sleeping
+    ring.flush();
+    std::atomic_bool done{false};
+    std::thread producer([&](){
+        std::vector<REAL> left(8), right(8);
+        const REAL* chunk[2] = {left.data(), right.data()};
+        size_t frames = 1;
+        while(!done){
+            unsigned long generation = 0;
+            reset.service(generation);
+            std::fill(left.begin(), left.end(), (REAL)generation);
+            std::fill(right.begin(), right.end(), (REAL)generation);
+            ChunkInfo info;
+            info.reset = generation;
+            if(ring.push(chunk, 2, frames, info))
+                frames = 1 + frames % 8;
+            else
+                std::this_thread::yield();
+        }
+    });
+    size_t dropped = 0;
+    for(int i = 0; i < 50000; ++i){
+        if(i % 5 == 0)
+            reset.request();
+        const size_t before = ring.readAvailable();
+        dropStale();
+        dropped += before - std::min(before, ring.readAvailable());
+        if(play(1 + i % 16) == 0)
+            std::this_thread::yield();
+    }
+    done = true;
+    producer.join();
+    EXPECT_GT(dropped, 0u);
+
+    // no frame rendered before the last request is ever played, no stale chunk ever blocks the drop
+    EXPECT_TRUE(ok);
+    EXPECT_EQ(stalls, 0);
+}
+
+// ----- mode switch
+
+TEST(TestSignalsmithStretch, ModeSwitchCrossfadeIsContinuous)
+{
+    ModeSwitch modeSwitch;
+    modeSwitch.rebuilt(0);
+    modeSwitch.request(1);
+    long mode = -1;
+    ASSERT_TRUE(modeSwitch.begin(mode));
+    EXPECT_EQ(mode, 1);
+    EXPECT_FALSE(modeSwitch.start());   // nothing built yet
+    modeSwitch.ready();
+    ASSERT_TRUE(modeSwitch.start());
+    EXPECT_TRUE(modeSwitch.fading());
+
+    // the current stretcher renders 0, the next one 1: the mix is the gain of the fade
+    // chunks that do not divide MODE_CROSSFADE_SIZE, the last one running past its end
+    const long chunks[] = {1, 100, 37, 513, 1000, 700};
+    std::vector<REAL> fade;
+    bool over = false;
+    for(long frames : chunks){
+        ASSERT_FALSE(over);
+        std::vector<REAL> current(2 * frames, 0.0f), next(2 * frames, 1.0f);
+        REAL* outputs[2] = {current.data(), current.data() + frames};
+        const REAL* inputs[2] = {next.data(), next.data() + frames};
+        over = modeSwitch.mix(outputs, inputs, 2, frames);
+        for(long i = 0; i < frames; ++i)
+            ASSERT_EQ(outputs[0][i], outputs[1][i]) << i;
+        fade.insert(fade.end(), outputs[0], outputs[0] + frames);
+    }
+    ASSERT_TRUE(over);
+    ASSERT_GE(fade.size(), (size_t)MODE_CROSSFADE_SIZE);
+
+    // rises by one step per frame to the end of the fade, then plays the next stretcher only: no jump at the swap
+    const REAL step = 1.0f / (REAL)MODE_CROSSFADE_SIZE;
+    REAL previous = 0.0f;
+    for(size_t i = 0; i < fade.size(); ++i){
+        ASSERT_NEAR(fade[i] - previous, i < (size_t)MODE_CROSSFADE_SIZE ? step : 0.0f, 1e-6f) << i;
+        previous = fade[i];
+    }
+    EXPECT_EQ(fade[MODE_CROSSFADE_SIZE - 1], 1.0f);
+
+    modeSwitch.finish();
+    EXPECT_FALSE(modeSwitch.fading());
+    EXPECT_TRUE(modeSwitch.retiring());
+}
+
+TEST(TestSignalsmithStretch, ModeSwitchPicksUpModeSetDuringSwitch)
+{
+    ModeSwitch modeSwitch;
+    modeSwitch.rebuilt(0);
+    long mode = -1;
+    EXPECT_FALSE(modeSwitch.begin(mode));   // same mode: nothing to switch
+
+    modeSwitch.request(1);
+    ASSERT_TRUE(modeSwitch.begin(mode));
+    EXPECT_EQ(mode, 1);
+
+    // set while building, then while fading: the running switch goes on with mode 1
+    modeSwitch.request(2);
+    EXPECT_FALSE(modeSwitch.begin(mode));
+    modeSwitch.ready();
+    ASSERT_TRUE(modeSwitch.start());
+    modeSwitch.request(3);
+    EXPECT_FALSE(modeSwitch.begin(mode));
+    EXPECT_EQ(modeSwitch.mode(), 3);
+
+    std::vector<REAL> current(MODE_CROSSFADE_SIZE), next(MODE_CROSSFADE_SIZE);
+    REAL* outputs[1] = {current.data()};
+    const REAL* inputs[1] = {next.data()};
+    ASSERT_TRUE(modeSwitch.mix(outputs, inputs, 1, MODE_CROSSFADE_SIZE));
+    modeSwitch.finish();
+
+    // the next run of the switch job retires the old stretcher, then switches to the last mode set
+    EXPECT_FALSE(modeSwitch.begin(mode));
+    ASSERT_TRUE(modeSwitch.retiring());
+    modeSwitch.retired();
+    ASSERT_TRUE(modeSwitch.begin(mode));
+    EXPECT_EQ(mode, 3);
+    modeSwitch.ready();
+    ASSERT_TRUE(modeSwitch.start());
+    ASSERT_TRUE(modeSwitch.mix(outputs, inputs, 1, MODE_CROSSFADE_SIZE));
+    modeSwitch.finish();
+    modeSwitch.retired();
+    EXPECT_FALSE(modeSwitch.begin(mode));   // up to date
+}
+
+// ----- file source
+
+namespace {
+
+void putLE(std::string& bytes, uint64_t value, int n){
+    for(int i = 0; i < n; ++i)
+        bytes.push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+void putBE(std::string& bytes, uint64_t value, int n){
+    for(int i = n - 1; i >= 0; --i)
+        bytes.push_back((char)((value >> (8 * i)) & 0xFF));
+}
+
+std::string writeTempFile(const std::string& name, const std::string& bytes){
+    const std::string path = ::testing::TempDir() + name;
+    std::ofstream file(path, std::ios::binary);
+    file.write(bytes.data(), (std::streamsize)bytes.size());
+    return path;
+}
+
+// value of sample i of channel c in the test files
+double testSample(long i, long c){
+    return 0.5 * std::sin(0.05 * (double)i + (double)c);
+}
+
+// interleaved 16 bit or 32 bit float WAV, with a chunk to skip before the data
+std::string testWav(long frames, long channels, bool isFloat){
+    const int bits = isFloat ? 32 : 16;
+    std::string data;
+    for(long i = 0; i < frames; ++i){
+        for(long c = 0; c < channels; ++c){
+            if(isFloat){
+                float v = (float)testSample(i, c);
+                uint32_t u;
+                std::memcpy(&u, &v, 4);
+                putLE(data, u, 4);
+            }
+            else{
+                putLE(data, (uint16_t)(int16_t)std::lround(testSample(i, c) * 32767.0), 2);
+            }
+        }
+    }
+    std::string bytes = "RIFF";
+    putLE(bytes, 4 + 26 + 24 + 8 + data.size(), 4);
+    bytes += "WAVE";
+    bytes += "LIST";
+    putLE(bytes, 18, 4);
+    bytes += std::string(17, 'x') + std::string(1, '\0');
+    bytes += "fmt ";
+    putLE(bytes, 16, 4);
+    putLE(bytes, isFloat ? 3 : 1, 2);
+    putLE(bytes, (uint64_t)channels, 2);
+    putLE(bytes, 44100, 4);
+    putLE(bytes, 44100 * channels * bits / 8, 4);
+    putLE(bytes, (uint64_t)(channels * bits / 8), 2);
+    putLE(bytes, (uint64_t)bits, 2);
+    bytes += "data";
+    putLE(bytes, data.size(), 4);
+    return bytes + data;
+}
+
+// 24 bit big endian AIFF at 48 kHz
+std::string testAiff(long frames, long channels){
+    std::string data;
+    for(long i = 0; i < frames; ++i)
+        for(long c = 0; c < channels; ++c)
+            putBE(data, (uint32_t)(int32_t)std::lround(testSample(i, c) * 8388607.0) & 0xFFFFFF, 3);
+    std::string comm;
+    putBE(comm, (uint64_t)channels, 2);
+    putBE(comm, (uint64_t)frames, 4);
+    putBE(comm, 24, 2);
+    // 48000 as an 80 bit extended: 2^15 * 1.46484375
+    putBE(comm, 0x400E, 2);
+    putBE(comm, 0xBB80000000000000ULL, 8);
+    std::string bytes = "FORM";
+    putBE(bytes, 4 + 8 + comm.size() + 8 + 8 + data.size(), 4);
+    bytes += "AIFF";
+    bytes += "COMM";
+    putBE(bytes, comm.size(), 4);
+    bytes += comm;
+    bytes += "SSND";
+    putBE(bytes, 8 + data.size(), 4);
+    putBE(bytes, 0, 4);
+    putBE(bytes, 0, 4);
+    return bytes + data;
+}
+
+}
+
+TEST(TestSignalsmithStretch, MappedFileWav)
+{
+    for(bool isFloat : {false, true}){
+        const long frames = 1000, channels = 3;
+        const std::string path = writeTempFile("signalsmith_test.wav", testWav(frames, channels, isFloat));
+        std::string error;
+        std::unique_ptr<MappedAudioFile> file = MappedAudioFile::open(path, error);
+        ASSERT_TRUE(file) << error;
+        EXPECT_EQ(file->frames(), frames);
+        EXPECT_EQ(file->channels(), channels);
+        EXPECT_EQ(file->sampleRate(), 44100.0);
+        EXPECT_EQ(file->encoding(), isFloat ? MappedAudioFile::Float32 : MappedAudioFile::Int16);
+
+        // across the start of the file: zeros before
+        std::vector<std::vector<REAL>> out(channels, std::vector<REAL>(64, -1));
+        std::vector<REAL*> outputs {out[0].data(), out[1].data(), out[2].data()};
+        file->read(outputs.data(), -10, 64);
+        const double tolerance = isFloat ? 1e-7 : 1.0 / 32767;
+        for(long c = 0; c < channels; ++c){
+            for(long i = 0; i < 10; ++i)
+                ASSERT_EQ(out[c][i], 0.0f);
+            for(long i = 10; i < 64; ++i)
+                ASSERT_NEAR(out[c][i], testSample(i - 10, c), tolerance);
+        }
+        // across the end: zeros after
+        file->read(outputs.data(), frames - 4, 64);
+        for(long c = 0; c < channels; ++c){
+            for(long i = 0; i < 4; ++i)
+                ASSERT_NEAR(out[c][i], testSample(frames - 4 + i, c), tolerance);
+            for(long i = 4; i < 64; ++i)
+                ASSERT_EQ(out[c][i], 0.0f);
+        }
+        EXPECT_TRUE(file->prefetch(-100, 2 * frames));
+        file.reset();
+        std::remove(path.c_str());
+    }
+}
+
+TEST(TestSignalsmithStretch, MappedFileAiff)
+{
+    const long frames = 500, channels = 2;
+    const std::string path = writeTempFile("signalsmith_test.aiff", testAiff(frames, channels));
+    std::string error;
+    std::unique_ptr<MappedAudioFile> file = MappedAudioFile::open(path, error);
+    ASSERT_TRUE(file) << error;
+    EXPECT_EQ(file->frames(), frames);
+    EXPECT_EQ(file->channels(), channels);
+    EXPECT_EQ(file->sampleRate(), 48000.0);
+    EXPECT_EQ(file->encoding(), MappedAudioFile::Int24);
+
+    std::vector<std::vector<REAL>> out(channels, std::vector<REAL>(frames));
+    std::vector<REAL*> outputs {out[0].data(), out[1].data()};
+    file->read(outputs.data(), 0, frames);
+    for(long c = 0; c < channels; ++c)
+        for(long i = 0; i < frames; ++i)
+            ASSERT_NEAR(out[c][i], testSample(i, c), 1.0 / 8388607);
+    file.reset();
+    std::remove(path.c_str());
+}
+
+TEST(TestSignalsmithStretch, MappedFileErrors)
+{
+    std::string error;
+    EXPECT_FALSE(MappedAudioFile::open(::testing::TempDir() + "signalsmith_missing.wav", error));
+    EXPECT_FALSE(error.empty());
+
+    const std::string path = writeTempFile("signalsmith_test.txt", "not an audio file at all");
+    error.clear();
+    EXPECT_FALSE(MappedAudioFile::open(path, error));
+    EXPECT_EQ(error, "not a WAV or AIFF file");
+
+    // truncated data chunk: only the whole frames present
+    std::string wav = testWav(100, 2, false);
+    writeTempFile("signalsmith_test.txt", wav.substr(0, wav.size() - 41));
+    std::unique_ptr<MappedAudioFile> file = MappedAudioFile::open(path, error);
+    ASSERT_TRUE(file) << error;
+    EXPECT_EQ(file->frames(), 89);
+    file.reset();
+    std::remove(path.c_str());
+}
+
+TEST(TestSignalsmithStretch, FilePrefetcherFollowsReadHead)
+{
+    const long frames = 200000;
+    const std::string path = writeTempFile("signalsmith_test.wav", testWav(frames, 1, false));
+    std::string error;
+    std::unique_ptr<MappedAudioFile> file = MappedAudioFile::open(path, error);
+    ASSERT_TRUE(file) << error;
+    {
+        FilePrefetcher prefetcher(*file, 1.0);
+        // 1 second ahead at 2 x 44100 frames per second, clipped to the file
+        for(double position : {0.0, 150000.0}){
+            prefetcher.update(position, 88200);
+            const long expected = std::min(88200L, frames - (long)position);
+            auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while(prefetcher.ahead() < expected && std::chrono::steady_clock::now() < deadline)
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            EXPECT_EQ(prefetcher.ahead(), expected);
+        }
+    }   // joins the thread
+    file.reset();
+    std::remove(path.c_str());
+}
+
+// ----- live input
+
+TEST(TestSignalsmithStretch, CaptureRingOverwritesOldest)
+{
+    CaptureRing<float> ring;
+    ring.allocate(3, 100);
+    ASSERT_EQ(ring.capacity(), 128u);
+
+    // 2 input channels for 3 ring channels, frame i holds i and -i
+    std::vector<double> left(50), right(50);
+    const double* input[2] = {left.data(), right.data()};
+    for(size_t start = 0; start < 300; start += 50){
+        for(size_t i = 0; i < 50; ++i){
+            left[i] = (double)(start + i);
+            right[i] = -(double)(start + i);
+        }
+        ring.write(input, 2, 50);
+    }
+    EXPECT_EQ(ring.written(), 300u);
+
+    // [150, 310[: overwritten before 300 - 128, not written yet from 300
+    std::vector<float> a(160, -1), b(160, -1), c(160, -1);
+    float* output[3] = {a.data(), b.data(), c.data()};
+    EXPECT_TRUE(ring.read(output, 3, 150, 160));
+    for(long i = 0; i < 160; ++i){
+        long frame = 150 + i;
+        bool captured = frame >= 300 - 128 && frame < 300;
+        ASSERT_EQ(a[i], captured ? (float)frame : 0.0f) << frame;
+        ASSERT_EQ(b[i], captured ? -(float)frame : 0.0f) << frame;
+        ASSERT_EQ(c[i], 0.0f);
+    }
+
+    // before the first frame
+    EXPECT_TRUE(ring.read(output, 3, -20, 10));
+    EXPECT_EQ(a[0], 0.0f);
+
+    // a write larger than the ring keeps its last frames
+    std::vector<double> big(200);
+    for(size_t i = 0; i < big.size(); ++i)
+        big[i] = (double)(1000 + i);
+    const double* bigInput[1] = {big.data()};
+    ring.write(bigInput, 1, big.size());
+    EXPECT_EQ(ring.written(), 500u);
+    EXPECT_TRUE(ring.read(output, 1, 500 - 128, 128));
+    for(long i = 0; i < 128; ++i)
+        ASSERT_EQ(a[i], (float)(1000 + 200 - 128 + i));
+}
+
+TEST(TestSignalsmithStretch, CaptureRingConcurrent)
+{
+    const size_t total = 1 << 20;
+    const size_t period = 1 << 16;
+    const long guard = 256;
+    CaptureRing<float> ring;
+    ring.allocate(1, 1024);
+    std::atomic_bool done{false};
+    std::atomic_long reads{0};
+
+    // the audio thread: vectors of 64 frames, frame i holds i % period
+    std::thread producer([&](){
+        std::vector<double> vector(64);
+        const double* input[1] = {vector.data()};
+        for(size_t start = 0; start < total || reads < 1000; start += vector.size()){
+            for(size_t i = 0; i < vector.size(); ++i)
+                vector[i] = (double)((start + i) % period);
+            ring.write(input, 1, vector.size());
+        }
+        done = true;
+    });
+
+    // the worker: frames still in the ring after the read are the right ones
+    // (a read preempted for longer than the ring is reported, not torn)
+    std::vector<float> block(512);
+    float* output[1] = {block.data()};
+    bool ok = true;
+    while(!done && ok){
+        long written = (long)ring.written();
+        long first = written - (long)ring.capacity() + guard;
+        if(first < 0)
+            continue;
+        size_t frames = (size_t)std::min((long)block.size(), written - first);
+        if(!ring.read(output, 1, first, frames))
+            continue;
+        for(size_t i = 0; i < frames; ++i)
+            ok &= block[i] == (float)((size_t)(first + (long)i) % period);
+        ++reads;
+    }
+    producer.join();
+    EXPECT_TRUE(ok);
+    EXPECT_GT(reads, 0);
+}
+
+TEST(TestSignalsmithStretch, LiveBlockPolicies)
+{
+    const long readable = 10000, latency = 100;
+
+    // at the newest input: shortened, whatever the policy
+    for(LivePolicy policy : {LiveFollow, LiveHold, LiveDrift}){
+        LiveBlock block = placeLiveBlock(policy, 1000, 500, 500, latency, 1200, readable, 0);
+        EXPECT_EQ(block.position, 1000);
+        EXPECT_EQ(block.blocksize, 200);
+        EXPECT_FALSE(block.jumped);
+    }
+
+    // fallen out of the ring
+    LiveBlock follow = placeLiveBlock(LiveFollow, 50000, 256, 512, latency, 100000, readable, 0);
+    EXPECT_EQ(follow.position, 100000 - 256);
+    EXPECT_EQ(follow.blocksize, 256);
+    EXPECT_TRUE(follow.jumped);
+    LiveBlock hold = placeLiveBlock(LiveHold, 50000, 256, 512, latency, 100000, readable, 0);
+    EXPECT_EQ(hold.position, 100000 - readable + latency);
+    EXPECT_EQ(hold.blocksize, 256);
+    EXPECT_FALSE(hold.jumped);
+
+    // slowed down 10 times for a while: the delay of follow and hold reaches the ring, drift settles below it
+    const long chunk = 512;
+    const double drift = 4000;
+    for(LivePolicy policy : {LiveFollow, LiveHold, LiveDrift}){
+        double position = 0;
+        long written = 0, jumps = 0;
+        double delay = 0, max_delay = 0;
+        for(int i = 0; i < 2000; ++i){
+            written += chunk;
+            LiveBlock block = placeLiveBlock(policy, position, chunk / 10, chunk, latency, written, readable, drift);
+            jumps += block.jumped;
+            position = block.position + block.blocksize;
+            delay = (double)written - position;
+            max_delay = std::max(max_delay, delay);
+        }
+        EXPECT_LE(max_delay, (double)readable);
+        if(policy == LiveFollow){
+            EXPECT_GT(jumps, 0);
+        }
+        else if(policy == LiveHold){
+            EXPECT_EQ(jumps, 0);
+            EXPECT_NEAR(delay, readable - latency, chunk);
+        }
+        else{
+            // catches up (1 - 1/10) x chunk per chunk at delay (1 - 1/10) x drift
+            EXPECT_EQ(jumps, 0);
+            EXPECT_NEAR(delay, 0.9 * drift, chunk);
+        }
+    }
+}
+
+// ----- analysis cache
+
+TEST(TestSignalsmithStretch, FftMatchesDft)
+{
+    // from the scalar stages only to all the vector widths
+    for(int n : {2, 4, 8, 16, 64, 4096}){
+        std::vector<std::complex<float>> data(n), expected(n);
+        for(int i = 0; i < n; ++i)
+            data[i] = std::complex<float>(std::sin(0.3f * i) + 0.25f * (float)(i % 5), std::cos(0.7f * i));
+        const double pi = 3.14159265358979323846;
+        for(int k = 0; k < n; ++k){
+            std::complex<double> sum(0.0, 0.0);
+            for(int i = 0; i < n; ++i)
+                sum += std::complex<double>(data[i]) * std::polar(1.0, -2.0 * pi * k * i / n);
+            expected[k] = std::complex<float>(sum);
+        }
+    
+        Fft fft;
+        fft.resize(n);
+        std::vector<std::complex<float>> transformed = data;
+        fft.forward(transformed.data());
+        for(int k = 0; k < n; ++k){
+            EXPECT_NEAR(transformed[k].real(), expected[k].real(), 1e-3f) << k;
+            EXPECT_NEAR(transformed[k].imag(), expected[k].imag(), 1e-3f) << k;
+        }
+        // unnormalised inverse
+        fft.inverse(transformed.data());
+        for(int i = 0; i < n; ++i){
+            EXPECT_NEAR(transformed[i].real() / n, data[i].real(), 1e-4f) << i;
+            EXPECT_NEAR(transformed[i].imag() / n, data[i].imag(), 1e-4f) << i;
+        }
+    
+        // real part only, positive frequencies
+        std::vector<float> real(n), restored(n);
+        for(int i = 0; i < n; ++i)
+            real[i] = data[i].real();
+        fft.resize(n);
+        std::vector<std::complex<float>> full(real.begin(), real.end());
+        fft.forward(full.data());
+        RealFft realFft;
+        realFft.resize(n);
+        std::vector<std::complex<float>> spectrum(n / 2 + 1);
+        realFft.forward(real.data(), spectrum.data());
+        for(int k = 0; k <= n / 2; ++k){
+            EXPECT_NEAR(spectrum[k].real(), full[k].real(), 1e-3f) << k;
+            EXPECT_NEAR(spectrum[k].imag(), full[k].imag(), 1e-3f) << k;
+        }
+        realFft.inverse(spectrum.data(), restored.data());
+        for(int i = 0; i < n; ++i)
+            EXPECT_NEAR(restored[i] / n, real[i], 1e-4f) << i;
+    }
+}
+
+TEST(TestSignalsmithStretch, FftInverseMatchesDft)
+{
+    // the inverses on their own, not only as a round trip: any spectrum, unnormalised
+    const double pi = 3.14159265358979323846;
+    for(int n : {2, 4, 8, 16, 64, 4096}){
+        const float tolerance = 1e-6f * (float)n;
+        std::vector<std::complex<float>> spectrum(n);
+        for(int k = 0; k < n; ++k)
+            spectrum[k] = std::complex<float>(std::sin(1.3f * k) + 0.5f * (float)(k % 3), std::cos(0.9f * k) - 0.25f);
+
+        std::vector<std::complex<float>> transformed = spectrum;
+        Fft fft(n);
+        fft.inverse(transformed.data());
+        for(int i = 0; i < n; ++i){
+            std::complex<double> sum(0.0, 0.0);
+            for(int k = 0; k < n; ++k)
+                sum += std::complex<double>(spectrum[k]) * std::polar(1.0, 2.0 * pi * k * i / n);
+            ASSERT_NEAR(transformed[i].real(), sum.real(), tolerance) << n << " " << i;
+            ASSERT_NEAR(transformed[i].imag(), sum.imag(), tolerance) << n << " " << i;
+        }
+
+        // real signal: the positive frequencies, DC and Nyquist real, the negative ones their conjugates
+        if(n < 4)
+            continue;
+        std::vector<std::complex<float>> half(spectrum.begin(), spectrum.begin() + n / 2 + 1);
+        half[0] = half[0].real();
+        half[n / 2] = half[n / 2].real();
+        std::vector<float> output(n);
+        RealFft realFft;
+        realFft.resize(n);
+        realFft.inverse(half.data(), output.data());
+        for(int i = 0; i < n; ++i){
+            double sum = (double)half[0].real() + (i % 2 ? -1.0 : 1.0) * (double)half[n / 2].real();
+            for(int k = 1; k < n / 2; ++k)
+                sum += 2.0 * (std::complex<double>(half[k]) * std::polar(1.0, 2.0 * pi * k * i / n)).real();
+            ASSERT_NEAR(output[i], sum, tolerance) << n << " " << i;
+        }
+    }
+}
+
+namespace {
+
+// `seconds` of a sine of `frequency` in every channel
+std::shared_ptr<const PlanarSnapshot> sineSnapshot(long channels, double seconds, double frequency, double sampleRate){
+    long frames = (long)(seconds * sampleRate);
+    std::vector<float> interleaved(frames * channels);
+    for(long i = 0; i < frames; ++i){
+        for(long c = 0; c < channels; ++c)
+            interleaved[i * channels + c] = (float)(0.5 * std::sin(2.0 * 3.14159265358979323846 * frequency * i / sampleRate + c));
+    }
+    return std::make_shared<const PlanarSnapshot>(interleaved.data(), frames, channels);
+}
+
+AnalysisKey sineKey(const PlanarSnapshot& source, double sampleRate){
+    AnalysisKey key;
+    key.frames = source.frames();
+    key.channels = source.channels();
+    key.sample_rate = sampleRate;
+    key.layout = spectralLayout(0, sampleRate);
+    key.checksum = AnalysisKey::contentsChecksum(source);
+    return key;
+}
+
+}
+
+TEST(TestSignalsmithStretch, HyperStretchKeepsSine)
+{
+    const double sr = 48000, frequency = 1000;
+    std::shared_ptr<const PlanarSnapshot> source = sineSnapshot(1, 1.0, frequency, sr);
+    std::string reason;
+    std::unique_ptr<SpectralAnalysis> analysis = SpectralAnalysis::create(sineKey(*source, sr), std::string(), reason);
+    ASSERT_TRUE(analysis) << reason;
+    SpectralAnalyser analyser;
+    analyser.setLayout(analysis->key().layout);
+    std::vector<std::vector<REAL>> scratch(1, std::vector<REAL>(analysis->key().layout.fft_size));
+    analysis->analyse(analyser, *source, 0, analysis->frames(), scratch);
+    analysis->finish();
+    
+    // 100x slower, from the middle: same frequency and level
+    SpectralSynth synth;
+    synth.configure(analysis->key().layout, 1);
+    std::vector<REAL> output(4 * 8192);
+    REAL* channels[1] = {output.data()};
+    double position = 0.4 * sr;
+    const SpectralAnalysis* frames = analysis.get();
+    synth.render([frames](long index, int channel){ return frames->frame(index, channel); }, position, 0.01, 1.0f, channels, (long)output.size());
+    EXPECT_NEAR(position, 0.4 * sr + 0.01 * output.size(), analysis->key().layout.hop);
+    
+    // after the first window: RMS and zero crossings
+    const long first = analysis->key().layout.fft_size;
+    double energy = 0;
+    long crossings = 0;
+    for(size_t i = first; i < output.size(); ++i){
+        energy += output[i] * output[i];
+        crossings += (output[i - 1] < 0) != (output[i] < 0);
+    }
+    double seconds = (double)(output.size() - first) / sr;
+    EXPECT_NEAR(std::sqrt(energy / (double)(output.size() - first)), 0.5 / std::sqrt(2.0), 0.03);
+    EXPECT_NEAR((double)crossings / (2.0 * seconds), frequency, 10.0);
+}
+
+TEST(TestSignalsmithStretch, AnalysisSidecarReused)
+{
+    const double sr = 44100;
+    std::shared_ptr<const PlanarSnapshot> source = sineSnapshot(2, 0.5, 440, sr);
+    AnalysisKey key = sineKey(*source, sr);
+    std::string path = testing::TempDir() + key.sidecarName("my buffer");
+    std::remove(path.c_str());
+    EXPECT_EQ(path.find(' '), std::string::npos);
+    
+    std::string reason;
+    {
+        std::unique_ptr<SpectralAnalysis> analysis = SpectralAnalysis::create(key, path, reason);
+        ASSERT_TRUE(analysis) << reason;
+        EXPECT_TRUE(analysis->persistent());
+        EXPECT_FALSE(analysis->complete());
+        SpectralAnalyser analyser;
+        analyser.setLayout(key.layout);
+        std::vector<std::vector<REAL>> scratch(2, std::vector<REAL>(key.layout.fft_size));
+        analysis->analyse(analyser, *source, 0, analysis->frames(), scratch);
+        analysis->finish();
+    }
+    // same key: complete, same bins as an analysis in memory
+    std::unique_ptr<SpectralAnalysis> reopened = SpectralAnalysis::create(key, path, reason);
+    ASSERT_TRUE(reopened) << reason;
+    EXPECT_TRUE(reopened->complete());
+    std::unique_ptr<SpectralAnalysis> memory = SpectralAnalysis::create(key, std::string(), reason);
+    SpectralAnalyser analyser;
+    analyser.setLayout(key.layout);
+    std::vector<std::vector<REAL>> scratch(2, std::vector<REAL>(key.layout.fft_size));
+    memory->analyse(analyser, *source, 0, memory->frames(), scratch);
+    ASSERT_EQ(reopened->frames(), memory->frames());
+    for(long index = 0; index < memory->frames(); ++index){
+        for(long c = 0; c < 2; ++c)
+            ASSERT_EQ(std::memcmp(reopened->frame(index, c), memory->frame(index, c), sizeof(SpectralBin) * key.layout.bins()), 0) << index;
+    }
+    EXPECT_EQ(reopened->frame(reopened->frames(), 0), nullptr);
+    EXPECT_EQ(reopened->frame(0, 2), nullptr);
+    reopened.reset();
+    
+    // the source changed: recomputed
+    AnalysisKey changed = key;
+    changed.checksum ^= 1;
+    std::unique_ptr<SpectralAnalysis> stale = SpectralAnalysis::create(changed, path, reason);
+    ASSERT_TRUE(stale) << reason;
+    EXPECT_FALSE(stale->complete());
+    stale.reset();
+    std::remove(path.c_str());
+}
+
+TEST(TestSignalsmithStretch, AnalysisBuildParallel)
+{
+    const double sr = 48000;
+    std::shared_ptr<const PlanarSnapshot> source = sineSnapshot(2, 2.0, 220, sr);
+    AnalysisKey key = sineKey(*source, sr);
+    std::string reason;
+    std::shared_ptr<SpectralAnalysis> parallel(SpectralAnalysis::create(key, std::string(), reason));
+    std::unique_ptr<SpectralAnalysis> single = SpectralAnalysis::create(key, std::string(), reason);
+    ASSERT_TRUE(parallel && single);
+    
+    AnalysisBuild build(source, parallel, 7);
+    EXPECT_EQ(build.generation(), 7u);
+    std::atomic<int> completed{0};
+    std::vector<std::thread> threads;
+    for(int t = 0; t < 4; ++t){
+        threads.emplace_back([&](){
+            AnalysisBuild::Slice slice;
+            while((slice = build.runSlice()) != AnalysisBuild::None){
+                if(slice == AnalysisBuild::Completed)
+                    completed++;
+            }
+        });
+    }
+    for(auto& thread : threads)
+        thread.join();
+    EXPECT_EQ(completed.load(), 1);
+    EXPECT_TRUE(parallel->complete());
+    EXPECT_DOUBLE_EQ(build.progress(), 1.0);
+    
+    SpectralAnalyser analyser;
+    analyser.setLayout(key.layout);
+    std::vector<std::vector<REAL>> scratch(2, std::vector<REAL>(key.layout.fft_size));
+    single->analyse(analyser, *source, 0, single->frames(), scratch);
+    for(long index = 0; index < single->frames(); ++index){
+        for(long c = 0; c < 2; ++c)
+            ASSERT_EQ(std::memcmp(parallel->frame(index, c), single->frame(index, c), sizeof(SpectralBin) * key.layout.bins()), 0) << index;
+    }
+    
+    // cancelled: no more slices
+    std::shared_ptr<SpectralAnalysis> cancelled(SpectralAnalysis::create(key, std::string(), reason));
+    AnalysisBuild stopped(source, cancelled, 8);
+    stopped.cancel();
+    EXPECT_EQ(stopped.runSlice(), AnalysisBuild::None);
+    EXPECT_FALSE(cancelled->complete());
+}
+
+// ----- freeze
+
+TEST(TestSignalsmithStretch, FreezeHoldsSpectrum)
+{
+    const double sr = 48000, frequency = 1000;
+    std::shared_ptr<const PlanarSnapshot> source = sineSnapshot(1, 1.0, frequency, sr);
+    const SpectralLayout layout = spectralLayout(0, sr);
+    
+    // two frames a hop apart around the freeze point, as signalsmith_freeze_capture
+    std::vector<REAL> input(layout.fft_size + layout.hop);
+    REAL* input_channels[1] = {input.data()};
+    source->copy(input_channels, (long)(0.5 * sr) - layout.fft_size / 2, (long)input.size());
+    SpectralAnalyser analyser;
+    analyser.setLayout(layout);
+    std::vector<SpectralBin> frames(2 * layout.bins());
+    analyser.analyse(input.data(), frames.data());
+    analyser.analyse(input.data() + layout.hop, frames.data() + layout.bins());
+    
+    SpectralSynth synth;
+    synth.configure(layout, 1);
+    std::vector<REAL> output(6 * 8192);
+    REAL* channels[1] = {output.data()};
+    double position = 0;
+    const SpectralBin* captured = frames.data();
+    const size_t bins = (size_t)layout.bins();
+    synth.render([captured, bins](long index, int) -> const SpectralBin* {
+                     return index == 0 || index == 1 ? captured + (size_t)index * bins : nullptr;
+                 }, position, 0.0, 1.0f, channels, (long)output.size());
+    EXPECT_EQ(position, 0.0);
+    
+    // steady from the first hop on (the overlap-add is primed): level of every hop, pitch of the whole
+    for(size_t first = 0; first + layout.hop <= output.size(); first += layout.hop){
+        double energy = 0;
+        for(size_t i = first; i < first + layout.hop; ++i)
+            energy += output[i] * output[i];
+        ASSERT_NEAR(std::sqrt(energy / layout.hop), 0.5 / std::sqrt(2.0), 0.03) << first;
+    }
+    long crossings = 0;
+    for(size_t i = 1; i < output.size(); ++i)
+        crossings += (output[i - 1] < 0) != (output[i] < 0);
+    EXPECT_NEAR((double)crossings / (2.0 * (double)output.size() / sr), frequency, 10.0);
+}
+
+TEST(TestSignalsmithStretch, FreezeUnfreezeHandOver)
+{
+    const double sr = 48000, frequency = 1000;
+    std::shared_ptr<const PlanarSnapshot> source = sineSnapshot(1, 4.0, frequency, sr);
+    const SpectralLayout layout = spectralLayout(0, sr);
+    const long chunk = OUTPUT_STRETCH_BUFFER_SIZE;
+    
+    signalsmith::stretch::SignalsmithStretch<REAL> stretch;
+    configureStretch(stretch, 1, 0, (float)sr);
+    const long latency = stretch.inputLatency();
+    std::vector<REAL> extracted(chunk + latency), preroll(latency);
+    REAL* extracted_channels[1] = {extracted.data()};
+    REAL* preroll_channels[1] = {preroll.data()};
+    
+    SpectralAnalyser analyser;
+    analyser.setLayout(layout);
+    std::vector<SpectralBin> frames(2 * layout.bins());
+    std::vector<REAL> input(layout.fft_size + layout.hop);
+    REAL* input_channels[1] = {input.data()};
+    SpectralSynth synth;
+    synth.configure(layout, 1);
+    const SpectralBin* captured = frames.data();
+    const size_t bins = (size_t)layout.bins();
+    auto frameAt = [captured, bins](long index, int) -> const SpectralBin* {
+        return index == 0 || index == 1 ? captured + (size_t)index * bins : nullptr;
+    };
+    std::vector<REAL> spectral(chunk);
+    REAL* spectral_channels[1] = {spectral.data()};
+    
+    // as the worker: the stretcher restarts pre-rolled at the position (seek, unfreeze)
+    double position = 0.5 * sr;
+    auto restart = [&](){
+        stretch.reset();
+        source->copy(preroll_channels, (long)position - 2 * latency, latency);
+        stretch.seek(preroll_channels, (int)latency, 1.0);
+    };
+    auto stretchChunk = [&](REAL* out){
+        source->copy(extracted_channels, (long)position - latency, chunk + latency);
+        REAL* outputs[1] = {out};
+        stretch.process(extracted_channels, (int)chunk, outputs, (int)chunk);
+        position += chunk;
+    };
+    auto synthChunk = [&](REAL* out){
+        double frozen = 0;
+        REAL* outputs[1] = {out};
+        synth.render(frameAt, frozen, 0.0, 1.0f, outputs, chunk);
+    };
+    
+    // 3 chunks stretched, freeze (crossfade in), 3 chunks frozen, unfreeze (crossfade out), 3 chunks stretched
+    const long before = 3, frozen = 3, after = 3;
+    const long freeze_chunk = before, unfreeze_chunk = before + 1 + frozen;
+    std::vector<REAL> output((size_t)((before + 1 + frozen + 1 + after) * chunk));
+    restart();
+    for(long k = 0; k * chunk < (long)output.size(); ++k){
+        REAL* out = output.data() + k * chunk;
+        REAL* outputs[1] = {out};
+        if(k == freeze_chunk){
+            // captured at the read position of the chunk, as signalsmith_freeze_capture
+            source->copy(input_channels, (long)position - layout.fft_size / 2, (long)input.size());
+            analyser.analyse(input.data(), frames.data());
+            analyser.analyse(input.data() + layout.hop, frames.data() + layout.bins());
+            stretchChunk(out);
+            synth.reset();
+            synthChunk(spectral.data());
+            spectralCrossfade(outputs, spectral_channels, 1, chunk, true);
+        }
+        else if(k == unfreeze_chunk){
+            restart();
+            stretchChunk(out);
+            synthChunk(spectral.data());
+            spectralCrossfade(outputs, spectral_channels, 1, chunk, false);
+        }
+        else if(k > freeze_chunk && k < unfreeze_chunk){
+            synthChunk(out);
+        }
+        else{
+            stretchChunk(out);
+        }
+    }
+    
+    // reference, out of the hand-over chunks: quietest hop and largest step from one sample to the next
+    auto level = [&](size_t first){
+        double energy = 0;
+        for(size_t i = first; i < first + layout.hop; ++i)
+            energy += output[i] * output[i];
+        return std::sqrt(energy / layout.hop);
+    };
+    auto handOver = [&](size_t i){
+        const long k = (long)(i / chunk);
+        return k == freeze_chunk || k == unfreeze_chunk;
+    };
+    double quietest = std::numeric_limits<double>::max(), steepest = 0;
+    for(size_t first = 0; first + layout.hop <= output.size(); first += layout.hop){
+        if(!handOver(first))
+            quietest = std::min(quietest, level(first));
+    }
+    for(size_t i = 1; i < output.size(); ++i){
+        if(!handOver(i) && !handOver(i - 1))
+            steepest = std::max(steepest, (double)std::abs(output[i] - output[i - 1]));
+    }
+    ASSERT_GT(quietest, 0.0);
+    
+    // the crossfades, from the last chunk before each one to the first chunk after it
+    for(long k : {freeze_chunk, unfreeze_chunk}){
+        for(size_t first = (size_t)((k - 1) * chunk); first < (size_t)((k + 2) * chunk); first += layout.hop)
+            EXPECT_GT(level(first), 0.5 * quietest) << k << " " << first;
+        for(size_t i = (size_t)(k * chunk); i <= (size_t)((k + 1) * chunk); ++i)
+            ASSERT_LE(std::abs(output[i] - output[i - 1]), 1.5 * steepest) << k << " " << i;
+    }
+}
+
+// ----- trace
+
+TEST(TestSignalsmithStretch, TraceDumpChromeJson)
+{
+    Trace::clear();
+    std::thread worker([](){
+        Trace::threadName("worker");
+        for(int i = 0; i < 3; ++i){
+            TraceScope scope("process", 7);
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+        Trace::counter("queue_depth", 512);
+    });
+    worker.join();
+    Trace::instant("reset_request", 7);
+    EXPECT_GE(Trace::recorded(), 5u);   // traced builds: the pool threads record too
+
+    const std::string path = ::testing::TempDir() + "signalsmith_trace.json";
+    ASSERT_TRUE(Trace::dump(path.c_str()));
+    std::ifstream file(path);
+    std::stringstream json;
+    json << file.rdbuf();
+    const std::string text = json.str();
+    std::remove(path.c_str());
+
+    EXPECT_EQ(text.find("{\"displayTimeUnit\":\"ms\",\"traceEvents\":["), 0u);
+    EXPECT_NE(text.find("\"args\":{\"name\":\"worker "), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"process\",\"ph\":\"X\""), std::string::npos);
+    EXPECT_NE(text.find("\"dur\":"), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"queue_depth\",\"ph\":\"C\""), std::string::npos);
+    EXPECT_NE(text.find("\"name\":\"reset_request\",\"ph\":\"i\""), std::string::npos);
+    EXPECT_EQ(text.substr(text.size() - 4), "\n]}\n");
+    Trace::clear();
+}
+
+TEST(TestSignalsmithStretch, TraceRingKeepsNewestEvents)
+{
+    TraceRing ring(4, 0);
+    for(long long i = 0; i < 10; ++i){
+        TraceEvent event;
+        event.name = "event";
+        event.value = i;
+        ring.push(event);
+    }
+    std::vector<TraceEvent> events = ring.snapshot();
+    ASSERT_EQ(events.size(), 4u);
+    for(size_t i = 0; i < events.size(); ++i)
+        EXPECT_EQ(events[i].value, (long long)(6 + i));
+    ring.clear();
+    EXPECT_TRUE(ring.snapshot().empty());
+}
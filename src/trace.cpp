@@ -0,0 +1,167 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+// rings of every thread which has recorded an event, never freed: they are dumped after their thread exits
+struct TraceRegistry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceRing>> rings;
+};
+
+TraceRegistry& registry(){
+    static TraceRegistry instance;
+    return instance;
+}
+
+TraceRing& threadRing(){
+    thread_local TraceRing* ring = nullptr;
+    if(!ring){
+        TraceRegistry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        r.rings.emplace_back(new TraceRing(Trace::RING_SIZE, r.rings.size()));
+        ring = r.rings.back().get();
+    }
+    return *ring;
+}
+
+void writeEvent(FILE* file, const TraceEvent& event, size_t tid, bool& first){
+    fprintf(file, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f",
+            first ? "" : ",", event.name, event.phase, tid, (double)event.begin_ns * 1e-3);
+    if(event.phase == 'X')
+        fprintf(file, ",\"dur\":%.3f,\"args\":{\"id\":%lld}}", (double)event.duration_ns * 1e-3, event.value);
+    else if(event.phase == 'C')
+        fprintf(file, ",\"args\":{\"value\":%lld}}", event.value);
+    else
+        fprintf(file, ",\"s\":\"t\",\"args\":{\"id\":%lld}}", event.value);
+    first = false;
+}
+
+}
+
+TraceRing::TraceRing(size_t capacity, size_t threadIndex) : index(threadIndex) {
+    size_t size = 1;
+    while(size < capacity)
+        size <<= 1;
+    events.resize(size);
+}
+
+std::vector<TraceEvent> TraceRing::snapshot() const {
+    const size_t end = written.load(std::memory_order_acquire);
+    const size_t begin = std::max(end > events.size() ? end - events.size() : 0, cleared.load(std::memory_order_acquire));
+    std::vector<TraceEvent> copy;
+    if(begin >= end)
+        return copy;
+    copy.reserve(end - begin);
+    for(size_t i = begin; i < end; ++i)
+        copy.push_back(events[i & (events.size() - 1)]);
+    // drop what has been overwritten while copying
+    const size_t after = written.load(std::memory_order_acquire);
+    const size_t overwritten = after > events.size() ? after - events.size() : 0;
+    if(overwritten > begin)
+        copy.erase(copy.begin(), copy.begin() + (std::ptrdiff_t)std::min(overwritten - begin, copy.size()));
+    return copy;
+}
+
+long long Trace::now(){
+    return (long long)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Trace::complete(const char* name, long long begin_ns, long long end_ns, long long id){
+    TraceEvent event;
+    event.name = name;
+    event.begin_ns = begin_ns;
+    event.duration_ns = end_ns - begin_ns;
+    event.value = id;
+    event.phase = 'X';
+    threadRing().push(event);
+}
+
+void Trace::instant(const char* name, long long id){
+    TraceEvent event;
+    event.name = name;
+    event.begin_ns = now();
+    event.value = id;
+    event.phase = 'i';
+    threadRing().push(event);
+}
+
+void Trace::counter(const char* name, long long value){
+    TraceEvent event;
+    event.name = name;
+    event.begin_ns = now();
+    event.value = value;
+    event.phase = 'C';
+    threadRing().push(event);
+}
+
+void Trace::threadName(const char* name){
+    threadRing().name.store(name, std::memory_order_relaxed);
+}
+
+bool Trace::dump(const char* path){
+    FILE* file = fopen(path, "w");
+    if(!file)
+        return false;
+    
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    bool first = true;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    for(const auto& ring : r.rings){
+        const char* name = ring->name.load(std::memory_order_relaxed);
+        fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",
+                first ? "" : ",", ring->index, name ? name : "thread", ring->index);
+        first = false;
+        for(const TraceEvent& event : ring->snapshot())
+            writeEvent(file, event, ring->index, first);
+    }
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+size_t Trace::recorded(){
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    size_t count = 0;
+    for(const auto& ring : r.rings)
+        count += ring->snapshot().size();
+    return count;
+}
+
+void Trace::clear(){
+    TraceRegistry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for(auto& ring : r.rings)
+        ring->clear();
+}
@@ -0,0 +1,124 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef trace_hpp
+#define trace_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/**
+ Timeline of the worker and audio threads, dumped as a Chrome trace (chrome://tracing, ui.perfetto.dev).
+
+ Recording is compiled in with SIGNALSMITH_TRACE=1 (cmake -DSIGNALSMITH_TRACE=ON), the TRACE_* macros
+ expand to nothing otherwise. Every thread writes to its own ring, lock-free: the oldest events are overwritten.
+ The first event of a thread allocates its ring. Names must be string literals.
+ */
+struct TraceEvent {
+    const char* name = nullptr;
+    long long begin_ns = 0;
+    long long duration_ns = 0;      // complete events
+    long long value = 0;            // id (instance) of complete and instant events, value of counters
+    char phase = 'X';               // X: complete, i: instant, C: counter
+};
+
+class TraceRing {
+public:
+    explicit TraceRing(size_t capacity, size_t threadIndex);
+
+    // owning thread only
+    void push(const TraceEvent& event){
+        const size_t w = written.load(std::memory_order_relaxed);
+        events[w & (events.size() - 1)] = event;
+        written.store(w + 1, std::memory_order_release);
+    }
+
+    // any thread: the events still in the ring, oldest first (events written meanwhile may be missed)
+    std::vector<TraceEvent> snapshot() const;
+
+    // any thread: forget the events written so far
+    void clear(){
+        cleared.store(written.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    std::atomic<const char*> name{nullptr};
+    const size_t index;
+
+private:
+    std::vector<TraceEvent> events;
+    std::atomic<size_t> written{0};
+    std::atomic<size_t> cleared{0};     // events before are not dumped
+};
+
+struct Trace {
+    static constexpr size_t RING_SIZE = 1 << 14;    // events per thread
+
+    static long long now();
+    static void complete(const char* name, long long begin_ns, long long end_ns, long long id);
+    static void instant(const char* name, long long id);
+    static void counter(const char* name, long long value);
+    static void threadName(const char* name);
+
+    /**
+     Write the events of every thread to a Chrome trace JSON file.
+     - Returns: false if the file cannot be written
+     */
+    static bool dump(const char* path);
+
+    // number of events held by the rings of every thread
+    static size_t recorded();
+    // drop every recorded event
+    static void clear();
+};
+
+class TraceScope {
+public:
+    TraceScope(const char* name, long long id) : name(name), id(id), begin(Trace::now()) {}
+    ~TraceScope(){ Trace::complete(name, begin, Trace::now(), id); }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    long long id;
+    long long begin;
+};
+
+#if SIGNALSMITH_TRACE
+    #define TRACE_CONCAT_(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+    #define TRACE_SCOPE(name, id) TraceScope TRACE_CONCAT(trace_scope_, __LINE__)(name, (long long)(id))
+    #define TRACE_INSTANT(name, id) Trace::instant(name, (long long)(id))
+    #define TRACE_COUNTER(name, value) Trace::counter(name, (long long)(value))
+    #define TRACE_THREAD(name) Trace::threadName(name)
+#else
+    #define TRACE_SCOPE(name, id) ((void)0)
+    #define TRACE_INSTANT(name, id) ((void)0)
+    #define TRACE_COUNTER(name, value) ((void)0)
+    #define TRACE_THREAD(name) ((void)0)
+#endif
+
+#endif /* trace_hpp */
@@ -0,0 +1,168 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#include "worker_pool.hpp"
+
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t numWorkers){
+    numWorkers = std::max<size_t>(numWorkers, 1);
+    for(size_t i = 0; i < numWorkers; ++i)
+        workers.emplace_back(new Worker());
+    for(size_t i = 0; i < numWorkers; ++i)
+        workers[i]->thread = std::thread(&WorkerPool::workerLoop, this, i);
+}
+
+WorkerPool::~WorkerPool(){
+    shutdown();
+}
+
+WorkerPool& WorkerPool::shared(){
+    // never destroyed: threads are stopped by shutdown() when the host quits
+    static WorkerPool* pool = new WorkerPool();
+    return *pool;
+}
+
+size_t WorkerPool::defaultSize(){
+    // leave a core to the audio thread
+    unsigned int cores = std::thread::hardware_concurrency();
+    return cores > 1 ? cores - 1 : 1;
+}
+
+void WorkerPool::add(PoolJob* job){
+    job->state = PoolJob::Idle;
+    job->home = next_home++ % workers.size();
+    Worker& worker = *workers[job->home];
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    worker.jobs.push_back(job);
+}
+
+void WorkerPool::remove(PoolJob* job){
+    Worker& worker = *workers[job->home];
+    {
+        // jobs are claimed under this lock: once removed, nobody can start it again
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.jobs.erase(std::remove(worker.jobs.begin(), worker.jobs.end(), job), worker.jobs.end());
+    }
+    int state = job->state.load();
+    while(state == PoolJob::Running || state == PoolJob::Requeued){
+        std::this_thread::yield();
+        state = job->state.load();
+    }
+    job->state = PoolJob::Idle;
+}
+
+void WorkerPool::shutdown(){
+    stopping = true;
+    wakeup.signal((int)workers.size());
+    for(auto& worker : workers){
+        if(worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+bool WorkerPool::submit(PoolJob* job){
+    int state = job->state.load();
+    int target;
+    do{
+        if(state == PoolJob::Queued || state == PoolJob::Requeued)
+            return false;
+        target = state == PoolJob::Idle ? PoolJob::Queued : PoolJob::Requeued;
+    }while(!job->state.compare_exchange_weak(state, target));
+
+    // no syscall unless a worker sleeps
+    if(target == PoolJob::Queued && sleeping.load() > 0)
+        wakeup.signal();
+    return true;
+}
+
+bool WorkerPool::runIfQueued(PoolJob* job){
+    int expected = PoolJob::Queued;
+    if(!job->state.compare_exchange_strong(expected, PoolJob::Running))
+        return false;
+
+    job->run();
+
+    int state = PoolJob::Running;
+    if(!job->state.compare_exchange_strong(state, PoolJob::Idle)){
+        // submitted again while running: hand it back to the workers
+        job->state = PoolJob::Queued;
+        if(sleeping.load() > 0)
+            wakeup.signal();
+    }
+    return true;
+}
+
+PoolJob* WorkerPool::claim(Worker& worker){
+    std::lock_guard<std::mutex> lock(worker.mutex);
+    PoolJob* best = nullptr;
+    float best_urgency = 0;
+    for(PoolJob* job : worker.jobs){
+        if(job->state.load() != PoolJob::Queued)
+            continue;
+        float urgency = job->urgency ? job->urgency() : 0.0f;
+        if(!best || urgency > best_urgency){
+            best = job;
+            best_urgency = urgency;
+        }
+    }
+    if(best){
+        int expected = PoolJob::Queued;
+        if(best->state.compare_exchange_strong(expected, PoolJob::Running))
+            return best;
+    }
+    return nullptr;
+}
+
+void WorkerPool::workerLoop(size_t index){
+    TRACE_THREAD("worker");
+    while(!stopping){
+        // own jobs first, then steal from the other workers
+        PoolJob* job = nullptr;
+        for(size_t i = 0; i < workers.size() && !job; ++i)
+            job = claim(*workers[(index + i) % workers.size()]);
+
+        if(!job){
+            // announce the sleep, then look again: a submitter either sees
+            // the sleeping worker and signals, or its job is found here
+            sleeping++;
+            for(size_t i = 0; i < workers.size() && !job && !stopping; ++i)
+                job = claim(*workers[(index + i) % workers.size()]);
+            if(!job && !stopping)
+                wakeup.wait();
+            sleeping--;
+            if(!job)
+                continue;
+        }
+
+        job->run();
+
+        int state = PoolJob::Running;
+        if(!job->state.compare_exchange_strong(state, PoolJob::Idle)){
+            // submitted again while running
+            job->state = PoolJob::Queued;
+        }
+    }
+}
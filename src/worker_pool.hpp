@@ -0,0 +1,112 @@
+/**
+ MIT License
+
+ Copyright (c) 2025 Alex Bouvier.
+
+ Permission is hereby granted, free of charge, to any person obtaining a copy
+ of this software and associated documentation files (the "Software"), to deal
+ in the Software without restriction, including without limitation the rights
+ to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ copies of the Software, and to permit persons to whom the Software is
+ furnished to do so, subject to the following conditions:
+
+ The above copyright notice and this permission notice shall be included in all
+ copies or substantial portions of the Software.
+
+ THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ SOFTWARE.
+ */
+
+
+#ifndef worker_pool_hpp
+#define worker_pool_hpp
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "semaphore.hpp"
+
+/**
+ Job run by a WorkerPool.
+
+ A job is registered once (add), then submitted any number of times (submit).
+ Submitting a job that is already queued does nothing, submitting a running job runs it once more.
+ */
+struct PoolJob {
+    PoolJob(std::function<void()> run_fn, std::function<float()> urgency_fn = nullptr)
+    : run(std::move(run_fn)), urgency(std::move(urgency_fn)) {}
+
+    std::function<void()> run;
+    std::function<float()> urgency;     // higher runs first, e.g. how close a queue is to running dry
+
+private:
+    friend class WorkerPool;
+    enum State { Idle, Queued, Running, Requeued };
+    std::atomic_int state{Idle};
+    size_t home = 0;                    // worker owning the job
+};
+
+/**
+ Process-wide pool of render threads shared by every instance.
+
+ Each worker owns a list of jobs and runs its most urgent queued job,
+ an idle worker steals the most urgent queued job of the other workers.
+ Threads are only created by the constructor and joined by shutdown().
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(size_t numWorkers = defaultSize());
+    ~WorkerPool();
+
+    static WorkerPool& shared();
+    static size_t defaultSize();
+
+    size_t size() const { return workers.size(); }
+
+    // not realtime safe
+    void add(PoolJob* job);
+    void remove(PoolJob* job);      // waits for the job to finish if running
+    void shutdown();
+
+    // lock-free, can be called from the audio thread
+    bool submit(PoolJob* job);
+
+    /**
+     Run a queued job on the calling thread instead of waiting for a worker to pick it up.
+     Used by fork-join renders: the caller helps with the parts nobody has started yet.
+     - Returns: false if the job was not queued (idle, or already running elsewhere)
+     */
+    bool runIfQueued(PoolJob* job);
+
+    // number of submissions which had to wake a sleeping worker
+    unsigned long long wakeupSyscalls() const { return wakeup.syscalls(); }
+
+private:
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;           // protects jobs
+        std::vector<PoolJob*> jobs;
+    };
+
+    void workerLoop(size_t index);
+    PoolJob* claim(Worker& worker);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<size_t> next_home{0};
+    std::atomic_bool stopping{false};
+
+    std::atomic_int sleeping{0};         // workers about to sleep or sleeping
+    Semaphore wakeup;
+};
+
+#endif /* worker_pool_hpp */